@@ -0,0 +1,113 @@
+#include "vfspp/VFS.h"
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+
+
+using namespace vfspp;
+
+namespace
+{
+
+using MemoryFS = BasicMemoryFileSystem<SingleThreadedPolicy>;
+using DynamicVFS = BasicVirtualFileSystem<SingleThreadedPolicy>;
+using StaticVFS = BasicStaticVirtualFileSystem<SingleThreadedPolicy, MemoryFS>;
+
+constexpr size_t kFilesPerMount = 1000;
+constexpr size_t kLookups = 1000000;
+const char* const kAliases[] = { "/", "/data/", "/data/levels/", "/patch/" };
+
+std::shared_ptr<MemoryFS> CreateMount(const std::string& alias)
+{
+    auto fs = std::make_shared<MemoryFS>(alias);
+    if (!fs->Initialize()) {
+        return nullptr;
+    }
+
+    const std::string content = "file content";
+    for (size_t i = 0; i < kFilesPerMount; ++i) {
+        if (IFilePtr file = fs->OpenFile(alias + "file" + std::to_string(i) + ".bin", IFile::FileMode::ReadWrite)) {
+            file->Write(std::span<const uint8_t>(reinterpret_cast<const uint8_t*>(content.data()), content.size()));
+            file->Close();
+        }
+    }
+    return fs;
+}
+
+template<typename Func>
+void Measure(const char* name, Func&& func)
+{
+    const auto start = std::chrono::steady_clock::now();
+    const uint64_t checksum = func();
+    const auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    std::printf("%-32s %8.1f ns/op (checksum %llu)\n", name, elapsed / kLookups, static_cast<unsigned long long>(checksum));
+}
+
+template<typename VFS>
+void Run(const char* name, VFS& vfs, const std::vector<std::string>& paths)
+{
+    std::printf("%s:\n", name);
+
+    Measure("  IsFileExists", [&] {
+        uint64_t found = 0;
+        for (size_t i = 0; i < kLookups; ++i) {
+            found += vfs.IsFileExists(paths[i % paths.size()]) ? 1 : 0;
+        }
+        return found;
+    });
+
+    Measure("  Stat", [&] {
+        uint64_t size = 0;
+        for (size_t i = 0; i < kLookups; ++i) {
+            if (auto stat = vfs.Stat(paths[i % paths.size()])) {
+                size += stat->Size;
+            }
+        }
+        return size;
+    });
+
+    Measure("  ReadAll", [&] {
+        uint64_t size = 0;
+        for (size_t i = 0; i < kLookups; ++i) {
+            if (auto buffer = vfs.ReadAll(paths[i % paths.size()])) {
+                size += buffer->Size();
+            }
+        }
+        return size;
+    });
+}
+
+} // namespace
+
+int main()
+{
+    DynamicVFS dynamicVfs;
+    StaticVFS staticVfs;
+
+    for (const char* alias : kAliases) {
+        auto fs = CreateMount(alias);
+        if (!fs) {
+            std::fprintf(stderr, "Failed to create memory filesystem\n");
+            return 1;
+        }
+        dynamicVfs.AddFileSystem(Alias(alias), fs);
+        staticVfs.AddFileSystem(Alias(alias), fs);
+    }
+
+    // Mix of hits in every mount and misses, shuffled to defeat branch prediction
+    std::vector<std::string> paths;
+    for (const char* alias : kAliases) {
+        for (size_t i = 0; i < kFilesPerMount; i += 10) {
+            paths.push_back(std::string(alias) + "file" + std::to_string(i) + ".bin");
+            paths.push_back(std::string(alias) + "missing" + std::to_string(i) + ".bin");
+        }
+    }
+    std::shuffle(paths.begin(), paths.end(), std::mt19937(42));
+
+    Run("VirtualFileSystem", dynamicVfs, paths);
+    Run("StaticVirtualFileSystem", staticVfs, paths);
+
+    return 0;
+}
@@ -2,6 +2,7 @@
 #define VFSPP_ALIAS_HPP
 
 #include "Global.h"
+#include "PathNormalizer.hpp"
 #include <string_view>
 
 namespace vfspp
@@ -80,35 +81,15 @@ inline bool Alias::operator!=(const Alias& other) const noexcept
 
 inline std::string Alias::Normalize(std::string_view alias)
 {
-    std::string normalized(alias);
-
     const char* whitespace = " \t\n\r";
-    size_t begin = normalized.find_first_not_of(whitespace);
-    if (begin == std::string::npos) {
-        normalized.clear();
-    } else if (begin > 0) {
-        normalized.erase(0, begin);
-    }
-
-    if (!normalized.empty()) {
-        size_t end = normalized.find_last_not_of(whitespace);
-        if (end != std::string::npos && end + 1 < normalized.size()) {
-            normalized.erase(end + 1);
-        }
-    }
-
-    if (normalized.empty()) {
-        normalized = "/";
-    }
-
-    if (normalized.front() != '/') {
-        normalized.insert(normalized.begin(), '/');
-    }
-
-    while (normalized.size() > 1 && normalized.back() == '/') {
-        normalized.pop_back();
+    const size_t begin = alias.find_first_not_of(whitespace);
+    if (begin == std::string_view::npos) {
+        return "/";
     }
+    alias = alias.substr(begin, alias.find_last_not_of(whitespace) - begin + 1);
 
+    // Alias going above root is mounted to root
+    std::string normalized = PathNormalizer::Normalize(alias).value_or("/");
     if (normalized.back() != '/') {
         normalized.push_back('/');
     }
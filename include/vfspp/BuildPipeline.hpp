@@ -0,0 +1,125 @@
+#ifndef VFSPP_BUILDPIPELINE_HPP
+#define VFSPP_BUILDPIPELINE_HPP
+
+#include "VirtualFileSystem.hpp"
+#include "ThreadPoolExecutor.hpp"
+
+namespace vfspp
+{
+
+/*
+ * Settings shared by builders processing files of virtual filesystem in batches
+ */
+struct BuildPipelineOptions
+{
+    // Executor processing files, builder creates own thread pool when not set
+    ExecutorPtr Executor;
+
+    // Number of threads of own thread pool, 0 uses all hardware threads
+    uint32_t ThreadCount = 0;
+
+    // Maximum number of files read and processed before they are written
+    size_t MaxFilesInFlight = 64;
+};
+
+
+/*
+ * File read by build pipeline
+ */
+struct BuildFile
+{
+    std::string Name; // Path relative to virtual root
+    FileStat Stat;
+    FileBuffer Data;
+};
+
+
+/*
+ * Files are read by calling thread in sorted order, batch of files is processed by
+ * ParallelFor on executor and then written by calling thread in same order, so output
+ * is identical regardless of thread count. Exception thrown by processing is rethrown
+ */
+class BuildPipeline final
+{
+public:
+    /*
+     * Get sorted virtual paths of files under root, root is matched with case mode of
+     * virtual filesystem
+     */
+    template<typename Policy>
+    [[nodiscard]]
+    static std::vector<std::string> ListFiles(const BasicVirtualFileSystem<Policy>& vfs, const Alias& root)
+    {
+        const bool isCaseSensitive = vfs.IsCaseSensitive();
+
+        std::vector<std::string> files;
+        for (auto& virtualPath : vfs.ListAllFiles()) {
+            if (isCaseSensitive ? virtualPath.starts_with(root.View()) : PathNormalizer::StartsWithFolded(virtualPath, root.View())) {
+                files.push_back(std::move(virtualPath));
+            }
+        }
+        return files;
+    }
+
+    /*
+     * Run files listed by ListFiles through pipeline. Job must have BuildFile member File,
+     * process is called concurrently for jobs of batch, write returns false to stop build
+     */
+    template<typename Job, typename Policy, typename Process, typename Write>
+    [[nodiscard]]
+    static bool Run(BasicVirtualFileSystem<Policy>& vfs, const Alias& root, const std::vector<std::string>& files, const BuildPipelineOptions& options, Process&& process, Write&& write)
+    {
+        ExecutorPtr executor = options.Executor;
+        if (!executor) {
+            executor = std::make_shared<ThreadPoolExecutor>(options.ThreadCount);
+        }
+
+        const size_t batchSize = std::max<size_t>(1, options.MaxFilesInFlight);
+        std::vector<Job> jobs;
+        jobs.reserve(std::min(batchSize, files.size()));
+
+        for (size_t first = 0; first < files.size(); first += batchSize) {
+            const size_t count = std::min(batchSize, files.size() - first);
+            jobs.clear();
+            jobs.resize(count);
+
+            for (size_t i = 0; i < count; i++) {
+                if (!ReadFile(vfs, root, files[first + i], jobs[i].File)) {
+                    return false;
+                }
+            }
+
+            ParallelFor(executor.get(), count, [&](size_t index) {
+                process(jobs[index]);
+            });
+
+            for (Job& job : jobs) {
+                if (!write(job)) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+private:
+    // Mapped files are referenced without copying
+    template<typename Policy>
+    static bool ReadFile(BasicVirtualFileSystem<Policy>& vfs, const Alias& root, const std::string& virtualPath, BuildFile& file)
+    {
+        auto stat = vfs.Stat(virtualPath);
+        auto data = vfs.ReadAll(virtualPath);
+        if (!stat || !data || data->Size() != stat->Size) {
+            return false;
+        }
+
+        file.Name = virtualPath.substr(root.Length());
+        file.Stat = std::move(*stat);
+        file.Data = std::move(*data);
+        return true;
+    }
+};
+
+} // namespace vfspp
+
+#endif // VFSPP_BUILDPIPELINE_HPP
@@ -0,0 +1,710 @@
+#ifndef VFSPP_CACHINGFILESYSTEM_HPP
+#define VFSPP_CACHINGFILESYSTEM_HPP
+
+#include "IFileSystem.h"
+#include "Alias.hpp"
+#include "FileIndex.hpp"
+#include "FileTransfer.hpp"
+#include "Global.h"
+#include "ThreadingPolicy.hpp"
+
+#include <future>
+
+namespace vfspp
+{
+
+template<typename Policy>
+class BasicCachingFileSystem;
+
+using CachingFileSystem = BasicCachingFileSystem<ThreadingPolicy>;
+using CachingFileSystemPtr = std::shared_ptr<CachingFileSystem>;
+using CachingFileSystemWeakPtr = std::weak_ptr<CachingFileSystem>;
+
+
+/*
+ * Cache limits
+ */
+struct CacheOptions
+{
+    // Total size of cached files, least recently used files are evicted, 0 is unlimited
+    uint64_t Capacity = 0;
+
+    // Larger files are read from source directly, 0 caches files of any size
+    uint64_t MaxFileSize = 0;
+};
+
+
+/*
+ * Read-through cache of slow filesystem, e.g. network share, in fast one, e.g. memory or
+ * local native directory. Whole files are copied to cache on first read. Cached file is
+ * used while size and modification time reported by source Stat match ones recorded
+ * when file was cached, files without modification time are validated by size only.
+ * Cache content is recorded in ".vfspp-cache" manifest of cache, so native cache is
+ * reused between runs. Files are copied to cache without holding filesystem lock, readers
+ * of file being copied wait for that copy. Files opened from cache aren't evicted until
+ * closed. Filesystem is read-only, calls are synchronized by Policy
+ */
+template<typename Policy>
+class BasicCachingFileSystem final : public IFileSystem
+{
+public:
+    /*
+     * Source and cache must be created with same alias as caching filesystem, they are
+     * initialized with it if needed
+     */
+    BasicCachingFileSystem(const std::string& aliasPath, IFileSystemPtr source, IFileSystemPtr cache, CacheOptions options = {})
+        : m_AliasPath(aliasPath)
+        , m_Source(std::move(source))
+        , m_Cache(std::move(cache))
+        , m_Options(options)
+        , m_ManifestPath(Alias(aliasPath).String() + ".vfspp-cache")
+    {
+    }
+
+    ~BasicCachingFileSystem()
+    {
+        Shutdown();
+    }
+
+    /*
+     * Initialize filesystem, call this method as soon as possible
+     */
+    [[nodiscard]]
+    virtual bool Initialize() override
+    {
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
+        return InitializeImpl();
+    }
+
+    /*
+     * Shutdown filesystem, source and cache
+     */
+    virtual void Shutdown() override
+    {
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
+        ShutdownImpl();
+    }
+
+    /*
+     * Set executor for parallel work of source and cache
+     */
+    virtual void SetExecutor(ExecutorPtr executor) override
+    {
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
+        if (m_Source && m_Cache) {
+            m_Source->SetExecutor(executor);
+            m_Cache->SetExecutor(executor);
+        }
+    }
+
+    /*
+     * Switch case sensitivity of file lookups of source and cache, if any of them fails
+     * all keep previous mode
+     */
+    virtual bool SetCaseSensitive(bool isCaseSensitive) override
+    {
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
+        if (!m_Source || !m_Cache) {
+            return m_Entries.SetCaseSensitive(isCaseSensitive);
+        }
+
+        // Switching back to previous mode can't fail, only folding finds collisions
+        const bool wasCaseSensitive = m_Entries.IsCaseSensitive();
+        if (!m_Entries.SetCaseSensitive(isCaseSensitive)) {
+            return false;
+        }
+        if (!m_Source->SetCaseSensitive(isCaseSensitive)) {
+            m_Entries.SetCaseSensitive(wasCaseSensitive);
+            return false;
+        }
+        if (!m_Cache->SetCaseSensitive(isCaseSensitive)) {
+            m_Source->SetCaseSensitive(wasCaseSensitive);
+            m_Entries.SetCaseSensitive(wasCaseSensitive);
+            return false;
+        }
+        return true;
+    }
+
+    /*
+     * Check if file lookups are case sensitive
+     */
+    [[nodiscard]]
+    virtual bool IsCaseSensitive() const override
+    {
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
+        return m_Entries.IsCaseSensitive();
+    }
+
+    /*
+     * Check if filesystem is initialized
+     */
+    [[nodiscard]]
+    virtual bool IsInitialized() const override
+    {
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
+        return m_IsInitialized;
+    }
+
+    /*
+     * Get base path of source
+     */
+    [[nodiscard]]
+    virtual const std::string& BasePath() const override
+    {
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
+        return m_Source ? m_Source->BasePath() : m_AliasPath;
+    }
+
+    /*
+     * Get mounted path
+     */
+    [[nodiscard]]
+    virtual const std::string& VirtualPath() const override
+    {
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
+        return m_AliasPath;
+    }
+
+    /*
+     * Retrieve all files of source. Heavy operation, avoid calling this often
+     */
+    [[nodiscard]]
+    virtual FilesList GetFilesList() const override
+    {
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
+        return m_IsInitialized ? m_Source->GetFilesList() : FilesList();
+    }
+
+    /*
+     * Call visitor for each file of source, stops when visitor returns false
+     */
+    virtual void ForEachFile(const FileVisitor& visitor) const override
+    {
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
+        if (m_IsInitialized) {
+            m_Source->ForEachFile(visitor);
+        }
+    }
+
+    /*
+     * List files and directories of directory in source, paths of directories end with '/'
+     */
+    [[nodiscard]]
+    virtual std::vector<std::string> ListDirectory(const std::string& virtualPath, bool recursive = false) const override
+    {
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
+        return m_IsInitialized ? m_Source->ListDirectory(virtualPath, recursive) : std::vector<std::string>();
+    }
+
+    /*
+     * Find files of source matching pattern. Returns sorted virtual paths
+     */
+    [[nodiscard]]
+    virtual std::vector<std::string> FindFiles(const GlobPattern& pattern) const override
+    {
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
+        return m_IsInitialized ? m_Source->FindFiles(pattern) : std::vector<std::string>();
+    }
+
+    /*
+     * Caching filesystem is readonly
+     */
+    [[nodiscard]]
+    virtual bool IsReadOnly() const override
+    {
+        return true;
+    }
+
+    /*
+     * Open file for reading from cache, file is cached first if it's missing or outdated.
+     * File that can't be cached is opened from source
+     */
+    virtual IFilePtr OpenFile(const std::string& virtualPath, IFile::FileMode mode) override
+    {
+        if (IFile::ModeHasFlag(mode, IFile::FileMode::Write)) {
+            return nullptr;
+        }
+
+        return ReadThrough(virtualPath, [&](IFileSystem& fs) -> IFilePtr {
+            return fs.OpenFile(virtualPath, mode);
+        });
+    }
+
+    /*
+     * Close file
+     */
+    virtual bool CloseFile(IFilePtr file) override
+    {
+        if (!file) {
+            return false;
+        }
+
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
+        const bool isCached = IsOpenedFromCacheImpl(*file);
+        if (m_IsInitialized) {
+            return (isCached ? m_Cache : m_Source)->CloseFile(file);
+        }
+        return file->Close();
+    }
+
+    /*
+     * Not supported by readonly filesystem
+     */
+    virtual IFilePtr CreateFile(const std::string& /*virtualPath*/) override
+    {
+        return nullptr;
+    }
+
+    /*
+     * Not supported by readonly filesystem
+     */
+    virtual bool RemoveFile(const std::string& /*virtualPath*/) override
+    {
+        return false;
+    }
+
+    /*
+     * Not supported by readonly filesystem
+     */
+    virtual bool CopyFile(const std::string& /*srcVirtualPath*/, const std::string& /*dstVirtualPath*/, bool /*overwrite*/ = false) override
+    {
+        return false;
+    }
+
+    /*
+     * Not supported by readonly filesystem
+     */
+    virtual bool RenameFile(const std::string& /*srcVirtualPath*/, const std::string& /*dstVirtualPath*/) override
+    {
+        return false;
+    }
+
+    /*
+     * Check if file exists in source
+     */
+    [[nodiscard]]
+    virtual bool IsFileExists(const std::string& virtualPath) const override
+    {
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
+        return m_IsInitialized && m_Source->IsFileExists(virtualPath);
+    }
+
+    /*
+     * Get file metadata from source
+     */
+    [[nodiscard]]
+    virtual std::optional<FileStat> Stat(const std::string& virtualPath) const override
+    {
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
+        return m_IsInitialized ? m_Source->Stat(virtualPath) : std::nullopt;
+    }
+
+    /*
+     * Read whole file from cache, file is cached first if it's missing or outdated
+     */
+    [[nodiscard]]
+    virtual std::optional<FileBuffer> ReadAll(const std::string& virtualPath) const override
+    {
+        return ReadThrough(virtualPath, [&](IFileSystem& fs) {
+            return fs.ReadAll(virtualPath);
+        });
+    }
+
+    /*
+     * Get total size of cached files, including files being copied to cache
+     */
+    [[nodiscard]]
+    uint64_t CachedSize() const
+    {
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
+        return m_CachedSize;
+    }
+
+    /*
+     * Remove all files from cache, except opened and currently copied ones
+     */
+    void Clear()
+    {
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
+        if (!m_IsInitialized) {
+            return;
+        }
+
+        for (auto recent = m_RecentFiles.begin(); recent != m_RecentFiles.end();) {
+            const auto it = m_Entries.find(*recent++);
+            if (!IsPinnedImpl(it->second)) {
+                EvictImpl(it);
+            }
+        }
+        WriteManifestImpl();
+    }
+
+private:
+    struct CacheEntry
+    {
+        uint64_t Size;
+        std::time_t ModifiedTime;
+        std::list<std::string>::iterator Recent;
+        std::shared_future<bool> Copy; // Valid while file is copied to cache
+        uint64_t CopyId = 0;
+        std::vector<std::weak_ptr<IFile>> OpenedFiles; // Files opened from cache pin entry
+    };
+
+    inline bool InitializeImpl()
+    {
+        if (m_IsInitialized) {
+            return true;
+        }
+
+        if (!m_Source || !m_Cache) {
+            return false;
+        }
+
+        // Cached files have same virtual paths as source ones
+        const Alias alias(m_AliasPath);
+        if (Alias(m_Source->VirtualPath()) != alias || Alias(m_Cache->VirtualPath()) != alias) {
+            return false;
+        }
+
+        if ((!m_Source->IsInitialized() && !m_Source->Initialize()) || (!m_Cache->IsInitialized() && !m_Cache->Initialize())) {
+            return false;
+        }
+
+        if (m_Cache->IsReadOnly()) {
+            return false;
+        }
+
+        LoadManifestImpl();
+        m_IsInitialized = true;
+        return true;
+    }
+
+    inline void ShutdownImpl()
+    {
+        if (!m_IsInitialized) {
+            return;
+        }
+
+        m_Source->Shutdown();
+        m_Cache->Shutdown();
+        m_Entries.clear();
+        m_RecentFiles.clear();
+        m_CachedSize = 0;
+        m_IsInitialized = false;
+    }
+
+    // Open or read file from cache if it's valid, cache file otherwise. Cached files are
+    // read under shared lock. Missing file is reserved in cache under exclusive lock and
+    // copied without lock, concurrent readers of same file wait for that copy
+    template<typename Reader>
+    auto ReadThrough(const std::string& virtualPath, Reader&& reader) const -> std::invoke_result_t<Reader, IFileSystem&>
+    {
+        std::optional<FileStat> stat;
+        {
+            [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
+            if (!m_IsInitialized || virtualPath == m_ManifestPath) {
+                return {};
+            }
+
+            stat = m_Source->Stat(virtualPath);
+            if (!stat) {
+                return {};
+            }
+
+            if (auto result = ReadCachedImpl(virtualPath, *stat, reader)) {
+                return result;
+            }
+
+            if (!IsCacheableImpl(*stat)) {
+                return reader(*m_Source);
+            }
+        }
+
+        std::promise<bool> promise;
+        std::shared_future<bool> copy;
+        uint64_t copyId = 0;
+        {
+            [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
+            if (!m_IsInitialized) {
+                return {};
+            }
+
+            // Other reader could cache file meanwhile or be copying it now
+            if (auto result = ReadCachedImpl(virtualPath, *stat, reader)) {
+                return result;
+            }
+
+            const auto it = m_Entries.find(virtualPath);
+            if (it != m_Entries.end() && it->second.Copy.valid()) {
+                copy = it->second.Copy;
+            } else if (ReserveImpl(virtualPath, *stat, promise.get_future().share())) {
+                copyId = m_CopyCounter;
+            }
+        }
+
+        if (copyId != 0) {
+            bool isCopied = false;
+            try {
+                isCopied = CopyToCache(virtualPath);
+            } catch (...) {
+                FinishCopy(virtualPath, copyId, false);
+                promise.set_value(false);
+                throw;
+            }
+            FinishCopy(virtualPath, copyId, isCopied);
+            promise.set_value(isCopied);
+        } else if (copy.valid()) {
+            copy.wait();
+        }
+
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
+        if (!m_IsInitialized) {
+            return {};
+        }
+
+        if (auto result = ReadCachedImpl(virtualPath, *stat, reader)) {
+            return result;
+        }
+        return reader(*m_Source);
+    }
+
+    // Read file from cache if cached copy matches source, file opened from cache pins entry
+    template<typename Reader>
+    auto ReadCachedImpl(const std::string& virtualPath, const FileStat& stat, Reader& reader) const -> std::invoke_result_t<Reader, IFileSystem&>
+    {
+        const auto it = m_Entries.find(virtualPath);
+        if (it == m_Entries.end()) {
+            return {};
+        }
+
+        CacheEntry& entry = it->second;
+        if (entry.Copy.valid() || entry.Size != stat.Size || entry.ModifiedTime != stat.ModifiedTime) {
+            return {};
+        }
+
+        auto result = reader(*m_Cache);
+        if (result) {
+            [[maybe_unused]] auto lock = Policy::Lock(m_UseMutex);
+            m_RecentFiles.splice(m_RecentFiles.begin(), m_RecentFiles, entry.Recent);
+            if constexpr (std::is_same_v<decltype(result), IFilePtr>) {
+                std::erase_if(entry.OpenedFiles, [](const std::weak_ptr<IFile>& opened) { return opened.expired(); });
+                entry.OpenedFiles.push_back(result);
+            }
+        }
+        return result;
+    }
+
+    inline bool IsCacheableImpl(const FileStat& stat) const
+    {
+        const bool fitsFileLimit = m_Options.MaxFileSize == 0 || stat.Size <= m_Options.MaxFileSize;
+        const bool fitsCapacity = m_Options.Capacity == 0 || stat.Size <= m_Options.Capacity;
+        return fitsFileLimit && fitsCapacity;
+    }
+
+    // Add entry of file being copied, its size is reserved in cache. Fails if outdated copy
+    // is opened or capacity can't be freed because of opened files
+    inline bool ReserveImpl(const std::string& virtualPath, const FileStat& stat, std::shared_future<bool> copy) const
+    {
+        // Outdated copy is replaced
+        const auto it = m_Entries.find(virtualPath);
+        if (it != m_Entries.end()) {
+            if (IsPinnedImpl(it->second)) {
+                return false;
+            }
+            EvictImpl(it);
+        }
+
+        if (m_Options.Capacity != 0) {
+            // Least recently used files are evicted first
+            auto recent = m_RecentFiles.end();
+            while (m_CachedSize + stat.Size > m_Options.Capacity && recent != m_RecentFiles.begin()) {
+                const auto candidate = std::prev(recent);
+                const auto candidateIt = m_Entries.find(*candidate);
+                if (IsPinnedImpl(candidateIt->second)) {
+                    recent = candidate;
+                    continue;
+                }
+                EvictImpl(candidateIt);
+            }
+
+            if (m_CachedSize + stat.Size > m_Options.Capacity) {
+                return false;
+            }
+        }
+
+        m_RecentFiles.push_front(virtualPath);
+        m_Entries.try_emplace(virtualPath, CacheEntry{ stat.Size, stat.ModifiedTime, m_RecentFiles.begin(), std::move(copy), ++m_CopyCounter, {} });
+        m_CachedSize += stat.Size;
+        return true;
+    }
+
+    // Called without lock, source and cache synchronize themselves
+    inline bool CopyToCache(const std::string& virtualPath) const
+    {
+        IFilePtr target = m_Cache->OpenFile(virtualPath, IFile::FileMode::Write | IFile::FileMode::Truncate);
+        if (!target) {
+            return false;
+        }
+
+        bool isCopied = FileTransfer::Copy(*m_Source, virtualPath, *target);
+        isCopied = m_Cache->CloseFile(target) && isCopied;
+        if (!isCopied) {
+            m_Cache->RemoveFile(virtualPath);
+        }
+        return isCopied;
+    }
+
+    // Publish copied file or drop its reservation. Entry is gone if filesystem was shut
+    // down during copy
+    inline void FinishCopy(const std::string& virtualPath, uint64_t copyId, bool isCopied) const
+    {
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
+        const auto it = m_Entries.find(virtualPath);
+        if (it == m_Entries.end() || it->second.CopyId != copyId) {
+            return;
+        }
+
+        CacheEntry& entry = it->second;
+        if (!isCopied) {
+            m_CachedSize -= entry.Size;
+            m_RecentFiles.erase(entry.Recent);
+            m_Entries.erase(it);
+            return;
+        }
+
+        entry.Copy = {};
+        entry.CopyId = 0;
+        AppendManifestImpl("+ " + std::to_string(entry.Size) + " " + std::to_string(static_cast<int64_t>(entry.ModifiedTime)) + " " + virtualPath + "\n");
+    }
+
+    // Entry is pinned while it's copied or any file opened from it isn't closed.
+    // Called under exclusive lock
+    inline bool IsPinnedImpl(CacheEntry& entry) const
+    {
+        std::erase_if(entry.OpenedFiles, [](const std::weak_ptr<IFile>& opened) {
+            const IFilePtr file = opened.lock();
+            return !file || !file->IsOpened();
+        });
+        return entry.Copy.valid() || !entry.OpenedFiles.empty();
+    }
+
+    inline bool IsOpenedFromCacheImpl(const IFile& file) const
+    {
+        const auto it = m_Entries.find(file.GetFileInfo().VirtualPath());
+        if (it == m_Entries.end()) {
+            return false;
+        }
+
+        [[maybe_unused]] auto lock = Policy::Lock(m_UseMutex);
+        const auto& opened = it->second.OpenedFiles;
+        return std::any_of(opened.begin(), opened.end(), [&](const std::weak_ptr<IFile>& openedFile) {
+            return openedFile.lock().get() == &file;
+        });
+    }
+
+    template<typename Iterator>
+    void EvictImpl(Iterator it) const
+    {
+        const std::string virtualPath = it->first;
+        m_CachedSize -= it->second.Size;
+        m_RecentFiles.erase(it->second.Recent);
+        m_Entries.erase(it);
+        m_Cache->RemoveFile(virtualPath);
+        AppendManifestImpl("- " + virtualPath + "\n");
+    }
+
+    // Manifest lines are "+ <size> <modified time> <path>" for cached files and
+    // "- <path>" for evicted ones, last line of path wins
+    inline void LoadManifestImpl()
+    {
+        m_Entries.clear();
+        m_RecentFiles.clear();
+        m_CachedSize = 0;
+
+        const auto buffer = m_Cache->ReadAll(m_ManifestPath);
+        if (buffer) {
+            std::unordered_map<std::string, std::pair<uint64_t, std::time_t>> records;
+            std::istringstream stream(std::string(reinterpret_cast<const char*>(buffer->Data().data()), buffer->Size()));
+            std::string line;
+            while (std::getline(stream, line)) {
+                std::istringstream fields(line);
+                char operation = 0;
+                uint64_t size = 0;
+                int64_t modifiedTime = 0;
+                std::string virtualPath;
+
+                if (!(fields >> operation)) {
+                    continue;
+                }
+                if (operation == '+' && (fields >> size >> modifiedTime)) {
+                    fields.get();
+                    std::getline(fields, virtualPath);
+                    records[virtualPath] = { size, static_cast<std::time_t>(modifiedTime) };
+                } else if (operation == '-') {
+                    fields.get();
+                    std::getline(fields, virtualPath);
+                    records.erase(virtualPath);
+                }
+            }
+
+            // Files removed from cache directory are dropped
+            for (const auto& [virtualPath, record] : records) {
+                const auto stat = m_Cache->Stat(virtualPath);
+                if (stat && stat->Size == record.first) {
+                    m_RecentFiles.push_back(virtualPath);
+                    m_Entries.try_emplace(virtualPath, CacheEntry{ record.first, record.second, std::prev(m_RecentFiles.end()), {}, 0, {} });
+                    m_CachedSize += record.first;
+                }
+            }
+        }
+
+        WriteManifestImpl();
+    }
+
+    // Rewrite manifest without evicted and replaced records
+    inline void WriteManifestImpl() const
+    {
+        std::string manifest;
+        for (const auto& [virtualPath, entry] : m_Entries) {
+            if (entry.Copy.valid()) {
+                continue;
+            }
+            manifest += "+ " + std::to_string(entry.Size) + " " + std::to_string(static_cast<int64_t>(entry.ModifiedTime)) + " " + virtualPath + "\n";
+        }
+        WriteToManifestImpl(manifest, IFile::FileMode::Write | IFile::FileMode::Truncate);
+    }
+
+    inline void AppendManifestImpl(const std::string& line) const
+    {
+        WriteToManifestImpl(line, IFile::FileMode::Write | IFile::FileMode::Append);
+    }
+
+    inline void WriteToManifestImpl(const std::string& text, IFile::FileMode mode) const
+    {
+        if (IFilePtr file = m_Cache->OpenFile(m_ManifestPath, mode)) {
+            file->Write(std::span<const uint8_t>(reinterpret_cast<const uint8_t*>(text.data()), text.size()));
+            m_Cache->CloseFile(file);
+        }
+    }
+
+private:
+    std::string m_AliasPath;
+    IFileSystemPtr m_Source;
+    IFileSystemPtr m_Cache;
+    CacheOptions m_Options;
+    std::string m_ManifestPath;
+    bool m_IsInitialized = false;
+
+    // Cache state changes on reads, so it's mutable
+    mutable FileIndex<CacheEntry, Policy> m_Entries;
+    mutable std::list<std::string> m_RecentFiles; // Most recently used first
+    mutable uint64_t m_CachedSize = 0;
+    mutable uint64_t m_CopyCounter = 0;
+    [[no_unique_address]] mutable typename Policy::Mutex m_Mutex;
+    // Guards recent files and opened files updated by readers under shared lock
+    [[no_unique_address]] mutable typename Policy::Mutex m_UseMutex;
+};
+
+} // namespace vfspp
+
+#endif // VFSPP_CACHINGFILESYSTEM_HPP
@@ -0,0 +1,276 @@
+#ifndef VFSPP_CHUNKSTORE_HPP
+#define VFSPP_CHUNKSTORE_HPP
+
+#include "IFileSystem.h"
+#include "ContentHash.hpp"
+#include "ThreadingPolicy.hpp"
+
+#include <charconv>
+
+namespace vfspp
+{
+
+/*
+ * Chunk of file content, chunks are addressed by XXH64 hash and size of their data
+ */
+struct ChunkRef
+{
+    uint64_t Hash = 0;
+    uint32_t Size = 0;
+
+    bool operator==(const ChunkRef&) const = default;
+
+    struct Hasher
+    {
+        size_t operator()(const ChunkRef& chunk) const noexcept
+        {
+            return static_cast<size_t>(chunk.Hash);
+        }
+    };
+
+    /*
+     * Get path of chunk relative to chunks directory of store, "<h>/<hash>-<size>" where
+     * <h> is first two hex digits of hash
+     */
+    [[nodiscard]]
+    std::string Name() const
+    {
+        const std::string hash = ToHex(Hash);
+        return hash.substr(0, 2) + "/" + hash + "-" + std::to_string(Size);
+    }
+
+    static std::string ToHex(uint64_t value)
+    {
+        static constexpr char kDigits[] = "0123456789abcdef";
+        std::string hex(16, '0');
+        for (size_t i = 16; i > 0; --i) {
+            hex[i - 1] = kDigits[value & 0xF];
+            value >>= 4;
+        }
+        return hex;
+    }
+};
+
+
+/*
+ * Content of file stored as list of chunks. Text format:
+ *   vfspp-chunks 1
+ *   <size> <modified time>
+ *   <hash hex> <chunk size>
+ *   ...
+ */
+struct ChunkManifest
+{
+    static constexpr std::string_view kHeader = "vfspp-chunks 1";
+
+    uint64_t Size = 0;
+    std::time_t ModifiedTime = 0;
+    std::vector<ChunkRef> Chunks;
+    std::vector<uint64_t> Offsets; // Offset of each chunk in file
+
+    /*
+     * Add chunk to end of file
+     */
+    void Add(const ChunkRef& chunk)
+    {
+        Chunks.push_back(chunk);
+        Offsets.push_back(Size);
+        Size += chunk.Size;
+    }
+
+    /*
+     * Get index of chunk containing offset, offset must be less than size
+     */
+    [[nodiscard]]
+    size_t FindChunk(uint64_t offset) const
+    {
+        const auto it = std::upper_bound(Offsets.begin(), Offsets.end(), offset);
+        return static_cast<size_t>(it - Offsets.begin()) - 1;
+    }
+
+    [[nodiscard]]
+    std::string Serialize() const
+    {
+        std::string text;
+        text.reserve(kHeader.size() + 48 + Chunks.size() * 28);
+        text += kHeader;
+        text += "\n" + std::to_string(Size) + " " + std::to_string(static_cast<int64_t>(ModifiedTime)) + "\n";
+        for (const auto& chunk : Chunks) {
+            text += ChunkRef::ToHex(chunk.Hash) + " " + std::to_string(chunk.Size) + "\n";
+        }
+        return text;
+    }
+
+    /*
+     * Parse manifest, returns nothing if manifest is malformed or sizes don't add up
+     */
+    [[nodiscard]]
+    static std::optional<ChunkManifest> Parse(std::span<const uint8_t> data)
+    {
+        const char* it = reinterpret_cast<const char*>(data.data());
+        const char* end = it + data.size();
+
+        if (std::string_view(it, data.size()).substr(0, kHeader.size()) != kHeader) {
+            return std::nullopt;
+        }
+        it += kHeader.size();
+
+        uint64_t size = 0;
+        int64_t modifiedTime = 0;
+        if (!ParseField(it, end, size, 10) || !ParseField(it, end, modifiedTime, 10)) {
+            return std::nullopt;
+        }
+
+        ChunkManifest manifest;
+        manifest.ModifiedTime = static_cast<std::time_t>(modifiedTime);
+        while (SkipSpaces(it, end)) {
+            ChunkRef chunk;
+            if (!ParseField(it, end, chunk.Hash, 16) || !ParseField(it, end, chunk.Size, 10) || chunk.Size == 0) {
+                return std::nullopt;
+            }
+            manifest.Add(chunk);
+        }
+
+        if (manifest.Size != size) {
+            return std::nullopt;
+        }
+        return manifest;
+    }
+
+private:
+    static bool SkipSpaces(const char*& it, const char* end)
+    {
+        while (it != end && (*it == ' ' || *it == '\n' || *it == '\r')) {
+            ++it;
+        }
+        return it != end;
+    }
+
+    template<typename T>
+    static bool ParseField(const char*& it, const char* end, T& value, int base)
+    {
+        if (!SkipSpaces(it, end)) {
+            return false;
+        }
+        const auto result = std::from_chars(it, end, value, base);
+        it = result.ptr;
+        return result.ec == std::errc();
+    }
+};
+
+using ChunkManifestPtr = std::shared_ptr<const ChunkManifest>;
+
+
+template<typename Policy>
+class BasicChunkStore;
+
+using ChunkStore = BasicChunkStore<ThreadingPolicy>;
+using ChunkStorePtr = std::shared_ptr<ChunkStore>;
+using ChunkStoreWeakPtr = std::weak_ptr<ChunkStore>;
+
+/*
+ * Chunks of chunk store filesystem with cache of recently read ones. Chunks are loaded
+ * from storage filesystem, e.g. native directory or pack archive, and checked against
+ * their hash. Cache is shared by all files, so chunk used by several files is cached
+ * once. Store is shared by all files of filesystem, calls are synchronized by Policy
+ */
+template<typename Policy>
+class BasicChunkStore final
+{
+public:
+    /*
+     * Chunks are read from "<chunksPath><chunk name>" of storage
+     */
+    BasicChunkStore(IFileSystemPtr storage, std::string chunksPath, uint64_t cacheCapacity)
+        : m_Storage(std::move(storage))
+        , m_ChunksPath(std::move(chunksPath))
+        , m_CacheCapacity(cacheCapacity)
+    {
+    }
+
+    BasicChunkStore(const BasicChunkStore&) = delete;
+    BasicChunkStore& operator=(const BasicChunkStore&) = delete;
+
+    /*
+     * Get chunk data, returns nothing if chunk is missing or damaged
+     */
+    [[nodiscard]]
+    std::optional<FileBuffer> Read(const ChunkRef& chunk)
+    {
+        {
+            [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
+            const auto it = m_Cache.find(chunk);
+            if (it != m_Cache.end()) {
+                m_RecentChunks.splice(m_RecentChunks.begin(), m_RecentChunks, it->second.Recent);
+                return it->second.Data;
+            }
+        }
+
+        // Storage is synchronized by its own policy, chunk loaded by two readers at
+        // same time is cached once
+        auto data = m_Storage->ReadAll(m_ChunksPath + chunk.Name());
+        if (!data || data->Size() != chunk.Size || ContentHasher::Compute(data->Data()) != chunk.Hash) {
+            return std::nullopt;
+        }
+
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
+        if (chunk.Size <= m_CacheCapacity && m_Cache.find(chunk) == m_Cache.end()) {
+            m_RecentChunks.push_front(chunk);
+            m_Cache.emplace(chunk, CacheEntry{ *data, m_RecentChunks.begin() });
+            m_CachedSize += chunk.Size;
+            EvictImpl();
+        }
+        return data;
+    }
+
+    /*
+     * Get total size of cached chunks
+     */
+    [[nodiscard]]
+    uint64_t CachedSize() const
+    {
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
+        return m_CachedSize;
+    }
+
+    /*
+     * Drop all cached chunks
+     */
+    void ClearCache()
+    {
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
+        m_Cache.clear();
+        m_RecentChunks.clear();
+        m_CachedSize = 0;
+    }
+
+private:
+    struct CacheEntry
+    {
+        FileBuffer Data;
+        std::list<ChunkRef>::iterator Recent;
+    };
+
+    void EvictImpl()
+    {
+        while (m_CachedSize > m_CacheCapacity && !m_RecentChunks.empty()) {
+            const ChunkRef chunk = m_RecentChunks.back();
+            m_RecentChunks.pop_back();
+            m_Cache.erase(chunk);
+            m_CachedSize -= chunk.Size;
+        }
+    }
+
+private:
+    IFileSystemPtr m_Storage;
+    std::string m_ChunksPath;
+    uint64_t m_CacheCapacity;
+    uint64_t m_CachedSize = 0;
+    std::list<ChunkRef> m_RecentChunks; // Most recently used first
+    std::unordered_map<ChunkRef, CacheEntry, ChunkRef::Hasher> m_Cache;
+    [[no_unique_address]] mutable typename Policy::Mutex m_Mutex;
+};
+
+} // namespace vfspp
+
+#endif // VFSPP_CHUNKSTORE_HPP
@@ -0,0 +1,218 @@
+#ifndef VFSPP_CHUNKSTOREBUILDER_HPP
+#define VFSPP_CHUNKSTOREBUILDER_HPP
+
+#include "BuildPipeline.hpp"
+#include "NativeFileSystem.hpp"
+#include "ContentDefinedChunker.hpp"
+#include "ChunkStoreFileSystem.hpp"
+
+namespace vfspp
+{
+
+/*
+ * Chunk store build settings, files are chunked and hashed on executor of pipeline
+ */
+struct ChunkBuildOptions : BuildPipelineOptions
+{
+    // Chunk sizes, stores built with different sizes share few chunks
+    ChunkerOptions Chunker;
+
+    // Remove chunks not used by any manifest, drops chunks of previous store versions
+    bool RemoveUnusedChunks = false;
+};
+
+
+/*
+ * Result of chunk store build
+ */
+struct ChunkBuildStats
+{
+    uint64_t FileCount = 0;
+    uint64_t TotalSize = 0;
+    uint64_t ChunkCount = 0;
+    uint64_t UniqueChunkCount = 0;
+    uint64_t WrittenManifestCount = 0;
+    uint64_t WrittenChunkCount = 0;
+    uint64_t WrittenSize = 0; // Size of written chunks, patch from previous version is these chunks and written manifests
+    uint64_t RemovedChunkCount = 0;
+};
+
+
+/*
+ * Build chunk store from files mounted to virtual filesystem, see ChunkStoreFileSystem.
+ * Store directory can hold previous version of store, then only manifests of changed
+ * files and chunks which are not in store yet are written, and manifests of files that
+ * are gone are removed. Files go through BuildPipeline, chunking and hashing runs
+ * on executor
+ */
+class ChunkStoreBuilder final
+{
+public:
+    explicit ChunkStoreBuilder(ChunkBuildOptions options = {})
+        : m_Options(std::move(options))
+        , m_Chunker(m_Options.Chunker)
+    {
+    }
+
+    ChunkStoreBuilder(const ChunkStoreBuilder&) = delete;
+    ChunkStoreBuilder& operator=(const ChunkStoreBuilder&) = delete;
+
+    /*
+     * Store all files under virtual root in native store directory, file paths are
+     * relative to root. Directory is created if not exists
+     */
+    template<typename Policy>
+    [[nodiscard]]
+    bool Build(BasicVirtualFileSystem<Policy>& vfs, const std::string& virtualRoot, const std::string& storePath)
+    {
+        m_Stats = {};
+        const Alias root(virtualRoot);
+        const std::vector<std::string> files = BuildPipeline::ListFiles(vfs, root);
+
+        std::error_code ec;
+        fs::create_directories(storePath, ec);
+
+        BasicNativeFileSystem<SingleThreadedPolicy> store("/", storePath);
+        if (!store.Initialize()) {
+            return false;
+        }
+
+        std::unordered_set<std::string> manifests;
+        std::unordered_set<ChunkRef, ChunkRef::Hasher> chunks;
+
+        const bool isBuilt = BuildPipeline::Run<Job>(vfs, root, files, m_Options, [this](Job& job) {
+            ChunkJob(job);
+        }, [&](const Job& job) {
+            if (!WriteJob(store, job, chunks)) {
+                return false;
+            }
+            manifests.insert(Path(ChunkStoreFileSystem::kManifestsDirectory, job.File.Name));
+            return true;
+        });
+
+        if (!isBuilt) {
+            return false;
+        }
+
+        RemoveUnused(store, ChunkStoreFileSystem::kManifestsDirectory, [&](const std::string& path) {
+            return manifests.contains(path);
+        });
+
+        if (m_Options.RemoveUnusedChunks) {
+            std::unordered_set<std::string> chunkPaths;
+            for (const ChunkRef& chunk : chunks) {
+                chunkPaths.insert(Path(ChunkStoreFileSystem::kChunksDirectory, chunk.Name()));
+            }
+            m_Stats.RemovedChunkCount = RemoveUnused(store, ChunkStoreFileSystem::kChunksDirectory, [&](const std::string& path) {
+                return chunkPaths.contains(path);
+            });
+        }
+
+        m_Stats.UniqueChunkCount = chunks.size();
+        return true;
+    }
+
+    /*
+     * Get statistics of last build
+     */
+    [[nodiscard]]
+    const ChunkBuildStats& Stats() const
+    {
+        return m_Stats;
+    }
+
+private:
+    struct Job
+    {
+        BuildFile File;
+        ChunkManifest Manifest;
+    };
+
+    void ChunkJob(Job& job) const
+    {
+        job.Manifest.ModifiedTime = job.File.Stat.ModifiedTime;
+        for (const auto chunk : m_Chunker.Split(job.File.Data.Data())) {
+            job.Manifest.Add(ChunkRef{ ContentHasher::Compute(chunk), static_cast<uint32_t>(chunk.size()) });
+        }
+    }
+
+    // Chunk already in store is kept if its size matches, damaged chunk is rewritten
+    bool WriteJob(IFileSystem& store, const Job& job, std::unordered_set<ChunkRef, ChunkRef::Hasher>& chunks)
+    {
+        const ChunkManifest& manifest = job.Manifest;
+        for (size_t i = 0; i < manifest.Chunks.size(); ++i) {
+            const ChunkRef& chunk = manifest.Chunks[i];
+            if (!chunks.insert(chunk).second) {
+                continue;
+            }
+
+            const std::string path = Path(ChunkStoreFileSystem::kChunksDirectory, chunk.Name());
+            const auto stat = store.Stat(path);
+            if (stat && stat->Size == chunk.Size) {
+                continue;
+            }
+
+            const auto data = job.File.Data.Data().subspan(static_cast<size_t>(manifest.Offsets[i]), chunk.Size);
+            if (!WriteFile(store, path, data)) {
+                return false;
+            }
+            m_Stats.WrittenChunkCount++;
+            m_Stats.WrittenSize += chunk.Size;
+        }
+
+        // Unchanged manifest is kept, so it's not part of patch
+        const std::string text = manifest.Serialize();
+        const auto manifestData = std::span<const uint8_t>(reinterpret_cast<const uint8_t*>(text.data()), text.size());
+        const std::string path = Path(ChunkStoreFileSystem::kManifestsDirectory, job.File.Name);
+        const auto existing = store.ReadAll(path);
+        if (!existing || !std::ranges::equal(existing->Data(), manifestData)) {
+            if (!WriteFile(store, path, manifestData)) {
+                return false;
+            }
+            m_Stats.WrittenManifestCount++;
+        }
+
+        m_Stats.FileCount++;
+        m_Stats.TotalSize += manifest.Size;
+        m_Stats.ChunkCount += manifest.Chunks.size();
+        return true;
+    }
+
+    static bool WriteFile(IFileSystem& store, const std::string& path, std::span<const uint8_t> data)
+    {
+        IFilePtr file = store.OpenFile(path, IFile::FileMode::Write | IFile::FileMode::Truncate);
+        if (!file) {
+            return false;
+        }
+
+        const bool isWritten = file->Write(data) == data.size();
+        return store.CloseFile(file) && isWritten;
+    }
+
+    template<typename Predicate>
+    static uint64_t RemoveUnused(IFileSystem& store, std::string_view directory, Predicate&& isUsed)
+    {
+        uint64_t removed = 0;
+        for (const auto& path : store.ListDirectory(Path(directory, ""), true)) {
+            if (!path.ends_with('/') && !isUsed(path) && store.RemoveFile(path)) {
+                removed++;
+            }
+        }
+        return removed;
+    }
+
+    // Virtual path in store mounted to root
+    static std::string Path(std::string_view directory, const std::string& name)
+    {
+        return "/" + std::string(directory) + name;
+    }
+
+private:
+    ChunkBuildOptions m_Options;
+    ContentDefinedChunker m_Chunker;
+    ChunkBuildStats m_Stats;
+};
+
+} // namespace vfspp
+
+#endif // VFSPP_CHUNKSTOREBUILDER_HPP
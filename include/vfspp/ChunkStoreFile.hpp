@@ -0,0 +1,302 @@
+#ifndef VFSPP_CHUNKSTOREFILE_HPP
+#define VFSPP_CHUNKSTOREFILE_HPP
+
+#include "IFile.h"
+#include "ThreadingPolicy.hpp"
+#include "ChunkStore.hpp"
+
+namespace vfspp
+{
+
+template<typename Policy, typename StorePolicy = Policy>
+class BasicChunkStoreFile;
+
+using ChunkStoreFile = BasicChunkStoreFile<ThreadingPolicy>;
+using ChunkStoreFilePtr = std::shared_ptr<ChunkStoreFile>;
+using ChunkStoreFileWeakPtr = std::weak_ptr<ChunkStoreFile>;
+
+// Handle owned by single thread, calls are not synchronized. Chunk store is shared with
+// filesystem, so it's synchronized by filesystem policy
+using ExclusiveChunkStoreFile = BasicChunkStoreFile<SingleThreadedPolicy, ThreadingPolicy>;
+
+
+/*
+ * Read-only file of chunk store, content is assembled from chunks listed by manifest.
+ * File keeps chunk it read last, so sequential small reads don't go to store cache.
+ * Calls are synchronized by Policy and store shared with filesystem by StorePolicy
+ */
+template<typename Policy, typename StorePolicy>
+class BasicChunkStoreFile final : public IFile
+{
+public:
+    BasicChunkStoreFile(const FileInfo& fileInfo, ChunkManifestPtr manifest, std::weak_ptr<BasicChunkStore<StorePolicy>> store)
+        : m_FileInfo(fileInfo)
+        , m_Manifest(std::move(manifest))
+        , m_Store(std::move(store))
+    {
+    }
+
+    ~BasicChunkStoreFile()
+    {
+        Close();
+    }
+
+    /*
+     * Get file information
+     */
+    [[nodiscard]]
+    virtual const FileInfo& GetFileInfo() const override
+    {
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
+        return m_FileInfo;
+    }
+
+    /*
+     * Returns file size
+     */
+    [[nodiscard]]
+    virtual uint64_t Size() const override
+    {
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
+        return m_Manifest->Size;
+    }
+
+    /*
+     * Chunk store files are always read-only
+     */
+    [[nodiscard]]
+    virtual bool IsReadOnly() const override
+    {
+        return true;
+    }
+
+    /*
+     * Open file for reading
+     */
+    [[nodiscard]]
+    virtual bool Open(FileMode mode) override
+    {
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
+        return OpenImpl(mode);
+    }
+
+    /*
+     * Close file
+     */
+    virtual bool Close() override
+    {
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
+        CloseImpl();
+        return true;
+    }
+
+    /*
+     * Check is file ready for reading
+     */
+    [[nodiscard]]
+    virtual bool IsOpened() const override
+    {
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
+        return IsOpenedImpl();
+    }
+
+    /*
+     * Check if read data didn't match checksum, file has no checksum
+     */
+    [[nodiscard]]
+    virtual bool IsCorrupted() const override
+    {
+        return false;
+    }
+
+    /*
+     * Seek on a file
+     */
+    virtual uint64_t Seek(uint64_t offset, Origin origin) override
+    {
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
+        return SeekImpl(offset, origin);
+    }
+
+    /*
+     * Returns offset in file
+     */
+    [[nodiscard]]
+    virtual uint64_t Tell() const override
+    {
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
+        return m_SeekPos;
+    }
+
+    /*
+     * Read data from file to buffer
+     */
+    virtual uint64_t Read(std::span<uint8_t> buffer) override
+    {
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
+        return ReadVImpl(std::span<const std::span<uint8_t>>(&buffer, 1));
+    }
+
+    /*
+     * Read data from file to vector
+     */
+    virtual uint64_t Read(std::vector<uint8_t>& buffer, uint64_t size) override
+    {
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
+        buffer.resize(static_cast<size_t>(size));
+        const auto data = std::span<uint8_t>(buffer);
+        return ReadVImpl(std::span<const std::span<uint8_t>>(&data, 1));
+    }
+
+    /*
+     * Read data from absolute offset to buffer, doesn't move file cursor
+     */
+    virtual uint64_t ReadAt(uint64_t offset, std::span<uint8_t> buffer) override
+    {
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
+        return ReadVAtImpl(offset, std::span<const std::span<uint8_t>>(&buffer, 1));
+    }
+
+    /*
+     * Read consecutive data from file to several buffers filled in order, moves file cursor
+     */
+    virtual uint64_t ReadV(std::span<const std::span<uint8_t>> buffers) override
+    {
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
+        return ReadVImpl(buffers);
+    }
+
+    /*
+     * Chunk store files are read-only
+     */
+    virtual uint64_t Write(std::span<const uint8_t> /*buffer*/) override
+    {
+        return 0;
+    }
+
+    /*
+     * Chunk store files are read-only
+     */
+    virtual uint64_t Write(const std::vector<uint8_t>& /*buffer*/) override
+    {
+        return 0;
+    }
+
+private:
+    inline bool OpenImpl(FileMode mode)
+    {
+        if (!IFile::IsModeValid(mode) || IFile::ModeHasFlag(mode, FileMode::Write) || m_Store.expired()) {
+            return false;
+        }
+
+        m_IsOpened = true;
+        m_SeekPos = 0;
+        return true;
+    }
+
+    inline void CloseImpl()
+    {
+        m_IsOpened = false;
+        m_SeekPos = 0;
+        m_Chunk = {};
+        m_ChunkIndex = kNoChunk;
+    }
+
+    inline bool IsOpenedImpl() const
+    {
+        return m_IsOpened && !m_Store.expired();
+    }
+
+    inline uint64_t SeekImpl(uint64_t offset, Origin origin)
+    {
+        if (!IsOpenedImpl()) {
+            return 0;
+        }
+
+        const uint64_t size = m_Manifest->Size;
+        if (origin == IFile::Origin::Begin) {
+            m_SeekPos = offset;
+        } else if (origin == IFile::Origin::End) {
+            m_SeekPos = (offset <= size) ? size - offset : 0;
+        } else if (origin == IFile::Origin::Set) {
+            m_SeekPos += offset;
+        }
+        m_SeekPos = std::min(m_SeekPos, size);
+
+        return m_SeekPos;
+    }
+
+    inline uint64_t ReadVImpl(std::span<const std::span<uint8_t>> buffers)
+    {
+        const auto read = ReadVAtImpl(m_SeekPos, buffers);
+        m_SeekPos += read;
+        return read;
+    }
+
+    inline uint64_t ReadVAtImpl(uint64_t offset, std::span<const std::span<uint8_t>> buffers)
+    {
+        if (!IsOpenedImpl()) {
+            return 0;
+        }
+
+        const ChunkManifest& manifest = *m_Manifest;
+        uint64_t total = 0;
+        for (const auto& buffer : buffers) {
+            size_t filled = 0;
+            while (filled < buffer.size() && offset + total < manifest.Size) {
+                const uint64_t position = offset + total;
+                const size_t index = manifest.FindChunk(position);
+                if (!LoadChunkImpl(index)) {
+                    return total;
+                }
+
+                const auto chunkOffset = static_cast<size_t>(position - manifest.Offsets[index]);
+                const auto count = static_cast<size_t>(std::min<uint64_t>(buffer.size() - filled, m_Chunk.Size() - chunkOffset));
+                std::memcpy(buffer.data() + filled, m_Chunk.Data().data() + chunkOffset, count);
+                filled += count;
+                total += count;
+            }
+
+            if (filled != buffer.size()) {
+                break;
+            }
+        }
+        return total;
+    }
+
+    inline bool LoadChunkImpl(size_t index)
+    {
+        if (m_ChunkIndex == index) {
+            return true;
+        }
+
+        auto store = m_Store.lock();
+        if (!store) {
+            return false;
+        }
+
+        auto chunk = store->Read(m_Manifest->Chunks[index]);
+        if (!chunk) {
+            return false;
+        }
+        m_Chunk = std::move(*chunk);
+        m_ChunkIndex = index;
+        return true;
+    }
+
+private:
+    static constexpr size_t kNoChunk = std::numeric_limits<size_t>::max();
+
+    FileInfo m_FileInfo;
+    ChunkManifestPtr m_Manifest;
+    std::weak_ptr<BasicChunkStore<StorePolicy>> m_Store;
+    bool m_IsOpened = false;
+    uint64_t m_SeekPos = 0;
+    FileBuffer m_Chunk;
+    size_t m_ChunkIndex = kNoChunk;
+    [[no_unique_address]] mutable typename Policy::Mutex m_Mutex;
+};
+
+} // namespace vfspp
+
+#endif // VFSPP_CHUNKSTOREFILE_HPP
@@ -0,0 +1,455 @@
+#ifndef VFSPP_CHUNKSTOREFILESYSTEM_HPP
+#define VFSPP_CHUNKSTOREFILESYSTEM_HPP
+
+#include "IFileSystem.h"
+#include "Alias.hpp"
+#include "FileIndex.hpp"
+#include "Global.h"
+#include "ThreadingPolicy.hpp"
+#include "ChunkStore.hpp"
+#include "ChunkStoreFile.hpp"
+
+namespace vfspp
+{
+
+template<typename Policy>
+class BasicChunkStoreFileSystem;
+
+using ChunkStoreFileSystem = BasicChunkStoreFileSystem<ThreadingPolicy>;
+using ChunkStoreFileSystemPtr = std::shared_ptr<ChunkStoreFileSystem>;
+using ChunkStoreFileSystemWeakPtr = std::weak_ptr<ChunkStoreFileSystem>;
+
+
+/*
+ * Chunk store settings
+ */
+struct ChunkStoreOptions
+{
+    // Total size of recently read chunks kept in memory, 0 disables cache
+    uint64_t CacheCapacity = 64 * 1024 * 1024;
+};
+
+
+/*
+ * Read-only filesystem of content addressed chunk store, see ChunkStoreBuilder. Store is
+ * read from storage filesystem, e.g. native directory or archive with stored entries:
+ *   manifests/<file path>      chunk list of file, see ChunkManifest
+ *   chunks/<h>/<hash>-<size>   chunk data, see ChunkRef
+ * Files of store are assembled from chunks on read, chunks are shared by files and
+ * store versions, so patch of store contains only manifests and chunks that changed.
+ * Calls are synchronized by Policy
+ */
+template<typename Policy>
+class BasicChunkStoreFileSystem final : public IFileSystem
+{
+public:
+    static constexpr std::string_view kManifestsDirectory = "manifests/";
+    static constexpr std::string_view kChunksDirectory = "chunks/";
+
+public:
+    /*
+     * Storage must be created with same alias as chunk store filesystem, it's
+     * initialized with it if needed
+     */
+    BasicChunkStoreFileSystem(const std::string& aliasPath, IFileSystemPtr storage, ChunkStoreOptions options = {})
+        : m_AliasPath(aliasPath)
+        , m_Storage(std::move(storage))
+        , m_Options(options)
+    {
+    }
+
+    ~BasicChunkStoreFileSystem()
+    {
+        Shutdown();
+    }
+
+    /*
+     * Initialize filesystem, call this method as soon as possible
+     */
+    [[nodiscard]]
+    virtual bool Initialize() override
+    {
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
+        return InitializeImpl();
+    }
+
+    /*
+     * Shutdown filesystem and storage, opened files can't be read after shutdown
+     */
+    virtual void Shutdown() override
+    {
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
+        ShutdownImpl();
+    }
+
+    /*
+     * Set executor for parsing manifests and for storage
+     */
+    virtual void SetExecutor(ExecutorPtr executor) override
+    {
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
+        if (m_Storage) {
+            m_Storage->SetExecutor(executor);
+        }
+        m_Executor = std::move(executor);
+    }
+
+    /*
+     * Switch case sensitivity of file lookups, fails if paths of files differ only by case
+     */
+    virtual bool SetCaseSensitive(bool isCaseSensitive) override
+    {
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
+        return m_Files.SetCaseSensitive(isCaseSensitive);
+    }
+
+    /*
+     * Check if file lookups are case sensitive
+     */
+    [[nodiscard]]
+    virtual bool IsCaseSensitive() const override
+    {
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
+        return m_Files.IsCaseSensitive();
+    }
+
+    /*
+     * Check if filesystem is initialized
+     */
+    [[nodiscard]]
+    virtual bool IsInitialized() const override
+    {
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
+        return m_IsInitialized;
+    }
+
+    /*
+     * Get base path of storage
+     */
+    [[nodiscard]]
+    virtual const std::string& BasePath() const override
+    {
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
+        return m_Storage ? m_Storage->BasePath() : m_AliasPath;
+    }
+
+    /*
+     * Get mounted path
+     */
+    [[nodiscard]]
+    virtual const std::string& VirtualPath() const override
+    {
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
+        return m_AliasPath;
+    }
+
+    /*
+     * Retrieve all files of store
+     */
+    [[nodiscard]]
+    virtual FilesList GetFilesList() const override
+    {
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
+
+        FilesList list;
+        list.reserve(m_Files.size());
+        for (const auto& [path, entry] : m_Files) {
+            list.push_back(entry.Info);
+        }
+        return list;
+    }
+
+    /*
+     * Call visitor for each file without copying file list, stops when visitor returns false
+     */
+    virtual void ForEachFile(const FileVisitor& visitor) const override
+    {
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
+        for (const auto& [path, entry] : m_Files) {
+            if (!visitor(entry.Info)) {
+                return;
+            }
+        }
+    }
+
+    /*
+     * List files and directories of directory, paths of directories end with '/'
+     */
+    [[nodiscard]]
+    virtual std::vector<std::string> ListDirectory(const std::string& virtualPath, bool recursive = false) const override
+    {
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
+        return m_Files.ListDirectory(virtualPath, recursive);
+    }
+
+    /*
+     * Find files matching pattern. Returns sorted virtual paths
+     */
+    [[nodiscard]]
+    virtual std::vector<std::string> FindFiles(const GlobPattern& pattern) const override
+    {
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
+        return m_Files.Find(pattern);
+    }
+
+    /*
+     * Chunk store filesystem is readonly
+     */
+    [[nodiscard]]
+    virtual bool IsReadOnly() const override
+    {
+        return true;
+    }
+
+    /*
+     * Open existing file for reading
+     */
+    virtual IFilePtr OpenFile(const std::string& virtualPath, IFile::FileMode mode) override
+    {
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
+        return OpenFileImpl(virtualPath, mode);
+    }
+
+    /*
+     * Close file
+     */
+    virtual bool CloseFile(IFilePtr file) override
+    {
+        return file && file->Close();
+    }
+
+    /*
+     * Not supported by readonly filesystem
+     */
+    virtual IFilePtr CreateFile(const std::string& /*virtualPath*/) override
+    {
+        return nullptr;
+    }
+
+    /*
+     * Not supported by readonly filesystem
+     */
+    virtual bool RemoveFile(const std::string& /*virtualPath*/) override
+    {
+        return false;
+    }
+
+    /*
+     * Not supported by readonly filesystem
+     */
+    virtual bool CopyFile(const std::string& /*srcVirtualPath*/, const std::string& /*dstVirtualPath*/, bool /*overwrite*/ = false) override
+    {
+        return false;
+    }
+
+    /*
+     * Not supported by readonly filesystem
+     */
+    virtual bool RenameFile(const std::string& /*srcVirtualPath*/, const std::string& /*dstVirtualPath*/) override
+    {
+        return false;
+    }
+
+    /*
+     * Check if file exists in store
+     */
+    [[nodiscard]]
+    virtual bool IsFileExists(const std::string& virtualPath) const override
+    {
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
+        return m_Files.find(virtualPath) != m_Files.end();
+    }
+
+    /*
+     * Get file metadata from manifest
+     */
+    [[nodiscard]]
+    virtual std::optional<FileStat> Stat(const std::string& virtualPath) const override
+    {
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
+
+        const auto it = m_Files.find(virtualPath);
+        if (it == m_Files.end()) {
+            return std::nullopt;
+        }
+
+        const ChunkManifest& manifest = *it->second.Manifest;
+        FileStat stat;
+        stat.Size = manifest.Size;
+        stat.ModifiedTime = manifest.ModifiedTime;
+        stat.CompressedSize = manifest.Size;
+        return stat;
+    }
+
+    /*
+     * Read whole file, file of single chunk references cached chunk
+     */
+    [[nodiscard]]
+    virtual std::optional<FileBuffer> ReadAll(const std::string& virtualPath) const override
+    {
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
+        return ReadAllImpl(virtualPath);
+    }
+
+    /*
+     * Get total size of chunks kept in memory
+     */
+    [[nodiscard]]
+    uint64_t CachedSize() const
+    {
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
+        return m_Store ? m_Store->CachedSize() : 0;
+    }
+
+    /*
+     * Drop chunks kept in memory
+     */
+    void ClearCache()
+    {
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
+        if (m_Store) {
+            m_Store->ClearCache();
+        }
+    }
+
+private:
+    struct FileEntry
+    {
+        FileInfo Info;
+        ChunkManifestPtr Manifest;
+    };
+
+    inline bool InitializeImpl()
+    {
+        if (m_IsInitialized) {
+            return true;
+        }
+
+        if (!m_Storage) {
+            return false;
+        }
+
+        const Alias alias(m_AliasPath);
+        if (Alias(m_Storage->VirtualPath()) != alias) {
+            return false;
+        }
+
+        if (!m_Storage->IsInitialized() && !m_Storage->Initialize()) {
+            return false;
+        }
+
+        // Manifests are read from storage serially and parsed in parallel
+        const std::string manifestsPath = alias.String() + std::string(kManifestsDirectory);
+        std::vector<std::string> paths;
+        std::vector<std::optional<FileBuffer>> buffers;
+        for (auto& path : m_Storage->ListDirectory(manifestsPath, true)) {
+            if (!path.ends_with('/')) {
+                buffers.push_back(m_Storage->ReadAll(path));
+                paths.push_back(path.substr(manifestsPath.size()));
+            }
+        }
+
+        std::vector<std::optional<ChunkManifest>> manifests(paths.size());
+        ParallelFor(m_Executor.get(), paths.size(), [&](size_t index) {
+            if (buffers[index]) {
+                manifests[index] = ChunkManifest::Parse(buffers[index]->Data());
+            }
+        });
+
+        for (size_t i = 0; i < paths.size(); ++i) {
+            if (!manifests[i]) {
+                // TODO: log error
+                continue;
+            }
+
+            FileInfo info(m_AliasPath, BasePathImpl(), paths[i]);
+            const std::string virtualPath = info.VirtualPath();
+            m_Files.emplace(virtualPath, FileEntry{ std::move(info), std::make_shared<const ChunkManifest>(std::move(*manifests[i])) });
+        }
+
+        m_Store = std::make_shared<BasicChunkStore<Policy>>(m_Storage, alias.String() + std::string(kChunksDirectory), m_Options.CacheCapacity);
+        m_IsInitialized = true;
+        return true;
+    }
+
+    inline void ShutdownImpl()
+    {
+        if (!m_IsInitialized) {
+            return;
+        }
+
+        // Opened files are closed as soon as store is released
+        m_Store = nullptr;
+        m_Files.clear();
+        m_Storage->Shutdown();
+        m_IsInitialized = false;
+    }
+
+    inline const std::string& BasePathImpl() const
+    {
+        return m_BasePath; // Files have no native path
+    }
+
+    inline IFilePtr OpenFileImpl(const std::string& virtualPath, IFile::FileMode mode) const
+    {
+        if (IFile::ModeHasFlag(mode, IFile::FileMode::Write)) {
+            return nullptr;
+        }
+
+        const auto it = m_Files.find(virtualPath);
+        if (it == m_Files.end()) {
+            return nullptr;
+        }
+        const FileEntry& entry = it->second;
+
+        IFilePtr file;
+        if (IFile::ModeHasFlag(mode, IFile::FileMode::ExclusiveOwner)) {
+            file = std::make_shared<BasicChunkStoreFile<SingleThreadedPolicy, Policy>>(entry.Info, entry.Manifest, m_Store);
+        } else {
+            file = std::make_shared<BasicChunkStoreFile<Policy>>(entry.Info, entry.Manifest, m_Store);
+        }
+
+        if (!file->Open(mode)) {
+            return nullptr;
+        }
+        return file;
+    }
+
+    inline std::optional<FileBuffer> ReadAllImpl(const std::string& virtualPath) const
+    {
+        const auto it = m_Files.find(virtualPath);
+        if (it == m_Files.end() || !m_Store) {
+            return std::nullopt;
+        }
+        const ChunkManifest& manifest = *it->second.Manifest;
+
+        if (manifest.Chunks.size() == 1) {
+            return m_Store->Read(manifest.Chunks.front());
+        }
+
+        auto data = std::make_shared<std::vector<uint8_t>>(static_cast<size_t>(manifest.Size));
+        for (size_t i = 0; i < manifest.Chunks.size(); ++i) {
+            const auto chunk = m_Store->Read(manifest.Chunks[i]);
+            if (!chunk) {
+                return std::nullopt;
+            }
+            std::memcpy(data->data() + manifest.Offsets[i], chunk->Data().data(), static_cast<size_t>(chunk->Size()));
+        }
+        return FileBuffer(std::move(data));
+    }
+
+private:
+    std::string m_AliasPath;
+    std::string m_BasePath;
+    IFileSystemPtr m_Storage;
+    ChunkStoreOptions m_Options;
+    std::shared_ptr<BasicChunkStore<Policy>> m_Store;
+    ExecutorPtr m_Executor;
+    bool m_IsInitialized = false;
+    FileIndex<FileEntry, Policy> m_Files;
+    [[no_unique_address]] mutable typename Policy::Mutex m_Mutex;
+};
+
+} // namespace vfspp
+
+#endif // VFSPP_CHUNKSTOREFILESYSTEM_HPP
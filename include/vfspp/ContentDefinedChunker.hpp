@@ -0,0 +1,118 @@
+#ifndef VFSPP_CONTENTDEFINEDCHUNKER_HPP
+#define VFSPP_CONTENTDEFINEDCHUNKER_HPP
+
+#include "Global.h"
+
+#include <bit>
+
+namespace vfspp
+{
+
+/*
+ * Chunk size limits, average size is rounded down to power of two
+ */
+struct ChunkerOptions
+{
+    uint32_t MinSize = 16 * 1024;
+    uint32_t AverageSize = 64 * 1024;
+    uint32_t MaxSize = 256 * 1024;
+};
+
+
+/*
+ * FastCDC content defined chunking. Cut points depend only on nearby content, so bytes
+ * inserted or removed in file change chunks around edit and following chunks stay same.
+ * Gear hash is rolled from minimum chunk size, stricter mask is used before average size
+ * and looser one after it, so chunk sizes are normalized around average. Gear table is
+ * part of store format, changing it moves all cut points
+ */
+class ContentDefinedChunker final
+{
+public:
+    explicit ContentDefinedChunker(ChunkerOptions options = {}) noexcept
+    {
+        const auto averageBits = static_cast<uint32_t>(std::bit_width(std::max<uint32_t>(options.AverageSize, 256))) - 1;
+        m_AverageSize = uint32_t(1) << averageBits;
+        m_MinSize = std::clamp<uint32_t>(options.MinSize, 64, m_AverageSize);
+        m_MaxSize = std::max(options.MaxSize, m_AverageSize);
+        m_MaskSmall = HighBitsMask(averageBits + 2);
+        m_MaskLarge = HighBitsMask(averageBits - 2);
+    }
+
+    /*
+     * Get size of first chunk of data
+     */
+    [[nodiscard]]
+    size_t NextCut(std::span<const uint8_t> data) const noexcept
+    {
+        size_t size = data.size();
+        if (size <= m_MinSize) {
+            return size;
+        }
+        size = std::min<size_t>(size, m_MaxSize);
+        const size_t normalSize = std::min<size_t>(size, m_AverageSize);
+
+        uint64_t hash = 0;
+        size_t i = m_MinSize;
+        for (; i < normalSize; ++i) {
+            hash = (hash << 1) + kGear[data[i]];
+            if ((hash & m_MaskSmall) == 0) {
+                return i;
+            }
+        }
+        for (; i < size; ++i) {
+            hash = (hash << 1) + kGear[data[i]];
+            if ((hash & m_MaskLarge) == 0) {
+                return i;
+            }
+        }
+        return size;
+    }
+
+    /*
+     * Split data to consecutive chunks
+     */
+    [[nodiscard]]
+    std::vector<std::span<const uint8_t>> Split(std::span<const uint8_t> data) const
+    {
+        std::vector<std::span<const uint8_t>> chunks;
+        while (!data.empty()) {
+            const size_t size = NextCut(data);
+            chunks.push_back(data.first(size));
+            data = data.subspan(size);
+        }
+        return chunks;
+    }
+
+private:
+    // Shifted hash keeps recent bytes in high bits
+    static constexpr uint64_t HighBitsMask(uint32_t bits) noexcept
+    {
+        return bits == 0 ? 0 : ~uint64_t(0) << (64 - std::min<uint32_t>(bits, 64));
+    }
+
+    // SplitMix64 sequence with fixed seed
+    static constexpr std::array<uint64_t, 256> kGear = [] {
+        std::array<uint64_t, 256> table{};
+        uint64_t state = 0x7666737070636463ull;
+        for (auto& value : table) {
+            state += 0x9E3779B97F4A7C15ull;
+            uint64_t z = state;
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            value = z ^ (z >> 31);
+        }
+        return table;
+    }();
+
+private:
+    uint32_t m_MinSize;
+    uint32_t m_AverageSize;
+    uint32_t m_MaxSize;
+    uint64_t m_MaskSmall;
+    uint64_t m_MaskLarge;
+};
+
+} // namespace vfspp
+
+#endif // VFSPP_CONTENTDEFINEDCHUNKER_HPP
@@ -0,0 +1,175 @@
+#ifndef VFSPP_CONTENTHASH_HPP
+#define VFSPP_CONTENTHASH_HPP
+
+#include "Global.h"
+
+#include <bit>
+
+namespace vfspp
+{
+
+/*
+ * 64-bit xxHash (XXH64) of file content. Hash can be computed at once or updated with
+ * consecutive data, both give same result
+ */
+class ContentHasher final
+{
+public:
+    explicit ContentHasher(uint64_t seed = 0) noexcept
+        : m_Seed(seed)
+    {
+        m_Lanes[0] = seed + kPrime1 + kPrime2;
+        m_Lanes[1] = seed + kPrime2;
+        m_Lanes[2] = seed;
+        m_Lanes[3] = seed - kPrime1;
+    }
+
+    /*
+     * Add next data to hash
+     */
+    void Update(std::span<const uint8_t> data) noexcept
+    {
+        const uint8_t* bytes = data.data();
+        size_t size = data.size();
+        if (size == 0) {
+            return;
+        }
+        m_TotalSize += size;
+
+        // Complete stripe started by previous update
+        if (m_BufferedSize > 0) {
+            const size_t count = std::min(size, kStripeSize - m_BufferedSize);
+            std::memcpy(m_Buffer.data() + m_BufferedSize, bytes, count);
+            m_BufferedSize += count;
+            bytes += count;
+            size -= count;
+
+            if (m_BufferedSize < kStripeSize) {
+                return;
+            }
+            ConsumeStripe(m_Buffer.data());
+            m_BufferedSize = 0;
+        }
+
+        while (size >= kStripeSize) {
+            ConsumeStripe(bytes);
+            bytes += kStripeSize;
+            size -= kStripeSize;
+        }
+
+        std::memcpy(m_Buffer.data(), bytes, size);
+        m_BufferedSize = size;
+    }
+
+    /*
+     * Get hash of all data added so far
+     */
+    [[nodiscard]]
+    uint64_t Digest() const noexcept
+    {
+        uint64_t hash;
+        if (m_TotalSize >= kStripeSize) {
+            hash = std::rotl(m_Lanes[0], 1) + std::rotl(m_Lanes[1], 7) + std::rotl(m_Lanes[2], 12) + std::rotl(m_Lanes[3], 18);
+            for (uint64_t lane : m_Lanes) {
+                hash = (hash ^ Round(0, lane)) * kPrime1 + kPrime4;
+            }
+        } else {
+            hash = m_Seed + kPrime5;
+        }
+        hash += m_TotalSize;
+
+        const uint8_t* bytes = m_Buffer.data();
+        size_t size = m_BufferedSize;
+        while (size >= 8) {
+            hash = std::rotl(hash ^ Round(0, Read64(bytes)), 27) * kPrime1 + kPrime4;
+            bytes += 8;
+            size -= 8;
+        }
+        if (size >= 4) {
+            hash = std::rotl(hash ^ (Read32(bytes) * kPrime1), 23) * kPrime2 + kPrime3;
+            bytes += 4;
+            size -= 4;
+        }
+        while (size > 0) {
+            hash = std::rotl(hash ^ (*bytes * kPrime5), 11) * kPrime1;
+            bytes++;
+            size--;
+        }
+
+        hash ^= hash >> 33;
+        hash *= kPrime2;
+        hash ^= hash >> 29;
+        hash *= kPrime3;
+        hash ^= hash >> 32;
+        return hash;
+    }
+
+    /*
+     * Compute hash of data
+     */
+    [[nodiscard]]
+    static uint64_t Compute(std::span<const uint8_t> data, uint64_t seed = 0) noexcept
+    {
+        ContentHasher hasher(seed);
+        hasher.Update(data);
+        return hasher.Digest();
+    }
+
+private:
+    static constexpr uint64_t kPrime1 = 0x9E3779B185EBCA87ull;
+    static constexpr uint64_t kPrime2 = 0xC2B2AE3D27D4EB4Full;
+    static constexpr uint64_t kPrime3 = 0x165667B19E3779F9ull;
+    static constexpr uint64_t kPrime4 = 0x85EBCA77C2B2AE63ull;
+    static constexpr uint64_t kPrime5 = 0x27D4EB2F165667C5ull;
+
+    static constexpr size_t kStripeSize = 32;
+
+    // Words are little endian regardless of target
+    template<typename T>
+    static T ReadWord(const uint8_t* bytes) noexcept
+    {
+        T value = 0;
+        if constexpr (std::endian::native == std::endian::little) {
+            std::memcpy(&value, bytes, sizeof(T));
+        } else {
+            for (size_t i = sizeof(T); i > 0; --i) {
+                value = static_cast<T>((value << 8) | bytes[i - 1]);
+            }
+        }
+        return value;
+    }
+
+    static uint64_t Read64(const uint8_t* bytes) noexcept
+    {
+        return ReadWord<uint64_t>(bytes);
+    }
+
+    static uint64_t Read32(const uint8_t* bytes) noexcept
+    {
+        return ReadWord<uint32_t>(bytes);
+    }
+
+    static uint64_t Round(uint64_t lane, uint64_t input) noexcept
+    {
+        return std::rotl(lane + input * kPrime2, 31) * kPrime1;
+    }
+
+    void ConsumeStripe(const uint8_t* bytes) noexcept
+    {
+        m_Lanes[0] = Round(m_Lanes[0], Read64(bytes));
+        m_Lanes[1] = Round(m_Lanes[1], Read64(bytes + 8));
+        m_Lanes[2] = Round(m_Lanes[2], Read64(bytes + 16));
+        m_Lanes[3] = Round(m_Lanes[3], Read64(bytes + 24));
+    }
+
+private:
+    uint64_t m_Seed;
+    std::array<uint64_t, 4> m_Lanes;
+    std::array<uint8_t, kStripeSize> m_Buffer{};
+    size_t m_BufferedSize = 0;
+    uint64_t m_TotalSize = 0;
+};
+
+} // namespace vfspp
+
+#endif // VFSPP_CONTENTHASH_HPP
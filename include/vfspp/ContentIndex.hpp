@@ -0,0 +1,241 @@
+#ifndef VFSPP_CONTENTINDEX_HPP
+#define VFSPP_CONTENTINDEX_HPP
+
+#include "IFileSystem.h"
+#include "ContentHash.hpp"
+#include "Executor.hpp"
+
+namespace vfspp
+{
+
+template<typename Policy>
+class BasicVirtualFileSystem;
+
+using ContentIndexPtr = std::shared_ptr<const class ContentIndex>;
+
+/*
+ * Content hashes of files visible in virtual filesystem. Files with equal hash and size
+ * are treated as same content, so duplicates shipped by several archives can be found
+ * and stored once. Index is immutable after build and can be shared between threads
+ */
+class ContentIndex final
+{
+public:
+    struct Entry
+    {
+        uint64_t Hash = 0;
+        uint64_t Size = 0;
+        std::time_t ModifiedTime = 0;
+        IFileSystemWeakPtr FileSystem; // Filesystem file was hashed from
+    };
+
+public:
+    ContentIndex() = default;
+
+    /*
+     * Hash all files of virtual filesystem on its executor, files are read in chunks of
+     * kReadChunkSize. Compressed zip entries are inflated from entry start on every offset
+     * read, so they are read in one piece instead. Hashes of previous index are reused for files from same filesystem
+     * with same size and known modification time
+     */
+    template<typename Policy>
+    [[nodiscard]]
+    static ContentIndexPtr Build(BasicVirtualFileSystem<Policy>& vfs, const ContentIndex* previous = nullptr)
+    {
+        const std::vector<std::string> files = vfs.ListAllFiles();
+        std::vector<std::optional<Entry>> entries(files.size());
+
+        ParallelFor(vfs.GetExecutor().get(), files.size(), [&](size_t index) {
+            const std::string& virtualPath = files[index];
+            auto stat = vfs.Stat(virtualPath);
+            if (!stat) {
+                return;
+            }
+
+            if (previous) {
+                const Entry* entry = previous->Find(virtualPath);
+                if (entry && IsSameFile(*entry, *stat)) {
+                    entries[index] = *entry;
+                    return;
+                }
+            }
+
+            IFilePtr file = vfs.OpenFile(virtualPath, IFile::FileMode::Read);
+            if (!file) {
+                return;
+            }
+
+            const uint64_t chunkSize = stat->CompressionMethod != 0 ? stat->Size : kReadChunkSize;
+            const auto hash = HashFile(*file, stat->Size, chunkSize);
+            file->Close();
+            if (hash) {
+                entries[index] = Entry{ *hash, stat->Size, stat->ModifiedTime, stat->FileSystem };
+            }
+        });
+
+        auto index = std::make_shared<ContentIndex>();
+        for (size_t i = 0; i < files.size(); ++i) {
+            if (entries[i]) {
+                index->Add(files[i], std::move(*entries[i]));
+            }
+        }
+        return index;
+    }
+
+    /*
+     * Get indexed entry of file, null if file wasn't indexed
+     */
+    [[nodiscard]]
+    const Entry* Find(const std::string& virtualPath) const
+    {
+        auto it = m_Files.find(virtualPath);
+        return it != m_Files.end() ? &it->second : nullptr;
+    }
+
+    /*
+     * Get hash of file if index entry still matches file metadata, files with unknown
+     * modification time never match
+     */
+    [[nodiscard]]
+    std::optional<uint64_t> FindHash(const std::string& virtualPath, const FileStat& stat) const
+    {
+        const Entry* entry = Find(virtualPath);
+        if (!entry || !IsSameFile(*entry, stat)) {
+            return std::nullopt;
+        }
+        return entry->Hash;
+    }
+
+    /*
+     * Get sorted paths of all files with same content, including file itself
+     */
+    [[nodiscard]]
+    std::span<const std::string> FindSameContent(const std::string& virtualPath) const
+    {
+        const Entry* entry = Find(virtualPath);
+        if (!entry) {
+            return {};
+        }
+        return m_Contents.at(ContentKey{ entry->Hash, entry->Size });
+    }
+
+    /*
+     * Get groups of paths sharing content, each group has at least two paths
+     */
+    [[nodiscard]]
+    std::vector<std::span<const std::string>> FindDuplicates() const
+    {
+        std::vector<std::span<const std::string>> duplicates;
+        for (const auto& [key, paths] : m_Contents) {
+            if (paths.size() > 1) {
+                duplicates.emplace_back(paths);
+            }
+        }
+        return duplicates;
+    }
+
+    [[nodiscard]]
+    size_t FileCount() const
+    {
+        return m_Files.size();
+    }
+
+    /*
+     * Get number of distinct contents
+     */
+    [[nodiscard]]
+    size_t UniqueCount() const
+    {
+        return m_Contents.size();
+    }
+
+    [[nodiscard]]
+    uint64_t TotalSize() const
+    {
+        return m_TotalSize;
+    }
+
+    /*
+     * Get size of files if each content is stored once
+     */
+    [[nodiscard]]
+    uint64_t UniqueSize() const
+    {
+        return m_UniqueSize;
+    }
+
+public:
+    static constexpr size_t kReadChunkSize = 256 * 1024;
+
+private:
+    struct ContentKey
+    {
+        uint64_t Hash;
+        uint64_t Size;
+
+        bool operator==(const ContentKey&) const = default;
+
+        struct Hasher
+        {
+            size_t operator()(const ContentKey& key) const noexcept
+            {
+                return static_cast<size_t>(key.Hash);
+            }
+        };
+    };
+
+    // Size and modification time can't tell changed file if time is unknown
+    static bool IsSameFile(const Entry& entry, const FileStat& stat)
+    {
+        if (stat.ModifiedTime == 0) {
+            return false;
+        }
+
+        const bool isSameFileSystem = !entry.FileSystem.owner_before(stat.FileSystem) && !stat.FileSystem.owner_before(entry.FileSystem);
+        return isSameFileSystem && entry.Size == stat.Size && entry.ModifiedTime == stat.ModifiedTime;
+    }
+
+    // Returns nothing if file size differs from expected one
+    static std::optional<uint64_t> HashFile(IFile& file, uint64_t expectedSize, uint64_t chunkSize)
+    {
+        ContentHasher hasher;
+        std::vector<uint8_t> chunk(static_cast<size_t>(std::min(chunkSize, expectedSize)));
+        uint64_t total = 0;
+        while (total < expectedSize) {
+            const uint64_t read = file.ReadAt(total, chunk);
+            if (read == 0) {
+                return std::nullopt;
+            }
+            hasher.Update(std::span<const uint8_t>(chunk.data(), static_cast<size_t>(read)));
+            total += read;
+        }
+
+        std::array<uint8_t, 1> extra;
+        if (file.ReadAt(total, extra) != 0) {
+            return std::nullopt;
+        }
+        return hasher.Digest();
+    }
+
+    // Files are added in sorted order, so content groups stay sorted
+    void Add(const std::string& virtualPath, Entry entry)
+    {
+        auto& paths = m_Contents[ContentKey{ entry.Hash, entry.Size }];
+        if (paths.empty()) {
+            m_UniqueSize += entry.Size;
+        }
+        paths.push_back(virtualPath);
+        m_TotalSize += entry.Size;
+        m_Files.emplace(virtualPath, std::move(entry));
+    }
+
+private:
+    std::unordered_map<std::string, Entry> m_Files;
+    std::unordered_map<ContentKey, std::vector<std::string>, ContentKey::Hasher> m_Contents;
+    uint64_t m_TotalSize = 0;
+    uint64_t m_UniqueSize = 0;
+};
+
+} // namespace vfspp
+
+#endif // VFSPP_CONTENTINDEX_HPP
@@ -0,0 +1,205 @@
+#ifndef VFSPP_CRC32_HPP
+#define VFSPP_CRC32_HPP
+
+#include "Global.h"
+
+#include <bit>
+
+// Carry-less multiplication folding on x86, used when CPU supports PCLMULQDQ
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64)
+#define VFSPP_CRC32_CLMUL_ENABLED
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define VFSPP_CRC32_CLMUL_TARGET
+#else
+#include <cpuid.h>
+#define VFSPP_CRC32_CLMUL_TARGET __attribute__((target("pclmul,sse2")))
+#endif
+#endif
+
+namespace vfspp
+{
+
+/*
+ * CRC-32 used by zip (reflected polynomial 0xEDB88320). Large buffers are folded with
+ * PCLMULQDQ when CPU supports it, the rest is computed slice-by-8
+ */
+class Crc32 final
+{
+public:
+    /*
+     * Continue checksum of previous data with next data, initial checksum is 0
+     */
+    [[nodiscard]]
+    static uint32_t Update(uint32_t crc, std::span<const uint8_t> data) noexcept
+    {
+        const uint8_t* bytes = data.data();
+        size_t size = data.size();
+        uint32_t state = ~crc;
+
+#if defined(VFSPP_CRC32_CLMUL_ENABLED)
+        if (size >= kFoldMinSize && IsClmulSupported()) {
+            const size_t foldSize = size & ~static_cast<size_t>(15);
+            state = FoldClmul(bytes, foldSize, state);
+            bytes += foldSize;
+            size -= foldSize;
+        }
+#endif
+
+        return ~UpdateSliceBy8(state, bytes, size);
+    }
+
+    /*
+     * Compute checksum of data
+     */
+    [[nodiscard]]
+    static uint32_t Compute(std::span<const uint8_t> data) noexcept
+    {
+        return Update(0, data);
+    }
+
+private:
+    using Table = std::array<std::array<uint32_t, 256>, 8>;
+
+    // Folding has fixed setup cost, small buffers are faster with tables
+    static constexpr size_t kFoldMinSize = 64;
+
+    static constexpr Table MakeTable() noexcept
+    {
+        Table table{};
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t crc = i;
+            for (int bit = 0; bit < 8; ++bit) {
+                crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+            }
+            table[0][i] = crc;
+        }
+        for (uint32_t i = 0; i < 256; ++i) {
+            for (size_t slice = 1; slice < 8; ++slice) {
+                table[slice][i] = (table[slice - 1][i] >> 8) ^ table[0][table[slice - 1][i] & 0xFF];
+            }
+        }
+        return table;
+    }
+
+    static const Table& Tables() noexcept
+    {
+        static constexpr Table kTable = MakeTable();
+        return kTable;
+    }
+
+    static uint32_t UpdateSliceBy8(uint32_t state, const uint8_t* bytes, size_t size) noexcept
+    {
+        const Table& table = Tables();
+
+        // Words are read as little endian, big endian targets use byte loop only
+        while (std::endian::native == std::endian::little && size >= 8) {
+            uint32_t low;
+            uint32_t high;
+            std::memcpy(&low, bytes, 4);
+            std::memcpy(&high, bytes + 4, 4);
+            low ^= state;
+
+            state = table[7][low & 0xFF] ^ table[6][(low >> 8) & 0xFF] ^ table[5][(low >> 16) & 0xFF] ^ table[4][low >> 24] ^
+                    table[3][high & 0xFF] ^ table[2][(high >> 8) & 0xFF] ^ table[1][(high >> 16) & 0xFF] ^ table[0][high >> 24];
+            bytes += 8;
+            size -= 8;
+        }
+
+        while (size > 0) {
+            state = (state >> 8) ^ table[0][(state ^ *bytes) & 0xFF];
+            bytes++;
+            size--;
+        }
+        return state;
+    }
+
+#if defined(VFSPP_CRC32_CLMUL_ENABLED)
+    static bool IsClmulSupported() noexcept
+    {
+        static const bool kIsSupported = [] {
+#if defined(_MSC_VER) && !defined(__clang__)
+            int info[4] = {};
+            __cpuid(info, 1);
+            return (info[2] & (1 << 1)) != 0;
+#else
+            unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+            return __get_cpuid(1, &eax, &ebx, &ecx, &edx) != 0 && (ecx & bit_PCLMUL) != 0;
+#endif
+        }();
+        return kIsSupported;
+    }
+
+    VFSPP_CRC32_CLMUL_TARGET
+    static __m128i Load(const uint8_t* bytes) noexcept
+    {
+        return _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes));
+    }
+
+    // Multiply 128 bits by folding constants and add next 128 bits
+    VFSPP_CRC32_CLMUL_TARGET
+    static __m128i Fold(__m128i value, __m128i next, __m128i constants) noexcept
+    {
+        const __m128i low = _mm_clmulepi64_si128(value, constants, 0x00);
+        const __m128i high = _mm_clmulepi64_si128(value, constants, 0x11);
+        return _mm_xor_si128(_mm_xor_si128(high, low), next);
+    }
+
+    // Fold 64 byte blocks in parallel, then 16 byte blocks, then Barrett reduction to 32 bits.
+    // Size is multiple of 16 and at least 64, state is not inverted
+    VFSPP_CRC32_CLMUL_TARGET
+    static uint32_t FoldClmul(const uint8_t* bytes, size_t size, uint32_t state) noexcept
+    {
+        const __m128i k1k2 = _mm_set_epi64x(0x01c6e41596, 0x0154442bd4);
+        const __m128i k3k4 = _mm_set_epi64x(0x00ccaa009e, 0x01751997d0);
+        const __m128i k5k0 = _mm_set_epi64x(0x0000000000, 0x0163cd6124);
+        const __m128i poly = _mm_set_epi64x(0x01f7011641, 0x01db710641);
+        const __m128i mask32 = _mm_setr_epi32(~0, 0, ~0, 0);
+
+        __m128i x1 = _mm_xor_si128(Load(bytes), _mm_cvtsi32_si128(static_cast<int>(state)));
+        __m128i x2 = Load(bytes + 16);
+        __m128i x3 = Load(bytes + 32);
+        __m128i x4 = Load(bytes + 48);
+        bytes += 64;
+        size -= 64;
+
+        while (size >= 64) {
+            x1 = Fold(x1, Load(bytes), k1k2);
+            x2 = Fold(x2, Load(bytes + 16), k1k2);
+            x3 = Fold(x3, Load(bytes + 32), k1k2);
+            x4 = Fold(x4, Load(bytes + 48), k1k2);
+            bytes += 64;
+            size -= 64;
+        }
+
+        x1 = Fold(x1, x2, k3k4);
+        x1 = Fold(x1, x3, k3k4);
+        x1 = Fold(x1, x4, k3k4);
+
+        while (size >= 16) {
+            x1 = Fold(x1, Load(bytes), k3k4);
+            bytes += 16;
+            size -= 16;
+        }
+
+        // 128 to 64 bits
+        __m128i t = _mm_clmulepi64_si128(x1, k3k4, 0x10);
+        x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), t);
+        t = _mm_srli_si128(x1, 4);
+        x1 = _mm_clmulepi64_si128(_mm_and_si128(x1, mask32), k5k0, 0x00);
+        x1 = _mm_xor_si128(x1, t);
+
+        // Barrett reduction to 32 bits
+        t = _mm_clmulepi64_si128(_mm_and_si128(x1, mask32), poly, 0x10);
+        t = _mm_clmulepi64_si128(_mm_and_si128(t, mask32), poly, 0x00);
+        x1 = _mm_xor_si128(x1, t);
+
+        return static_cast<uint32_t>(_mm_cvtsi128_si32(_mm_srli_si128(x1, 4)));
+    }
+#endif
+};
+
+} // namespace vfspp
+
+#endif // VFSPP_CRC32_HPP
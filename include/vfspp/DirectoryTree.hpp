@@ -0,0 +1,234 @@
+#ifndef VFSPP_DIRECTORYTREE_HPP
+#define VFSPP_DIRECTORYTREE_HPP
+
+#include "Global.h"
+#include "PathNormalizer.hpp"
+
+#include <set>
+
+namespace vfspp
+{
+
+/*
+ * Hash, equality and ordering of paths, case insensitive ones fold ASCII case
+ */
+struct PathHash
+{
+    using is_transparent = void;
+
+    bool IsCaseInsensitive = false;
+
+    size_t operator()(std::string_view path) const noexcept
+    {
+        if (!IsCaseInsensitive) {
+            return std::hash<std::string_view>{}(path);
+        }
+
+        // FNV-1a of folded characters
+        uint64_t hash = 14695981039346656037ull;
+        for (const char c : path) {
+            hash = (hash ^ static_cast<uint8_t>(PathNormalizer::FoldCase(c))) * 1099511628211ull;
+        }
+        return static_cast<size_t>(hash);
+    }
+};
+
+struct PathEqual
+{
+    using is_transparent = void;
+
+    bool IsCaseInsensitive = false;
+
+    bool operator()(std::string_view first, std::string_view second) const noexcept
+    {
+        return IsCaseInsensitive ? PathNormalizer::EqualsFolded(first, second) : first == second;
+    }
+};
+
+struct PathLess
+{
+    using is_transparent = void;
+
+    bool IsCaseInsensitive = false;
+
+    bool operator()(std::string_view first, std::string_view second) const noexcept
+    {
+        return IsCaseInsensitive ? PathNormalizer::LessFolded(first, second) : first < second;
+    }
+};
+
+
+/*
+ * Parent to children index of virtual paths. Directories are implicit, they exist while
+ * they contain at least one file. Child directory names end with '/'.
+ * Case insensitive tree folds ASCII case of paths, directories and children keep case of
+ * first inserted path and children are ordered ignoring case
+ */
+class DirectoryTree final
+{
+public:
+    using Children = std::set<std::string, PathLess>;
+
+public:
+    DirectoryTree() = default;
+
+    explicit DirectoryTree(bool isCaseSensitive)
+        : m_Directories(0, PathHash{ !isCaseSensitive }, PathEqual{ !isCaseSensitive })
+    {
+    }
+
+    [[nodiscard]]
+    bool IsCaseSensitive() const
+    {
+        return !m_Directories.key_eq().IsCaseInsensitive;
+    }
+
+    /*
+     * Check if path starts with prefix, ignoring case in case insensitive tree
+     */
+    [[nodiscard]]
+    bool StartsWith(std::string_view path, std::string_view prefix) const
+    {
+        return IsCaseSensitive() ? path.starts_with(prefix) : PathNormalizer::StartsWithFolded(path, prefix);
+    }
+
+    /*
+     * Add file and all its parent directories
+     */
+    void Insert(std::string_view filePath)
+    {
+        std::string_view path = filePath;
+        while (true) {
+            const auto [directory, name] = Split(path);
+            if (name.empty()) {
+                return;
+            }
+
+            auto [it, isNewDirectory] = m_Directories.try_emplace(std::string(directory), PathLess{ !IsCaseSensitive() });
+            it->second.emplace(name);
+
+            // Parent directories are already linked
+            if (!isNewDirectory || directory.size() <= 1) {
+                return;
+            }
+            path = directory;
+        }
+    }
+
+    /*
+     * Remove file and parent directories left empty
+     */
+    void Erase(std::string_view filePath)
+    {
+        std::string path(filePath);
+        while (true) {
+            const auto [directory, name] = Split(path);
+            if (name.empty()) {
+                return;
+            }
+
+            const auto it = m_Directories.find(directory);
+            if (it == m_Directories.end()) {
+                return;
+            }
+
+            const auto childIt = it->second.find(name);
+            if (childIt != it->second.end()) {
+                it->second.erase(childIt);
+            }
+
+            if (!it->second.empty() || directory.size() <= 1) {
+                return;
+            }
+            path.resize(directory.size());
+            m_Directories.erase(it);
+        }
+    }
+
+    void Clear()
+    {
+        m_Directories.clear();
+    }
+
+    /*
+     * Get direct children of directory, directory path must end with '/'
+     */
+    [[nodiscard]]
+    const Children* Find(std::string_view directoryPath) const
+    {
+        const auto it = m_Directories.find(directoryPath);
+        return it != m_Directories.end() ? &it->second : nullptr;
+    }
+
+    /*
+     * Get directory path as stored in tree, in case insensitive tree it can differ in case
+     * from requested path. Directory path must end with '/'
+     */
+    [[nodiscard]]
+    const std::string* FindPath(std::string_view directoryPath) const
+    {
+        const auto it = m_Directories.find(directoryPath);
+        return it != m_Directories.end() ? &it->first : nullptr;
+    }
+
+    /*
+     * Call visitor with full path of each child, sub directories are visited depth first
+     * if recursive. Paths of directories end with '/', paths have case of stored directory
+     */
+    template<typename Visitor>
+    void Visit(std::string_view directoryPath, bool recursive, Visitor&& visitor) const
+    {
+        const auto it = m_Directories.find(directoryPath);
+        if (it == m_Directories.end()) {
+            return;
+        }
+
+        std::string path(it->first);
+        for (const auto& child : it->second) {
+            path.resize(it->first.size());
+            path += child;
+            visitor(std::string_view(path));
+
+            if (recursive && child.back() == '/') {
+                Visit(path, recursive, visitor);
+            }
+        }
+    }
+
+    /*
+     * Append '/' to directory path if missing
+     */
+    [[nodiscard]]
+    static std::string DirectoryPath(std::string_view path)
+    {
+        std::string directory(path);
+        if (directory.empty() || directory.back() != '/') {
+            directory.push_back('/');
+        }
+        return directory;
+    }
+
+private:
+    // Split "/a/b/c" to "/a/b/" and "c", "/a/b/" to "/a/" and "b/"
+    static std::pair<std::string_view, std::string_view> Split(std::string_view path)
+    {
+        if (path.size() <= 1) {
+            return {};
+        }
+
+        const size_t end = path.back() == '/' ? path.size() - 1 : path.size();
+        const size_t separator = path.rfind('/', end - 1);
+        if (separator == std::string_view::npos) {
+            return {};
+        }
+
+        return { path.substr(0, separator + 1), path.substr(separator + 1) };
+    }
+
+private:
+    std::unordered_map<std::string, Children, PathHash, PathEqual> m_Directories;
+};
+
+} // namespace vfspp
+
+#endif // VFSPP_DIRECTORYTREE_HPP
@@ -0,0 +1,124 @@
+#ifndef VFSPP_EXECUTOR_HPP
+#define VFSPP_EXECUTOR_HPP
+
+#include "Global.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+
+namespace vfspp
+{
+
+using ExecutorPtr = std::shared_ptr<class Executor>;
+using ExecutorWeakPtr = std::weak_ptr<class Executor>;
+
+/*
+ * Runs tasks for parallel work of filesystems. Implement it to use engine job system,
+ * or use ThreadPoolExecutor
+ */
+class Executor
+{
+public:
+    using Task = std::function<void()>;
+
+public:
+    Executor() = default;
+    virtual ~Executor() = default;
+
+    /*
+     * Schedule task, it can run on any thread, including calling one
+     */
+    virtual void Submit(Task task) = 0;
+
+    /*
+     * Get number of tasks that can run at the same time
+     */
+    [[nodiscard]]
+    virtual size_t Concurrency() const = 0;
+};
+
+
+/*
+ * Call func(index) for each index in [0, count) on executor and calling thread, returns
+ * when all calls are finished. Runs serially without executor. Calling thread takes part
+ * in the work, so it's safe to call from executor task. If any call throws, remaining
+ * indices are skipped and first exception is rethrown on calling thread after all
+ * running calls are finished
+ */
+template<typename Func>
+void ParallelFor(Executor* executor, size_t count, Func&& func)
+{
+    const size_t helperCount = executor ? std::min(executor->Concurrency(), count) : 0;
+    if (helperCount <= 1) {
+        for (size_t i = 0; i < count; ++i) {
+            func(i);
+        }
+        return;
+    }
+
+    // Helpers started after all indices are taken exit without touching func,
+    // so only state is shared with them
+    struct State
+    {
+        std::atomic<size_t> Next{ 0 };
+        std::atomic<bool> IsFailed{ false };
+        size_t Completed = 0;
+        std::exception_ptr Error;
+        std::mutex Mutex;
+        std::condition_variable AllCompleted;
+
+        void Fail(std::exception_ptr error)
+        {
+            std::lock_guard lock(Mutex);
+            if (!Error) {
+                Error = std::move(error);
+            }
+            IsFailed.store(true, std::memory_order_release);
+        }
+    };
+    auto state = std::make_shared<State>();
+    auto* body = &func;
+
+    // Skipped and failed indices are counted as completed too, so waiting always ends
+    auto run = [state, body, count]() {
+        size_t completed = 0;
+        for (size_t i = state->Next++; i < count; i = state->Next++) {
+            if (!state->IsFailed.load(std::memory_order_acquire)) {
+                try {
+                    (*body)(i);
+                } catch (...) {
+                    state->Fail(std::current_exception());
+                }
+            }
+            completed++;
+        }
+        if (completed > 0) {
+            std::lock_guard lock(state->Mutex);
+            state->Completed += completed;
+            if (state->Completed == count) {
+                state->AllCompleted.notify_all();
+            }
+        }
+    };
+
+    try {
+        for (size_t i = 1; i < helperCount; ++i) {
+            executor->Submit(run);
+        }
+    } catch (...) {
+        // Submitted helpers may still run func, so calling thread finishes work first
+        state->Fail(std::current_exception());
+    }
+    run();
+
+    std::unique_lock lock(state->Mutex);
+    state->AllCompleted.wait(lock, [&] { return state->Completed == count; });
+    if (state->Error) {
+        std::rethrow_exception(state->Error);
+    }
+}
+
+} // namespace vfspp
+
+#endif // VFSPP_EXECUTOR_HPP
@@ -0,0 +1,70 @@
+#ifndef VFSPP_FILEBUFFER_HPP
+#define VFSPP_FILEBUFFER_HPP
+
+#include "Global.h"
+
+namespace vfspp
+{
+
+/*
+ * Read-only file content. Buffer keeps its storage alive, storage can be own allocation,
+ * data of memory file or memory of archive, so copies of buffer are cheap
+ */
+class FileBuffer final
+{
+public:
+    FileBuffer() = default;
+
+    /*
+     * Reference data kept alive by owner
+     */
+    FileBuffer(std::shared_ptr<const void> owner, std::span<const uint8_t> data)
+        : m_Owner(std::move(owner))
+        , m_Data(data)
+    {
+    }
+
+    /*
+     * Take ownership of vector
+     */
+    explicit FileBuffer(std::shared_ptr<const std::vector<uint8_t>> data)
+        : m_Data(data ? std::span<const uint8_t>(*data) : std::span<const uint8_t>())
+    {
+        m_Owner = std::move(data);
+    }
+
+    [[nodiscard]]
+    std::span<const uint8_t> Data() const
+    {
+        return m_Data;
+    }
+
+    [[nodiscard]]
+    uint64_t Size() const
+    {
+        return m_Data.size();
+    }
+
+    /*
+     * Get object keeping data alive
+     */
+    [[nodiscard]]
+    const std::shared_ptr<const void>& Owner() const
+    {
+        return m_Owner;
+    }
+
+    [[nodiscard]]
+    bool IsEmpty() const
+    {
+        return m_Data.empty();
+    }
+
+private:
+    std::shared_ptr<const void> m_Owner;
+    std::span<const uint8_t> m_Data;
+};
+
+} // namespace vfspp
+
+#endif // VFSPP_FILEBUFFER_HPP
@@ -0,0 +1,92 @@
+#ifndef VFSPP_FILEHANDLE_HPP
+#define VFSPP_FILEHANDLE_HPP
+
+#include "IFile.h"
+
+namespace vfspp
+{
+
+/*
+ * Move-only owner of opened file for callers that don't share handles. Moving handle
+ * never touches reference counter, file is closed when handle is destroyed
+ */
+class FileHandle final
+{
+public:
+    FileHandle() = default;
+
+    explicit FileHandle(IFilePtr&& file) noexcept
+        : m_File(std::move(file))
+    {
+    }
+
+    FileHandle(const FileHandle&) = delete;
+    FileHandle& operator=(const FileHandle&) = delete;
+
+    FileHandle(FileHandle&&) noexcept = default;
+
+    FileHandle& operator=(FileHandle&& other) noexcept
+    {
+        if (this != &other) {
+            Reset();
+            m_File = std::move(other.m_File);
+        }
+        return *this;
+    }
+
+    ~FileHandle()
+    {
+        Reset();
+    }
+
+    /*
+     * Close file and release ownership, returns result of IFile::Close
+     */
+    bool Reset()
+    {
+        if (!m_File) {
+            return true;
+        }
+
+        const bool isClosed = m_File->Close();
+        m_File.reset();
+        return isClosed;
+    }
+
+    /*
+     * Give up ownership without closing file
+     */
+    [[nodiscard]]
+    IFilePtr Release() noexcept
+    {
+        return std::move(m_File);
+    }
+
+    [[nodiscard]]
+    IFile* Get() const noexcept
+    {
+        return m_File.get();
+    }
+
+    IFile* operator->() const noexcept
+    {
+        return m_File.get();
+    }
+
+    IFile& operator*() const noexcept
+    {
+        return *m_File;
+    }
+
+    explicit operator bool() const noexcept
+    {
+        return m_File != nullptr;
+    }
+
+private:
+    IFilePtr m_File;
+};
+
+} // namespace vfspp
+
+#endif // VFSPP_FILEHANDLE_HPP
@@ -0,0 +1,440 @@
+#ifndef VFSPP_FILEINDEX_HPP
+#define VFSPP_FILEINDEX_HPP
+
+#include "Global.h"
+#include "DirectoryTree.hpp"
+#include "GlobPattern.hpp"
+#include "PathNormalizer.hpp"
+#include "ThreadingPolicy.hpp"
+
+namespace vfspp
+{
+
+/*
+ * Files table of filesystem keyed by virtual path. Interface follows std::unordered_map,
+ * every insertion and removal also updates directory tree. Extension and sorted path
+ * indices are built on first query and kept up to date afterwards. Queries are safe to
+ * run concurrently, first one builds indices under mutex of Policy. Single threaded
+ * index has no mutex and no atomic flag.
+ * Case insensitive index hashes and compares keys with ASCII case folded, so lookup is
+ * still single hash probe with hash of stored keys computed once on insertion
+ */
+template<typename Entry, typename Policy = ThreadingPolicy>
+class FileIndex final
+{
+public:
+    using KeyHash = PathHash;
+    using KeyEqual = PathEqual;
+
+    using Map = std::unordered_map<std::string, Entry, KeyHash, KeyEqual>;
+    using value_type = typename Map::value_type;
+    using iterator = typename Map::iterator;
+    using const_iterator = typename Map::const_iterator;
+
+public:
+    FileIndex() = default;
+
+    // Secondary indices reference keys of entries
+    FileIndex(const FileIndex&) = delete;
+    FileIndex& operator=(const FileIndex&) = delete;
+
+    FileIndex(FileIndex&& other) noexcept
+    {
+        *this = std::move(other);
+    }
+
+    FileIndex& operator=(FileIndex&& other) noexcept
+    {
+        m_Entries = std::move(other.m_Entries);
+        m_Tree = std::move(other.m_Tree);
+        m_SortedPaths = std::move(other.m_SortedPaths);
+        m_Extensions = std::move(other.m_Extensions);
+        SetHasSecondaryImpl(other.HasSecondaryImpl(std::memory_order_relaxed), std::memory_order_relaxed);
+        other.SetHasSecondaryImpl(false, std::memory_order_relaxed);
+        return *this;
+    }
+
+    iterator begin() { return m_Entries.begin(); }
+    iterator end() { return m_Entries.end(); }
+    const_iterator begin() const { return m_Entries.begin(); }
+    const_iterator end() const { return m_Entries.end(); }
+
+    [[nodiscard]] size_t size() const { return m_Entries.size(); }
+    [[nodiscard]] bool empty() const { return m_Entries.empty(); }
+
+    iterator find(const std::string& virtualPath) { return m_Entries.find(virtualPath); }
+    const_iterator find(const std::string& virtualPath) const { return m_Entries.find(virtualPath); }
+
+    template<typename... Args>
+    std::pair<iterator, bool> try_emplace(const std::string& virtualPath, Args&&... args)
+    {
+        auto result = m_Entries.try_emplace(virtualPath, std::forward<Args>(args)...);
+        if (result.second) {
+            m_Tree.Insert(virtualPath);
+            if (HasSecondaryImpl(std::memory_order_relaxed)) {
+                InsertSecondaryImpl(result.first->first);
+            }
+        }
+        return result;
+    }
+
+    template<typename... Args>
+    std::pair<iterator, bool> emplace(const std::string& virtualPath, Args&&... args)
+    {
+        return try_emplace(virtualPath, std::forward<Args>(args)...);
+    }
+
+    std::pair<iterator, bool> insert(value_type&& value)
+    {
+        return try_emplace(value.first, std::move(value.second));
+    }
+
+    iterator erase(iterator it)
+    {
+        m_Tree.Erase(it->first);
+        if (HasSecondaryImpl(std::memory_order_relaxed)) {
+            EraseSecondaryImpl(it->first);
+        }
+        return m_Entries.erase(it);
+    }
+
+    size_t erase(const std::string& virtualPath)
+    {
+        const auto it = m_Entries.find(virtualPath);
+        if (it == m_Entries.end()) {
+            return 0;
+        }
+        erase(it);
+        return 1;
+    }
+
+    /*
+     * Switch case sensitivity of lookups, index is rebuilt. Returns false and keeps index
+     * unchanged if paths differ only by case, paths colliding with other path are added
+     * to outCollisions.
+     * Files inserted to case insensitive index later are skipped if path differs by case only
+     */
+    bool SetCaseSensitive(bool isCaseSensitive, std::vector<std::string>* outCollisions = nullptr)
+    {
+        if (isCaseSensitive == IsCaseSensitive()) {
+            return true;
+        }
+
+        if (!isCaseSensitive && !CheckFoldedCollisionsImpl(outCollisions)) {
+            return false;
+        }
+
+        Map entries(m_Entries.bucket_count(), KeyHash{ !isCaseSensitive }, KeyEqual{ !isCaseSensitive });
+        DirectoryTree tree(isCaseSensitive);
+        while (!m_Entries.empty()) {
+            auto result = entries.insert(m_Entries.extract(m_Entries.begin()));
+            tree.Insert(result.position->first);
+        }
+        m_Entries = std::move(entries);
+        m_Tree = std::move(tree);
+
+        // Secondary indices are ordered by case mode, rebuilt on next query
+        m_SortedPaths.clear();
+        m_Extensions.clear();
+        SetHasSecondaryImpl(false, std::memory_order_relaxed);
+        return true;
+    }
+
+    [[nodiscard]]
+    bool IsCaseSensitive() const
+    {
+        return !m_Entries.hash_function().IsCaseInsensitive;
+    }
+
+    void clear()
+    {
+        m_Entries.clear();
+        m_Tree.Clear();
+        m_SortedPaths.clear();
+        m_Extensions.clear();
+        SetHasSecondaryImpl(false, std::memory_order_relaxed);
+    }
+
+    /*
+     * Get directory tree of indexed files
+     */
+    [[nodiscard]]
+    const DirectoryTree& Tree() const
+    {
+        return m_Tree;
+    }
+
+    /*
+     * List directory content, paths of directories end with '/'
+     */
+    [[nodiscard]]
+    std::vector<std::string> ListDirectory(std::string_view virtualPath, bool recursive) const
+    {
+        std::vector<std::string> result;
+        m_Tree.Visit(DirectoryTree::DirectoryPath(virtualPath), recursive, [&](std::string_view path) {
+            result.emplace_back(path);
+        });
+        return result;
+    }
+
+    /*
+     * Call visitor with virtual path of each file in directory and its subdirectories,
+     * visited in sorted order
+     */
+    template<typename Visitor>
+    void ForEachWithPrefix(std::string_view directoryPath, Visitor&& visitor) const
+    {
+        BuildSecondaryImpl();
+        ForEachInRange(m_SortedPaths, directoryPath, visitor);
+    }
+
+    /*
+     * Call visitor with virtual path of each file with extension located in directory or
+     * its subdirectories, visited in sorted order. Extension includes leading dot and
+     * is case insensitive
+     */
+    template<typename Visitor>
+    void ForEachWithExtension(std::string_view extension, std::string_view directoryPath, Visitor&& visitor) const
+    {
+        BuildSecondaryImpl();
+        const auto it = m_Extensions.find(LowercaseExtension(extension));
+        if (it != m_Extensions.end()) {
+            ForEachInRange(it->second, directoryPath, visitor);
+        }
+    }
+
+    /*
+     * Find files matching pattern, only directories matching pattern are visited.
+     * Returns sorted virtual paths
+     */
+    [[nodiscard]]
+    std::vector<std::string> Find(const GlobPattern& pattern) const
+    {
+        std::vector<std::string> result;
+        if (FindIndexedImpl(pattern, result)) {
+            return result;
+        }
+
+        // Paths of case insensitive index are reported with stored case
+        std::string directory = pattern.Directory();
+        if (const std::string* storedDirectory = m_Tree.FindPath(directory)) {
+            directory = *storedDirectory;
+        }
+        FindImpl(pattern, pattern.DirectoryComponents(), directory, result);
+
+        // Pattern with several "**" can match same file more than once
+        std::sort(result.begin(), result.end());
+        result.erase(std::unique(result.begin(), result.end()), result.end());
+        return result;
+    }
+
+private:
+    using SortedPaths = std::set<std::string_view, PathLess>;
+
+    static constexpr bool kIsSynchronized = !std::is_same_v<Policy, SingleThreadedPolicy>;
+    using SecondaryFlag = std::conditional_t<kIsSynchronized, std::atomic<bool>, bool>;
+
+    bool HasSecondaryImpl(std::memory_order order) const
+    {
+        if constexpr (kIsSynchronized) {
+            return m_HasSecondaryIndices.load(order);
+        } else {
+            return m_HasSecondaryIndices;
+        }
+    }
+
+    void SetHasSecondaryImpl(bool hasIndices, std::memory_order order) const
+    {
+        if constexpr (kIsSynchronized) {
+            m_HasSecondaryIndices.store(hasIndices, order);
+        } else {
+            m_HasSecondaryIndices = hasIndices;
+        }
+    }
+
+    bool CheckFoldedCollisionsImpl(std::vector<std::string>* outCollisions) const
+    {
+        std::unordered_set<std::string_view, KeyHash, KeyEqual> folded(m_Entries.size(), KeyHash{ true }, KeyEqual{ true });
+        bool isUnique = true;
+        for (const auto& [path, entry] : m_Entries) {
+            if (!folded.insert(path).second) {
+                isUnique = false;
+                if (!outCollisions) {
+                    break;
+                }
+                outCollisions->emplace_back(path);
+            }
+        }
+        return isUnique;
+    }
+
+    // Subtree queries "dir/**/*" and "dir/**/*.ext" are answered from secondary indices
+    bool FindIndexedImpl(const GlobPattern& pattern, std::vector<std::string>& outFiles) const
+    {
+        const auto& components = pattern.Components();
+        const size_t first = pattern.DirectoryComponents();
+        if (components.size() != first + 2 || components[first] != "**") {
+            return false;
+        }
+
+        const std::string& name = components.back();
+        if (name == "*") {
+            ForEachWithPrefix(pattern.Directory(), [&](std::string_view path) {
+                outFiles.emplace_back(path);
+            });
+            return true;
+        }
+
+        const size_t dot = name.rfind('.');
+        if (dot == std::string::npos || dot == 0 || GlobPattern::HasWildcards(std::string_view(name).substr(dot))) {
+            return false;
+        }
+
+        ForEachWithExtension(std::string_view(name).substr(dot), pattern.Directory(), [&](std::string_view path) {
+            if (GlobPattern::MatchComponent(name, path.substr(path.rfind('/') + 1), IsCaseSensitive())) {
+                outFiles.emplace_back(path);
+            }
+        });
+        return true;
+    }
+
+    template<typename Visitor>
+    void ForEachInRange(const SortedPaths& paths, std::string_view prefix, Visitor& visitor) const
+    {
+        for (auto it = paths.lower_bound(prefix); it != paths.end() && m_Tree.StartsWith(*it, prefix); ++it) {
+            visitor(*it);
+        }
+    }
+
+    // Mutations run exclusively, so only concurrent queries race to build indices
+    void BuildSecondaryImpl() const
+    {
+        if (HasSecondaryImpl(std::memory_order_acquire)) {
+            return;
+        }
+
+        [[maybe_unused]] auto lock = Policy::Lock(m_BuildMutex);
+        if (HasSecondaryImpl(std::memory_order_relaxed)) {
+            return;
+        }
+
+        m_SortedPaths = SortedPaths(PathLess{ !IsCaseSensitive() });
+        for (const auto& [path, entry] : m_Entries) {
+            InsertSecondaryImpl(path);
+        }
+        SetHasSecondaryImpl(true, std::memory_order_release);
+    }
+
+    void InsertSecondaryImpl(std::string_view path) const
+    {
+        m_SortedPaths.insert(path);
+
+        const std::string extension = FileExtension(path);
+        if (!extension.empty()) {
+            m_Extensions.try_emplace(extension, PathLess{ !IsCaseSensitive() }).first->second.insert(path);
+        }
+    }
+
+    void EraseSecondaryImpl(std::string_view path) const
+    {
+        m_SortedPaths.erase(path);
+
+        const auto it = m_Extensions.find(FileExtension(path));
+        if (it != m_Extensions.end()) {
+            it->second.erase(path);
+            if (it->second.empty()) {
+                m_Extensions.erase(it);
+            }
+        }
+    }
+
+    // Lowercase extension of file name with leading dot. Name like ".cfg" is its own
+    // extension, since "*.cfg" matches it
+    static std::string FileExtension(std::string_view path)
+    {
+        const auto name = path.substr(path.rfind('/') + 1);
+        const size_t dot = name.rfind('.');
+        if (dot == std::string_view::npos) {
+            return {};
+        }
+        return LowercaseExtension(name.substr(dot));
+    }
+
+    static std::string LowercaseExtension(std::string_view extension)
+    {
+        std::string result(extension);
+        std::transform(result.begin(), result.end(), result.begin(), [](unsigned char c) {
+            return static_cast<char>(std::tolower(c));
+        });
+        return result;
+    }
+
+    void FindImpl(const GlobPattern& pattern, size_t index, std::string& directory, std::vector<std::string>& outFiles) const
+    {
+        const auto& components = pattern.Components();
+        if (index >= components.size()) {
+            return;
+        }
+
+        const DirectoryTree::Children* children = m_Tree.Find(directory);
+        if (!children) {
+            return;
+        }
+
+        const std::string& component = components[index];
+        const bool isLast = index + 1 == components.size();
+        const size_t directoryLength = directory.size();
+
+        auto visitChild = [&](const std::string& child, size_t nextIndex) {
+            const bool isDirectory = child.back() == '/';
+            if (!isDirectory && isLast) {
+                outFiles.push_back(directory + child);
+            } else if (isDirectory && !isLast) {
+                directory += child;
+                FindImpl(pattern, nextIndex, directory, outFiles);
+                directory.resize(directoryLength);
+            }
+        };
+
+        if (component == "**") {
+            // Zero directories, then one or more directories
+            FindImpl(pattern, index + 1, directory, outFiles);
+            for (const auto& child : *children) {
+                if (child.back() == '/') {
+                    visitChild(child, index);
+                }
+            }
+            return;
+        }
+
+        if (!GlobPattern::HasWildcards(component)) {
+            const auto it = children->find(isLast ? component : component + '/');
+            if (it != children->end()) {
+                visitChild(*it, index + 1);
+            }
+            return;
+        }
+
+        // Children are sorted, so only range starting with literal prefix is checked
+        const std::string_view prefix = std::string_view(component).substr(0, component.find_first_of("*?"));
+        for (auto it = children->lower_bound(prefix); it != children->end() && m_Tree.StartsWith(*it, prefix); ++it) {
+            const std::string_view name = it->back() == '/' ? std::string_view(*it).substr(0, it->size() - 1) : std::string_view(*it);
+            if (GlobPattern::MatchComponent(component, name, IsCaseSensitive())) {
+                visitChild(*it, index + 1);
+            }
+        }
+    }
+
+private:
+    Map m_Entries;
+    DirectoryTree m_Tree;
+
+    mutable SecondaryFlag m_HasSecondaryIndices = false;
+    [[no_unique_address]] mutable typename Policy::Mutex m_BuildMutex;
+    mutable SortedPaths m_SortedPaths;
+    mutable std::unordered_map<std::string, SortedPaths> m_Extensions;
+};
+
+} // namespace vfspp
+
+#endif // VFSPP_FILEINDEX_HPP
@@ -2,6 +2,7 @@
 #define VFSPP_FILEINFO_HPP
 
 #include "Global.h"
+#include "PathNormalizer.hpp"
 
 #ifdef VFSPP_DISABLE_STD_FILESYSTEM
 #include "FilesystemCompat.hpp"
@@ -76,27 +77,47 @@ private:
     void Configure(const std::string& aliasPath, const std::string& basePath, const std::string& fileName)
     {
         // Remove alias or base path from file name if any
-        std::string strippedFileName = fileName;
-        if (!aliasPath.empty() && fileName.find(aliasPath) == 0) {
-            strippedFileName = fileName.substr(aliasPath.length());
-        } else if (!basePath.empty() && fileName.find(basePath) == 0) {
-            strippedFileName = fileName.substr(basePath.length());
+        std::string_view strippedFileName = fileName;
+        if (!aliasPath.empty() && strippedFileName.starts_with(aliasPath)) {
+            strippedFileName.remove_prefix(aliasPath.length());
+        } else if (!basePath.empty() && strippedFileName.starts_with(basePath)) {
+            strippedFileName.remove_prefix(basePath.length());
         }
 
         // Strip leading separators
         while (!strippedFileName.empty() && (strippedFileName.front() == '/' || strippedFileName.front() == '\\')) {
-            strippedFileName.erase(strippedFileName.begin());
+            strippedFileName.remove_prefix(1);
         }
 
-        const auto filePath = fs::path(strippedFileName);
+        // Virtual path is normalized, native path keeps file name as is
+        const auto normalized = PathNormalizer::Normalize(strippedFileName);
+        m_Filepath = normalized ? normalized->substr(1) : std::string(strippedFileName);
+        m_VirtualPath = JoinPath(aliasPath, m_Filepath);
+        m_NativePath = JoinPath(basePath, strippedFileName);
 
-        m_Filepath = filePath.generic_string();
-        m_VirtualPath = (fs::path(aliasPath) / filePath).generic_string();
-        m_NativePath = (fs::path(basePath) / filePath).generic_string();
+        const size_t separator = m_Filepath.find_last_of('/');
+        m_Filename = (separator == std::string::npos) ? m_Filepath : m_Filepath.substr(separator + 1);
 
-        m_Filename = filePath.filename().string();
-        m_Extension = filePath.has_extension() ? filePath.extension().string() : "";
-        m_BaseFilename = filePath.stem().string();
+        const size_t dot = m_Filename.find_last_of('.');
+        if (dot == std::string::npos || dot == 0 || m_Filename == "..") {
+            m_BaseFilename = m_Filename;
+            m_Extension.clear();
+        } else {
+            m_BaseFilename = m_Filename.substr(0, dot);
+            m_Extension = m_Filename.substr(dot);
+        }
+    }
+
+    static std::string JoinPath(std::string_view directory, std::string_view fileName)
+    {
+        std::string path;
+        path.reserve(directory.size() + fileName.size() + 1);
+        path.append(directory);
+        if (!path.empty() && path.back() != '/' && path.back() != '\\' && !fileName.empty()) {
+            path.push_back('/');
+        }
+        path.append(fileName);
+        return path;
     }
     
 private:
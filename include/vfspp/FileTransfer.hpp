@@ -0,0 +1,73 @@
+#ifndef VFSPP_FILETRANSFER_HPP
+#define VFSPP_FILETRANSFER_HPP
+
+#include "IFileSystem.h"
+
+namespace vfspp
+{
+
+/*
+ * Copy data between filesystems, used by filesystems layered over other filesystems
+ */
+class FileTransfer final
+{
+public:
+    static constexpr size_t kChunkSize = 1024 * 1024;
+
+    /*
+     * Write content of source file to target file opened for writing. Compressed file is
+     * inflated once, mapped file is written directly, other files are copied by ranges
+     * without reading whole file to memory
+     */
+    [[nodiscard]]
+    static bool Copy(IFileSystem& source, const std::string& virtualPath, IFile& target)
+    {
+        const auto stat = source.Stat(virtualPath);
+        if (!stat) {
+            return false;
+        }
+
+        if (stat->CompressionMethod != 0) {
+            const auto buffer = source.ReadAll(virtualPath);
+            return buffer && target.Write(buffer->Data()) == buffer->Size();
+        }
+
+        IFilePtr file = source.OpenFile(virtualPath, IFile::FileMode::Read | IFile::FileMode::ExclusiveOwner);
+        if (!file) {
+            return false;
+        }
+
+        const bool isCopied = CopyRanges(*file, target);
+        source.CloseFile(file);
+        return isCopied;
+    }
+
+    /*
+     * Write content of source file to target file opened for writing by ranges, mapped
+     * content is written at once
+     */
+    [[nodiscard]]
+    static bool CopyRanges(IFile& source, IFile& target)
+    {
+        if (const auto data = source.MappedData()) {
+            return target.Write(data->Data()) == data->Size();
+        }
+
+        const uint64_t size = source.Size();
+        std::vector<uint8_t> chunk(static_cast<size_t>(std::min<uint64_t>(size, kChunkSize)));
+
+        for (uint64_t offset = 0; offset < size;) {
+            const auto count = static_cast<size_t>(std::min<uint64_t>(chunk.size(), size - offset));
+            const auto data = std::span<uint8_t>(chunk.data(), count);
+            if (source.ReadAt(offset, data) != count || target.Write(data) != count) {
+                return false;
+            }
+            offset += count;
+        }
+        return true;
+    }
+};
+
+} // namespace vfspp
+
+#endif // VFSPP_FILETRANSFER_HPP
@@ -332,6 +332,54 @@ inline bool remove(const std::string& p)
     return remove(path(p));
 }
 
+inline bool remove(const path& p, std::error_code& ec)
+{
+    if (::remove(p.generic_string().c_str()) != 0) {
+        // Missing file isn't an error, same as std::filesystem::remove
+        if (errno == ENOENT) {
+            ec.clear();
+        } else {
+            ec = std::error_code(errno, std::generic_category());
+        }
+        return false;
+    }
+    ec.clear();
+    return true;
+}
+
+inline bool remove(const std::string& p, std::error_code& ec)
+{
+    return remove(path(p), ec);
+}
+
+inline bool create_directories(const path& p, std::error_code& ec)
+{
+    ec.clear();
+    const std::string full = p.generic_string();
+    bool isCreated = false;
+
+    // Create each missing directory from root down
+    for (size_t end = full.find('/', 1); ; end = full.find('/', end + 1)) {
+        const std::string directory = full.substr(0, end);
+        if (!directory.empty() && !is_directory(directory)) {
+            if (::mkdir(directory.c_str(), 0777) != 0 && errno != EEXIST) {
+                ec = std::error_code(errno, std::generic_category());
+                return false;
+            }
+            isCreated = true;
+        }
+        if (end == std::string::npos) {
+            break;
+        }
+    }
+    return isCreated;
+}
+
+inline bool create_directories(const std::string& p, std::error_code& ec)
+{
+    return create_directories(path(p), ec);
+}
+
 class directory_entry
 {
 public:
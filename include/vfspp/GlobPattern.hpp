@@ -0,0 +1,133 @@
+#ifndef VFSPP_GLOBPATTERN_HPP
+#define VFSPP_GLOBPATTERN_HPP
+
+#include "Global.h"
+#include "PathNormalizer.hpp"
+
+#include <string_view>
+
+namespace vfspp
+{
+
+/*
+ * Path pattern split to components. Component can contain '*' (any characters except '/')
+ * and '?' (single character except '/'), component "**" matches zero or more directories.
+ * Relative patterns are matched from root
+ */
+class GlobPattern final
+{
+public:
+    explicit GlobPattern(std::string_view pattern)
+    {
+        size_t begin = 0;
+        while (begin <= pattern.size()) {
+            size_t end = pattern.find('/', begin);
+            if (end == std::string_view::npos) {
+                end = pattern.size();
+            }
+
+            const auto component = pattern.substr(begin, end - begin);
+            if (!component.empty()) {
+                // Consecutive "**" are same as single one
+                if (!(component == "**" && !m_Components.empty() && m_Components.back() == "**")) {
+                    m_Components.emplace_back(component);
+                }
+            }
+            begin = end + 1;
+        }
+
+        // Trailing "**" matches all files of all subdirectories
+        if (!m_Components.empty() && m_Components.back() == "**") {
+            m_Components.emplace_back("*");
+        }
+
+        // Leading components without wildcards form directory to start search from
+        m_Directory = "/";
+        for (; m_LiteralCount + 1 < m_Components.size() && !HasWildcards(m_Components[m_LiteralCount]); m_LiteralCount++) {
+            m_Directory += m_Components[m_LiteralCount];
+            m_Directory += '/';
+        }
+    }
+
+    /*
+     * Get pattern components
+     */
+    [[nodiscard]]
+    const std::vector<std::string>& Components() const
+    {
+        return m_Components;
+    }
+
+    /*
+     * Get deepest directory all matches are located in, ends with '/'
+     */
+    [[nodiscard]]
+    const std::string& Directory() const
+    {
+        return m_Directory;
+    }
+
+    /*
+     * Get number of leading components covered by Directory()
+     */
+    [[nodiscard]]
+    size_t DirectoryComponents() const
+    {
+        return m_LiteralCount;
+    }
+
+    /*
+     * Check is single path component matches pattern component, case insensitive match
+     * ignores ASCII case
+     */
+    [[nodiscard]]
+    static bool MatchComponent(std::string_view pattern, std::string_view name, bool isCaseSensitive = true)
+    {
+        // Iterative wildcard matching with single backtrack point
+        size_t p = 0;
+        size_t n = 0;
+        size_t starPattern = std::string_view::npos;
+        size_t starName = 0;
+
+        while (n < name.size()) {
+            if (p < pattern.size() && (pattern[p] == '?' || EqualChars(pattern[p], name[n], isCaseSensitive))) {
+                p++;
+                n++;
+            } else if (p < pattern.size() && pattern[p] == '*') {
+                starPattern = p++;
+                starName = n;
+            } else if (starPattern != std::string_view::npos) {
+                p = starPattern + 1;
+                n = ++starName;
+            } else {
+                return false;
+            }
+        }
+
+        while (p < pattern.size() && pattern[p] == '*') {
+            p++;
+        }
+        return p == pattern.size();
+    }
+
+    [[nodiscard]]
+    static bool HasWildcards(std::string_view component)
+    {
+        return component.find_first_of("*?") != std::string_view::npos;
+    }
+
+private:
+    static bool EqualChars(char first, char second, bool isCaseSensitive)
+    {
+        return isCaseSensitive ? first == second : PathNormalizer::FoldCase(first) == PathNormalizer::FoldCase(second);
+    }
+
+private:
+    std::vector<std::string> m_Components;
+    std::string m_Directory;
+    size_t m_LiteralCount = 0;
+};
+
+} // namespace vfspp
+
+#endif // VFSPP_GLOBPATTERN_HPP
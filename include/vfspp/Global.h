@@ -23,13 +23,25 @@
 #include <cstring>
 #include <limits>
 #include <span>
+#include <array>
 #include <type_traits>
 #include <unordered_set>
 #include <system_error>
 #include <cstdio>
 #include <cerrno>
+#include <ctime>
 #ifndef VFSPP_DISABLE_STD_FILESYSTEM
 #include <filesystem>
 #endif
 
+// Positional file IO (pread and friends), define VFSPP_DISABLE_POSIX_IO to fallback to stdio only
+#if (defined(__unix__) || defined(__APPLE__)) && !defined(VFSPP_DISABLE_POSIX_IO)
+#define VFSPP_POSIX_IO_ENABLED
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#endif
+
 #endif // VFSPP_GLOBAL_H
\ No newline at end of file
@@ -3,6 +3,7 @@
 
 #include "Global.h"
 #include "FileInfo.hpp"
+#include "FileBuffer.hpp"
 
 #include <span>
 
@@ -34,7 +35,9 @@ public:
         Write = (1 << 1),
         ReadWrite = Read | Write,
         Append = (1 << 2),
-        Truncate = (1 << 3)
+        Truncate = (1 << 3),
+        ExclusiveOwner = (1 << 4), // Handle is used by single thread, calls are not synchronized
+        VerifyChecksum = (1 << 5) // Reads through file cursor verify checksum stored by archive, last read fails on mismatch
     };
     
 public:
@@ -66,15 +69,23 @@ public:
     virtual bool Open(FileMode mode) = 0;
     
     /*
-     * Close file
+     * Close file. Returns false if data written to file couldn't be stored, then written
+     * data is kept and file stays opened, so closing can be retried
      */
-    virtual void Close() = 0;
+    virtual bool Close() = 0;
     
     /*
      * Check is file ready for reading/writing
      */
     [[nodiscard]]
     virtual bool IsOpened() const = 0;
+
+    /*
+     * Check if data read in VerifyChecksum mode didn't match checksum stored by archive,
+     * then reads return 0 until file is reopened. Files without checksums are never corrupted
+     */
+    [[nodiscard]]
+    virtual bool IsCorrupted() const = 0;
     
     /*
      * Seek on a file
@@ -97,6 +108,17 @@ public:
      */
     virtual uint64_t Read(std::vector<uint8_t>& buffer, uint64_t size) = 0;
 
+    /*
+     * Read data from absolute offset to buffer, doesn't move file cursor
+     */
+    virtual uint64_t ReadAt(uint64_t offset, std::span<uint8_t> buffer) = 0;
+
+    /*
+     * Read consecutive data from file to several buffers filled in order, moves file cursor.
+     * Returns total number of bytes read
+     */
+    virtual uint64_t ReadV(std::span<const std::span<uint8_t>> buffers) = 0;
+
     /*
      * Write buffer data to file
      */
@@ -107,6 +129,16 @@ public:
      */
     virtual uint64_t Write(const std::vector<uint8_t>& buffer) = 0;
 
+    /*
+     * Get whole file content if it's available in memory without copying, e.g. data of
+     * memory file or stored entry of mapped archive. Buffer keeps memory alive
+     */
+    [[nodiscard]]
+    virtual std::optional<FileBuffer> MappedData()
+    {
+        return std::nullopt;
+    }
+
     /*
     * Helpers to check if mode has specific flag
     */
@@ -140,6 +172,14 @@ public:
     }
 };
     
+/*
+ * Check is weak pointer refers to file, doesn't lock weak pointer
+ */
+inline bool IsSameFile(const IFileWeakPtr& weak, const IFilePtr& file) noexcept
+{
+    return !weak.owner_before(file) && !file.owner_before(weak);
+}
+
 inline bool operator==(IFilePtr f1, IFilePtr f2)
 {
     if (!f1 || !f2) {
@@ -2,6 +2,9 @@
 #define VFSPP_IFILESYSTEM_H
 
 #include "IFile.h"
+#include "GlobPattern.hpp"
+#include "FileBuffer.hpp"
+#include "Executor.hpp"
 
 namespace vfspp
 {
@@ -9,10 +12,24 @@ namespace vfspp
 using IFileSystemPtr = std::shared_ptr<class IFileSystem>;
 using IFileSystemWeakPtr = std::weak_ptr<class IFileSystem>;
 
+/*
+ * File metadata available without opening file
+ */
+struct FileStat
+{
+    uint64_t Size = 0;
+    std::time_t ModifiedTime = 0; // 0 if unknown
+    uint16_t CompressionMethod = 0; // Zip compression method, 0 for uncompressed files
+    uint64_t CompressedSize = 0; // Equal to size for uncompressed files
+    IFileSystemPtr FileSystem; // Filesystem file is resolved from, set by VirtualFileSystem
+    std::optional<uint64_t> ContentHash; // Set by VirtualFileSystem with up to date content index
+};
+
 class IFileSystem
 {
 public:
     using FilesList = std::vector<FileInfo>;
+    using FileVisitor = std::function<bool(const FileInfo&)>;
     
 public:
     IFileSystem() = default;
@@ -27,6 +44,23 @@ public:
      * Shutdown filesystem
      */
     virtual void Shutdown() = 0;
+
+    /*
+     * Set executor for parallel work, e.g. initialization. Filesystem works serially
+     * without executor
+     */
+    virtual void SetExecutor(ExecutorPtr executor) = 0;
+
+    /*
+     * Switch case sensitivity of file lookups, filesystems are case sensitive by default.
+     * Returns false and keeps mode if paths of files differ only by case
+     */
+    virtual bool SetCaseSensitive(bool isCaseSensitive) = 0;
+
+    /*
+     * Check if file lookups are case sensitive
+     */
+    virtual bool IsCaseSensitive() const = 0;
     
     /*
      * Check if filesystem is initialized
@@ -51,6 +85,25 @@ public:
      */
     [[nodiscard]]
     virtual FilesList GetFilesList() const = 0;
+
+    /*
+     * Call visitor for each file without copying file list, order is unspecified.
+     * Enumeration stops when visitor returns false. Visitor must not call filesystem
+     */
+    virtual void ForEachFile(const FileVisitor& visitor) const = 0;
+
+    /*
+     * List files and directories of directory, recursive listing includes content of
+     * all subdirectories. Returns virtual paths, paths of directories end with '/'
+     */
+    [[nodiscard]]
+    virtual std::vector<std::string> ListDirectory(const std::string& virtualPath, bool recursive = false) const = 0;
+
+    /*
+     * Find files matching pattern. Returns sorted virtual paths
+     */
+    [[nodiscard]]
+    virtual std::vector<std::string> FindFiles(const GlobPattern& pattern) const = 0;
     
     /*
      * Check is readonly filesystem
@@ -64,9 +117,9 @@ public:
     virtual IFilePtr OpenFile(const std::string& virtualPath, IFile::FileMode mode) = 0;
     
     /*
-     * Close file
+     * Close file. Returns false if data written to file couldn't be stored, see IFile::Close
      */
-    virtual void CloseFile(IFilePtr file) = 0;
+    virtual bool CloseFile(IFilePtr file) = 0;
 
     /*
      * Create file on writeable filesystem. Return true if file already exists
@@ -93,6 +146,18 @@ public:
      */
     [[nodiscard]]
     virtual bool IsFileExists(const std::string& virtualPath) const = 0;
+
+    /*
+     * Get file metadata without opening file
+     */
+    [[nodiscard]]
+    virtual std::optional<FileStat> Stat(const std::string& virtualPath) const = 0;
+
+    /*
+     * Read whole file without opening file object, buffer may reference filesystem data
+     */
+    [[nodiscard]]
+    virtual std::optional<FileBuffer> ReadAll(const std::string& virtualPath) const = 0;
 };
 
 }; // namespace vfspp
@@ -7,31 +7,48 @@
 namespace vfspp
 {
 
-using MemoryFileObjectPtr = std::shared_ptr<class MemoryFileObject>;
-using MemoryFileObjectWeakPtr = std::weak_ptr<class MemoryFileObject>;
+template<typename Policy>
+class BasicMemoryFileObject;
 
-using MemoryFilePtr = std::shared_ptr<class MemoryFile>;
-using MemoryFileWeakPtr = std::weak_ptr<class MemoryFile>;
+using MemoryFileObject = BasicMemoryFileObject<ThreadingPolicy>;
+using MemoryFileObjectPtr = std::shared_ptr<MemoryFileObject>;
+using MemoryFileObjectWeakPtr = std::weak_ptr<MemoryFileObject>;
 
-class MemoryFileObject
+template<typename Policy, typename ObjectPolicy = Policy>
+class BasicMemoryFile;
+
+using MemoryFile = BasicMemoryFile<ThreadingPolicy>;
+using MemoryFilePtr = std::shared_ptr<MemoryFile>;
+using MemoryFileWeakPtr = std::weak_ptr<MemoryFile>;
+
+// Handle owned by single thread, calls are not synchronized. Its content is shared with
+// other handles of filesystem, so it's synchronized by filesystem policy
+using ExclusiveMemoryFile = BasicMemoryFile<SingleThreadedPolicy, ThreadingPolicy>;
+
+/*
+ * Content of memory file shared by its handles, calls are synchronized by Policy
+ */
+template<typename Policy>
+class BasicMemoryFileObject
 {
-    friend class MemoryFile;
-    friend class MemoryFileSystem;
+    template<typename, typename> friend class BasicMemoryFile;
+    template<typename> friend class BasicMemoryFileSystem;
 
     using DataPtr = std::shared_ptr<std::vector<uint8_t>>;
 
 public:
-    MemoryFileObject()
+    BasicMemoryFileObject()
         : m_Data(std::make_shared<std::vector<uint8_t>>())
+        , m_ModifiedTime(std::time(nullptr))
     {
     }
 
-    MemoryFileObject(const MemoryFileObject& other)
+    BasicMemoryFileObject(const BasicMemoryFileObject& other)
     {
         CopyFrom(other);
     }
 
-    MemoryFileObject& operator=(const MemoryFileObject& other)
+    BasicMemoryFileObject& operator=(const BasicMemoryFileObject& other)
     {
         if (this != &other) {
             CopyFrom(other);
@@ -43,7 +60,7 @@ public:
     [[nodiscard]]
     DataPtr GetData() const noexcept
     {
-        std::lock_guard<std::mutex> lock(m_Mutex);
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
         return m_Data;
     }
 
@@ -51,7 +68,8 @@ public:
     [[nodiscard]]
     DataPtr GetWritableData()
     {
-        std::lock_guard<std::mutex> lock(m_Mutex);
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
+        m_ModifiedTime = std::time(nullptr);
         if (!m_Data || m_Data.use_count() == 1) {
             return m_Data;
         }
@@ -62,43 +80,62 @@ public:
 
     void Reset() noexcept
     {
-        std::lock_guard<std::mutex> lock(m_Mutex);
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
         m_Data = std::make_shared<std::vector<uint8_t>>();
+        m_ModifiedTime = std::time(nullptr);
+    }
+
+    // Time of last write access
+    [[nodiscard]]
+    std::time_t ModifiedTime() const noexcept
+    {
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
+        return m_ModifiedTime;
     }
 
-    void CopyFrom(const MemoryFileObject& other)
+    void CopyFrom(const BasicMemoryFileObject& other)
     {
         auto otherData = other.GetData();
-        std::lock_guard<std::mutex> lock(m_Mutex);
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
         if (!otherData) {
             m_Data = std::make_shared<std::vector<uint8_t>>();
         } else {
             m_Data = std::make_shared<std::vector<uint8_t>>(*otherData);
         }
+        m_ModifiedTime = std::time(nullptr);
     }
 
 private:
-    mutable std::mutex m_Mutex;
+    [[no_unique_address]] mutable typename Policy::Mutex m_Mutex;
     DataPtr m_Data;
+    std::time_t m_ModifiedTime = 0;
 };
 
 
 
-class MemoryFile final : public IFile
+/*
+ * File of memory filesystem, calls are synchronized by Policy and access to content
+ * shared with other handles by ObjectPolicy
+ */
+template<typename Policy, typename ObjectPolicy>
+class BasicMemoryFile final : public IFile
 {
-    friend class MemoryFileSystem;
+    template<typename> friend class BasicMemoryFileSystem;
+
+    using FileObject = BasicMemoryFileObject<ObjectPolicy>;
+    using FileObjectPtr = std::shared_ptr<FileObject>;
 
 public:
-    MemoryFile(const FileInfo& fileInfo, MemoryFileObjectPtr object)
+    BasicMemoryFile(const FileInfo& fileInfo, FileObjectPtr object)
         : m_Object(std::move(object))
         , m_FileInfo(fileInfo)
     {
         if (!m_Object) {
-            m_Object = std::make_shared<MemoryFileObject>();
+            m_Object = std::make_shared<FileObject>();
         }
     }
 
-    ~MemoryFile()
+    ~BasicMemoryFile()
     {
         Close();
     }
@@ -109,7 +146,7 @@ public:
     [[nodiscard]]
     virtual const FileInfo& GetFileInfo() const override
     {
-        [[maybe_unused]] auto lock = ThreadingPolicy::Lock(m_Mutex);
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
         return GetFileInfoImpl();
     }
     
@@ -119,7 +156,7 @@ public:
     [[nodiscard]]
     virtual uint64_t Size() const override
     {
-        [[maybe_unused]] auto lock = ThreadingPolicy::Lock(m_Mutex);
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
         return SizeImpl();
     }
     
@@ -129,7 +166,7 @@ public:
     [[nodiscard]]
     virtual bool IsReadOnly() const override
     {
-        [[maybe_unused]] auto lock = ThreadingPolicy::Lock(m_Mutex);
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
         return IsReadOnlyImpl();
     }
     
@@ -139,17 +176,18 @@ public:
     [[nodiscard]]
     virtual bool Open(FileMode mode) override
     {
-        [[maybe_unused]] auto lock = ThreadingPolicy::Lock(m_Mutex);
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
         return OpenImpl(mode);
     }
     
     /*
      * Close file
      */
-    virtual void Close() override
+    virtual bool Close() override
     {
-        [[maybe_unused]] auto lock = ThreadingPolicy::Lock(m_Mutex);
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
         CloseImpl();
+        return true;
     }
     
     /*
@@ -158,16 +196,25 @@ public:
     [[nodiscard]]
     virtual bool IsOpened() const override
     {
-        [[maybe_unused]] auto lock = ThreadingPolicy::Lock(m_Mutex);
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
         return IsOpenedImpl();
     }
+
+    /*
+     * Check if read data didn't match checksum, file has no checksum
+     */
+    [[nodiscard]]
+    virtual bool IsCorrupted() const override
+    {
+        return false;
+    }
     
     /*
      * Seek on a file
      */
     virtual uint64_t Seek(uint64_t offset, Origin origin) override
     {
-        [[maybe_unused]] auto lock = ThreadingPolicy::Lock(m_Mutex);
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
         return SeekImpl(offset, origin);
     }
     /*
@@ -176,7 +223,7 @@ public:
     [[nodiscard]]
     virtual uint64_t Tell() const override
     {
-        [[maybe_unused]] auto lock = ThreadingPolicy::Lock(m_Mutex);
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
         return TellImpl();
     }
     
@@ -185,7 +232,7 @@ public:
      */
     virtual uint64_t Read(std::span<uint8_t> buffer) override
     {
-        [[maybe_unused]] auto lock = ThreadingPolicy::Lock(m_Mutex);
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
         return ReadImpl(buffer);
     }
 
@@ -194,16 +241,34 @@ public:
      */
     virtual uint64_t Read(std::vector<uint8_t>& buffer, uint64_t size) override
     {
-        [[maybe_unused]] auto lock = ThreadingPolicy::Lock(m_Mutex);
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
         return ReadImpl(buffer, size);
     }
 
+    /*
+     * Read data from absolute offset to buffer, doesn't move file cursor
+     */
+    virtual uint64_t ReadAt(uint64_t offset, std::span<uint8_t> buffer) override
+    {
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
+        return ReadAtImpl(offset, buffer);
+    }
+
+    /*
+     * Read consecutive data from file to several buffers filled in order, moves file cursor
+     */
+    virtual uint64_t ReadV(std::span<const std::span<uint8_t>> buffers) override
+    {
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
+        return ReadVImpl(buffers);
+    }
+
     /*
      * Write buffer data to file
      */
     virtual uint64_t Write(std::span<const uint8_t> buffer) override
     {
-        [[maybe_unused]] auto lock = ThreadingPolicy::Lock(m_Mutex);
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
         return WriteImpl(buffer);
     }
     
@@ -212,12 +277,36 @@ public:
      */
     virtual uint64_t Write(const std::vector<uint8_t>& buffer) override
     {
-        [[maybe_unused]] auto lock = ThreadingPolicy::Lock(m_Mutex);
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
         return WriteImpl(buffer);
     }
 
+    /*
+     * Get snapshot of file content. Data is shared without copying, later writes
+     * to the file don't modify returned snapshot (copy-on-write)
+     */
+    [[nodiscard]]
+    std::shared_ptr<const std::vector<uint8_t>> Data() const
+    {
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
+        return m_Object->GetData();
+    }
+
+    /*
+     * Get snapshot of file content, same as Data()
+     */
+    [[nodiscard]]
+    virtual std::optional<FileBuffer> MappedData() override
+    {
+        auto data = Data();
+        if (!data) {
+            return std::nullopt;
+        }
+        return FileBuffer(std::move(data));
+    }
+
 private:
-    inline MemoryFileObject& Object() const
+    inline FileObject& Object() const
     {
         assert(m_Object);
         return *m_Object;
@@ -347,6 +436,62 @@ private:
         return bytesToRead;
     }
 
+    inline uint64_t ReadAtImpl(uint64_t offset, std::span<uint8_t> buffer)
+    {
+        if (!IsOpenedImpl()) {
+            return 0;
+        }
+
+        // Skip reading if file is not opened for reading
+        if (!IFile::ModeHasFlag(m_Mode, FileMode::Read)) {
+            return 0;
+        }
+
+        auto data = m_Object->GetData();
+        if (!data || data->size() <= offset) {
+            return 0;
+        }
+
+        const auto bytesToRead = std::min(static_cast<uint64_t>(data->size()) - offset, static_cast<uint64_t>(buffer.size_bytes()));
+        std::memcpy(buffer.data(), data->data() + offset, static_cast<std::size_t>(bytesToRead));
+        return bytesToRead;
+    }
+
+    inline uint64_t ReadVImpl(std::span<const std::span<uint8_t>> buffers)
+    {
+        if (!IsOpenedImpl()) {
+            return 0;
+        }
+
+        // Skip reading if file is not opened for reading
+        if (!IFile::ModeHasFlag(m_Mode, FileMode::Read)) {
+            return 0;
+        }
+
+        // Same data snapshot for all buffers
+        auto data = m_Object->GetData();
+        if (!data) {
+            return 0;
+        }
+
+        uint64_t total = 0;
+        for (const auto& buffer : buffers) {
+            if (data->size() <= m_SeekPos) {
+                break;
+            }
+
+            const auto bytesToRead = std::min(static_cast<uint64_t>(data->size()) - m_SeekPos, static_cast<uint64_t>(buffer.size_bytes()));
+            if (bytesToRead == 0) {
+                continue;
+            }
+
+            std::memcpy(buffer.data(), data->data() + m_SeekPos, static_cast<std::size_t>(bytesToRead));
+            m_SeekPos += bytesToRead;
+            total += bytesToRead;
+        }
+        return total;
+    }
+
     inline uint64_t WriteImpl(std::span<const uint8_t> buffer)
     {
         if (!IsOpenedImpl()) {
@@ -391,12 +536,12 @@ private:
     }
     
 private:
-    MemoryFileObjectPtr m_Object;
+    FileObjectPtr m_Object;
     FileInfo m_FileInfo;
     bool m_IsOpened = false;
     uint64_t m_SeekPos = 0;
     FileMode m_Mode = FileMode::Read;
-    mutable std::mutex m_Mutex;
+    [[no_unique_address]] mutable typename Policy::Mutex m_Mutex;
 };
 
 } // namespace vfspp
@@ -2,25 +2,37 @@
 #define VFSPP_MEMORYFILESYSTEM_HPP
 
 #include "IFileSystem.h"
+#include "FileIndex.hpp"
 #include "Global.h"
 #include "MemoryFile.hpp"
 
 namespace vfspp
 {
 
-using MemoryFileSystemPtr = std::shared_ptr<class MemoryFileSystem>;
-using MemoryFileSystemWeakPtr = std::weak_ptr<class MemoryFileSystem>;
+template<typename Policy>
+class BasicMemoryFileSystem;
 
+using MemoryFileSystem = BasicMemoryFileSystem<ThreadingPolicy>;
+using MemoryFileSystemPtr = std::shared_ptr<MemoryFileSystem>;
+using MemoryFileSystemWeakPtr = std::weak_ptr<MemoryFileSystem>;
 
-class MemoryFileSystem final : public IFileSystem
+
+/*
+ * Filesystem with files kept in memory, calls are synchronized by Policy
+ */
+template<typename Policy>
+class BasicMemoryFileSystem final : public IFileSystem
 {
+    using FileObject = BasicMemoryFileObject<Policy>;
+    using FileObjectPtr = std::shared_ptr<FileObject>;
+
 public:
-    MemoryFileSystem(const std::string& aliasPath)
+    BasicMemoryFileSystem(const std::string& aliasPath)
         : m_AliasPath(aliasPath)
     {
     }
 
-    ~MemoryFileSystem()
+    ~BasicMemoryFileSystem()
     {
         Shutdown();
     }
@@ -31,7 +43,7 @@ public:
     [[nodiscard]]
     virtual bool Initialize() override
     {
-        [[maybe_unused]] auto lock = ThreadingPolicy::Lock(m_Mutex);
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
         return InitializeImpl();
     }
 
@@ -40,9 +52,37 @@ public:
      */
     virtual void Shutdown() override
     {
-        [[maybe_unused]] auto lock = ThreadingPolicy::Lock(m_Mutex);
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
         ShutdownImpl();
     }
+
+    /*
+     * Set executor for parallel work
+     */
+    virtual void SetExecutor(ExecutorPtr executor) override
+    {
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
+        m_Executor = std::move(executor);
+    }
+
+    /*
+     * Switch case sensitivity of file lookups, fails if paths of files differ only by case
+     */
+    virtual bool SetCaseSensitive(bool isCaseSensitive) override
+    {
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
+        return m_Files.SetCaseSensitive(isCaseSensitive);
+    }
+
+    /*
+     * Check if file lookups are case sensitive
+     */
+    [[nodiscard]]
+    virtual bool IsCaseSensitive() const override
+    {
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
+        return m_Files.IsCaseSensitive();
+    }
     
     /*
      * Check if filesystem is initialized
@@ -50,7 +90,7 @@ public:
     [[nodiscard]]
     virtual bool IsInitialized() const override
     {
-        [[maybe_unused]] auto lock = ThreadingPolicy::Lock(m_Mutex);
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
         return IsInitializedImpl();
     }
     
@@ -60,7 +100,7 @@ public:
     [[nodiscard]]
     virtual const std::string& BasePath() const override
     {
-        [[maybe_unused]] auto lock = ThreadingPolicy::Lock(m_Mutex);
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
         return BasePathImpl();
     }
     
@@ -70,7 +110,7 @@ public:
     [[nodiscard]]
     virtual const std::string& VirtualPath() const override
     {
-        [[maybe_unused]] auto lock = ThreadingPolicy::Lock(m_Mutex);
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
         return AliasPathImpl();
     }
 
@@ -80,9 +120,42 @@ public:
     [[nodiscard]]
     virtual FilesList GetFilesList() const override
     {
-        [[maybe_unused]] auto lock = ThreadingPolicy::Lock(m_Mutex);
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
         return GetFilesListImpl();
     }
+
+    /*
+     * Call visitor for each file without copying file list, stops when visitor returns false
+     */
+    virtual void ForEachFile(const FileVisitor& visitor) const override
+    {
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
+        for (const auto& [path, entry] : m_Files) {
+            if (!visitor(entry.Info)) {
+                return;
+            }
+        }
+    }
+
+    /*
+     * List files and directories of directory, paths of directories end with '/'
+     */
+    [[nodiscard]]
+    virtual std::vector<std::string> ListDirectory(const std::string& virtualPath, bool recursive = false) const override
+    {
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
+        return m_Files.ListDirectory(virtualPath, recursive);
+    }
+
+    /*
+     * Find files matching pattern. Returns sorted virtual paths
+     */
+    [[nodiscard]]
+    virtual std::vector<std::string> FindFiles(const GlobPattern& pattern) const override
+    {
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
+        return m_Files.Find(pattern);
+    }
     
     /*
      * Check is readonly filesystem
@@ -90,7 +163,7 @@ public:
     [[nodiscard]]
     virtual bool IsReadOnly() const override
     {
-        [[maybe_unused]] auto lock = ThreadingPolicy::Lock(m_Mutex);
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
         return IsReadOnlyImpl();
     }
     
@@ -100,17 +173,17 @@ public:
      */
     virtual IFilePtr OpenFile(const std::string& virtualPath, IFile::FileMode mode) override
     {
-        [[maybe_unused]] auto lock = ThreadingPolicy::Lock(m_Mutex);
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
         return OpenFileImpl(virtualPath, mode);
     }
 
     /*
      * Close file
      */
-    virtual void CloseFile(IFilePtr file) override
+    virtual bool CloseFile(IFilePtr file) override
     {
-        [[maybe_unused]] auto lock = ThreadingPolicy::Lock(m_Mutex);
-        CloseFileImpl(file);
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
+        return CloseFileImpl(file);
     }
     
     /*
@@ -118,7 +191,7 @@ public:
      */
     virtual IFilePtr CreateFile(const std::string& virtualPath) override
     {
-        [[maybe_unused]] auto lock = ThreadingPolicy::Lock(m_Mutex);
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
         return OpenFileImpl(virtualPath, IFile::FileMode::ReadWrite | IFile::FileMode::Truncate);
     }
     
@@ -127,7 +200,7 @@ public:
      */
     virtual bool RemoveFile(const std::string& virtualPath) override
     {
-        [[maybe_unused]] auto lock = ThreadingPolicy::Lock(m_Mutex);
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
         return RemoveFileImpl(virtualPath);
     }
     
@@ -136,7 +209,7 @@ public:
      */
     virtual bool CopyFile(const std::string& srcVirtualPath, const std::string& dstVirtualPath, bool overwrite = false) override
     {
-        [[maybe_unused]] auto lock = ThreadingPolicy::Lock(m_Mutex);
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
         return CopyFileImpl(srcVirtualPath, dstVirtualPath, overwrite);
     }
     
@@ -145,7 +218,7 @@ public:
      */
     virtual bool RenameFile(const std::string& srcVirtualPath, const std::string& dstVirtualPath) override
     {
-        [[maybe_unused]] auto lock = ThreadingPolicy::Lock(m_Mutex);
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
         return RenameFileImpl(srcVirtualPath, dstVirtualPath);
     }
 
@@ -155,10 +228,30 @@ public:
     [[nodiscard]]
     virtual bool IsFileExists(const std::string& virtualPath) const override
     {
-        [[maybe_unused]] auto lock = ThreadingPolicy::Lock(m_Mutex);
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
         return IsFileExistsImpl(virtualPath);
     }
 
+    /*
+     * Get file metadata without opening file
+     */
+    [[nodiscard]]
+    virtual std::optional<FileStat> Stat(const std::string& virtualPath) const override
+    {
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
+        return StatImpl(virtualPath);
+    }
+
+    /*
+     * Read whole file without opening file object, buffer shares data with memory file
+     */
+    [[nodiscard]]
+    virtual std::optional<FileBuffer> ReadAll(const std::string& virtualPath) const override
+    {
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
+        return ReadAllImpl(virtualPath);
+    }
+
 private:
     inline bool InitializeImpl()
     {
@@ -210,18 +303,23 @@ private:
     {
         FileInfo fileInfo(AliasPathImpl(), BasePathImpl(), virtualPath);
 
-        auto entryResult = m_Files.try_emplace(virtualPath, fileInfo, std::make_shared<MemoryFileObject>());
+        auto entryResult = m_Files.try_emplace(virtualPath, fileInfo, std::make_shared<FileObject>());
         auto entryIt = entryResult.first;
 
         auto& entry = entryIt->second;
         if (!entry.Object) {
-            entry.Object = std::make_shared<MemoryFileObject>();
+            entry.Object = std::make_shared<FileObject>();
         }
         if (!entry.Object) {
             return nullptr;
         }
 
-        auto file = std::make_shared<MemoryFile>(entry.Info, entry.Object);
+        IFilePtr file;
+        if (IFile::ModeHasFlag(mode, IFile::FileMode::ExclusiveOwner)) {
+            file = std::make_shared<BasicMemoryFile<SingleThreadedPolicy, Policy>>(entry.Info, entry.Object);
+        } else {
+            file = std::make_shared<BasicMemoryFile<Policy>>(entry.Info, entry.Object);
+        }
         if (!file || !file->Open(mode)) {
             return nullptr;
         }
@@ -231,9 +329,9 @@ private:
         return file;
     }
 
-    inline void CloseFileImpl(IFilePtr file)
+    inline bool CloseFileImpl(IFilePtr file)
     {
-        CloseFileAndCleanupOpenedHandles(file);
+        return CloseFileAndCleanupOpenedHandles(file);
     }
 
     inline bool RemoveFileImpl(const std::string& virtualPath)
@@ -270,11 +368,11 @@ private:
         }
 
         // Create copy of memory object
-        MemoryFileObjectPtr newObject;
+        FileObjectPtr newObject;
         if (srcIt->second.Object) {
-            newObject = std::make_shared<MemoryFileObject>(*srcIt->second.Object);
+            newObject = std::make_shared<FileObject>(*srcIt->second.Object);
         } else {
-            newObject = std::make_shared<MemoryFileObject>();
+            newObject = std::make_shared<FileObject>();
         }
 
         FileInfo fileInfo(AliasPathImpl(), BasePathImpl(), dstVirtualPath);
@@ -298,37 +396,70 @@ private:
         return m_Files.find(virtualPath) != m_Files.end();
     }
 
-    inline void CloseFileAndCleanupOpenedHandles(IFilePtr fileToClose = nullptr)
+    inline std::optional<FileBuffer> ReadAllImpl(const std::string& virtualPath) const
+    {
+        const auto it = m_Files.find(virtualPath);
+        if (it == m_Files.end()) {
+            return std::nullopt;
+        }
+
+        // Writers copy data shared with buffer, so buffer is a stable snapshot
+        const auto& object = it->second.Object;
+        return object ? FileBuffer(object->GetData()) : FileBuffer();
+    }
+
+    inline std::optional<FileStat> StatImpl(const std::string& virtualPath) const
     {
+        const auto it = m_Files.find(virtualPath);
+        if (it == m_Files.end()) {
+            return std::nullopt;
+        }
+
+        FileStat stat;
+        if (const auto& object = it->second.Object) {
+            const auto data = object->GetData();
+            stat.Size = data ? data->size() : 0;
+            stat.ModifiedTime = object->ModifiedTime();
+        }
+        stat.CompressedSize = stat.Size;
+        return stat;
+    }
+
+    inline bool CloseFileAndCleanupOpenedHandles(IFilePtr fileToClose = nullptr)
+    {
+        bool isClosed = true;
         if (fileToClose) {
             const auto absolutePath = fileToClose->GetFileInfo().VirtualPath();
             
             const auto it = m_Files.find(absolutePath);
             if (it == m_Files.end()) {
-                return;
+                return false;
             }
             
-            fileToClose->Close();
+            isClosed = fileToClose->Close();
         }
 
         for (auto& [path, entry] : m_Files) {
-            entry.CleanupOpenedHandles(fileToClose);
+            // Handle of file which failed to close stays registered
+            entry.CleanupOpenedHandles(isClosed ? fileToClose : nullptr);
         }
+        return isClosed;
     }
     
 private:
     std::string m_AliasPath;
     bool m_IsInitialized = false;
-    mutable std::mutex m_Mutex;
+    ExecutorPtr m_Executor;
+    [[no_unique_address]] mutable typename Policy::Mutex m_Mutex;
 
     struct FileEntry
     {
         FileInfo Info;
-        MemoryFileObjectPtr Object;
-        using WeakHandle = MemoryFileWeakPtr;
+        FileObjectPtr Object;
+        using WeakHandle = IFileWeakPtr;
         std::vector<WeakHandle> OpenedHandles;
 
-        FileEntry(const FileInfo& info, MemoryFileObjectPtr object)
+        FileEntry(const FileInfo& info, FileObjectPtr object)
             : Info(info)
             , Object(object)
         {
@@ -337,12 +468,12 @@ private:
         void CleanupOpenedHandles(IFilePtr fileToExclude = nullptr)
         {
             OpenedHandles.erase(std::remove_if(OpenedHandles.begin(), OpenedHandles.end(), [&](const WeakHandle& weak) {
-                return weak.expired() || weak.lock() == fileToExclude;
+                return weak.expired() || IsSameFile(weak, fileToExclude);
             }), OpenedHandles.end());
         }
     };
 
-    std::unordered_map<std::string, FileEntry> m_Files;
+    FileIndex<FileEntry, Policy> m_Files;
 };
 
 } // namespace vfspp
@@ -0,0 +1,194 @@
+#ifndef VFSPP_NATIVEBLOB_HPP
+#define VFSPP_NATIVEBLOB_HPP
+
+#include "Global.h"
+#include "StdioFile.hpp"
+#include "ThreadingPolicy.hpp"
+
+#ifdef VFSPP_DISABLE_STD_FILESYSTEM
+#include "FilesystemCompat.hpp"
+namespace fs = vfspp::fs_compat;
+#else
+namespace fs = std::filesystem;
+#endif
+
+#if defined(VFSPP_POSIX_IO_ENABLED)
+#include <sys/mman.h>
+#endif
+
+namespace vfspp
+{
+
+using NativeBlobPtr = std::shared_ptr<class NativeBlob>;
+using NativeBlobWeakPtr = std::weak_ptr<class NativeBlob>;
+
+
+/*
+ * Large read-only native file shared by files that are ranges of it. File is mapped to
+ * memory when requested and supported, otherwise ranges are read with positional reads,
+ * or with stdio under lock when positional IO is not available. Memory mapping needs
+ * POSIX IO, on other platforms, e.g. Windows, blob is always read with stdio.
+ * Reads are thread safe
+ */
+class NativeBlob final
+{
+public:
+    NativeBlob() = default;
+
+    ~NativeBlob()
+    {
+        Close();
+    }
+
+    NativeBlob(const NativeBlob&) = delete;
+    NativeBlob& operator=(const NativeBlob&) = delete;
+
+    /*
+     * Open native file, memory mapping falls back to reads if mapping fails or isn't
+     * supported by platform
+     */
+    [[nodiscard]]
+    bool Open(const std::string& path, bool memoryMap)
+    {
+        Close();
+
+#if defined(VFSPP_POSIX_IO_ENABLED)
+        m_Descriptor = ::open(path.c_str(), O_RDONLY);
+        if (m_Descriptor < 0) {
+            return false;
+        }
+
+        struct stat st;
+        if (::fstat(m_Descriptor, &st) != 0 || !S_ISREG(st.st_mode)) {
+            Close();
+            return false;
+        }
+        m_Size = static_cast<uint64_t>(st.st_size);
+        m_ModifiedTime = st.st_mtime;
+
+        if (memoryMap && m_Size > 0) {
+            void* memory = ::mmap(nullptr, static_cast<size_t>(m_Size), PROT_READ, MAP_PRIVATE, m_Descriptor, 0);
+            if (memory != MAP_FAILED) {
+                m_Memory = std::span<const uint8_t>(static_cast<const uint8_t*>(memory), static_cast<size_t>(m_Size));
+            }
+        }
+#else
+        (void)memoryMap;
+
+        std::error_code ec;
+        const auto size = fs::file_size(path, ec);
+        if (ec) {
+            return false;
+        }
+        m_Size = static_cast<uint64_t>(size);
+#ifndef VFSPP_DISABLE_STD_FILESYSTEM
+        const auto writeTime = fs::last_write_time(path, ec);
+        if (!ec) {
+            const auto systemTime = std::chrono::time_point_cast<std::chrono::system_clock::duration>(writeTime - fs::file_time_type::clock::now() + std::chrono::system_clock::now());
+            m_ModifiedTime = std::chrono::system_clock::to_time_t(systemTime);
+        }
+#endif
+
+        m_File = std::fopen(path.c_str(), "rb");
+        if (!m_File) {
+            return false;
+        }
+#endif
+
+        return true;
+    }
+
+    void Close()
+    {
+#if defined(VFSPP_POSIX_IO_ENABLED)
+        if (!m_Memory.empty()) {
+            ::munmap(const_cast<uint8_t*>(m_Memory.data()), m_Memory.size());
+        }
+        if (m_Descriptor >= 0) {
+            ::close(m_Descriptor);
+            m_Descriptor = -1;
+        }
+#else
+        if (m_File) {
+            std::fclose(m_File);
+            m_File = nullptr;
+        }
+#endif
+        m_Memory = {};
+        m_Size = 0;
+        m_ModifiedTime = 0;
+    }
+
+    [[nodiscard]]
+    uint64_t Size() const
+    {
+        return m_Size;
+    }
+
+    [[nodiscard]]
+    std::time_t ModifiedTime() const
+    {
+        return m_ModifiedTime;
+    }
+
+    /*
+     * Get whole file memory if file is mapped, otherwise empty span
+     */
+    [[nodiscard]]
+    std::span<const uint8_t> Memory() const
+    {
+        return m_Memory;
+    }
+
+    /*
+     * Read data from absolute offset, returns number of bytes read
+     */
+    uint64_t ReadAt(uint64_t offset, std::span<uint8_t> buffer) const
+    {
+        if (offset >= m_Size || buffer.empty()) {
+            return 0;
+        }
+        const auto size = static_cast<size_t>(std::min<uint64_t>(buffer.size(), m_Size - offset));
+
+        if (!m_Memory.empty()) {
+            std::memcpy(buffer.data(), m_Memory.data() + offset, size);
+            return size;
+        }
+
+#if defined(VFSPP_POSIX_IO_ENABLED)
+        size_t total = 0;
+        while (total < size) {
+            const ssize_t read = ::pread(m_Descriptor, buffer.data() + total, size - total, static_cast<off_t>(offset + total));
+            if (read < 0 && errno == EINTR) {
+                continue;
+            }
+            if (read <= 0) {
+                break;
+            }
+            total += static_cast<size_t>(read);
+        }
+        return total;
+#else
+        [[maybe_unused]] auto lock = MultiThreadedPolicy::Lock(m_Mutex);
+        if (!m_File || !StdioFile::Seek(m_File, static_cast<int64_t>(offset), SEEK_SET)) {
+            return 0;
+        }
+        return std::fread(buffer.data(), 1, size, m_File);
+#endif
+    }
+
+private:
+    uint64_t m_Size = 0;
+    std::time_t m_ModifiedTime = 0;
+    std::span<const uint8_t> m_Memory;
+#if defined(VFSPP_POSIX_IO_ENABLED)
+    int m_Descriptor = -1;
+#else
+    std::FILE* m_File = nullptr;
+    mutable MultiThreadedPolicy::Mutex m_Mutex;
+#endif
+};
+
+} // namespace vfspp
+
+#endif // VFSPP_NATIVEBLOB_HPP
@@ -2,6 +2,8 @@
 #define VFSPP_NATIVEFILE_HPP
 
 #include "IFile.h"
+#include "FileBuffer.hpp"
+#include "StdioFile.hpp"
 #include "ThreadingPolicy.hpp"
 
 #ifdef VFSPP_DISABLE_STD_FILESYSTEM
@@ -14,25 +16,36 @@ namespace fs = std::filesystem;
 namespace vfspp
 {
 
-using NativeFilePtr = std::shared_ptr<class NativeFile>;
-using NativeFileWeakPtr = std::weak_ptr<class NativeFile>;
+template<typename Policy>
+class BasicNativeFile;
 
+using NativeFile = BasicNativeFile<ThreadingPolicy>;
+using NativeFilePtr = std::shared_ptr<NativeFile>;
+using NativeFileWeakPtr = std::weak_ptr<NativeFile>;
 
-class NativeFile final : public IFile
+// Handle owned by single thread, calls are not synchronized
+using ExclusiveNativeFile = BasicNativeFile<SingleThreadedPolicy>;
+
+
+/*
+ * File of native filesystem, calls are synchronized by Policy
+ */
+template<typename Policy>
+class BasicNativeFile final : public IFile
 {
 public:
-    NativeFile(const FileInfo& fileInfo)
+    BasicNativeFile(const FileInfo& fileInfo)
         : m_FileInfo(fileInfo)
     {
     }
     
-    NativeFile(const FileInfo& fileInfo, FILE* stream)
+    BasicNativeFile(const FileInfo& fileInfo, FILE* stream)
         : m_FileInfo(fileInfo)
         , m_File(stream)
     {
     }
 
-    ~NativeFile()
+    ~BasicNativeFile()
     {
         Close();
     }
@@ -43,7 +56,7 @@ public:
     [[nodiscard]]
     virtual const FileInfo& GetFileInfo() const override
     {
-        [[maybe_unused]] auto lock = ThreadingPolicy::Lock(m_Mutex);
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
         return GetFileInfoImpl();
     }
     
@@ -53,7 +66,7 @@ public:
     [[nodiscard]]
     virtual uint64_t Size() const override
     {
-        [[maybe_unused]] auto lock = ThreadingPolicy::Lock(m_Mutex);
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
         return SizeImpl();
     }
     
@@ -63,7 +76,7 @@ public:
     [[nodiscard]]
     virtual bool IsReadOnly() const override
     {
-        [[maybe_unused]] auto lock = ThreadingPolicy::Lock(m_Mutex);
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
         return IsReadOnlyImpl();
     }
     
@@ -73,17 +86,17 @@ public:
     [[nodiscard]]
     virtual bool Open(FileMode mode) override
     {
-        [[maybe_unused]] auto lock = ThreadingPolicy::Lock(m_Mutex);
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
         return OpenImpl(mode);
     }
     
     /*
      * Close file
      */
-    virtual void Close() override
+    virtual bool Close() override
     {
-        [[maybe_unused]] auto lock = ThreadingPolicy::Lock(m_Mutex);
-        CloseImpl();
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
+        return CloseImpl();
     }
     
     /*
@@ -92,16 +105,25 @@ public:
     [[nodiscard]]
     virtual bool IsOpened() const override
     {
-        [[maybe_unused]] auto lock = ThreadingPolicy::Lock(m_Mutex);
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
         return IsOpenedImpl();
     }
+
+    /*
+     * Check if read data didn't match checksum, file has no checksum
+     */
+    [[nodiscard]]
+    virtual bool IsCorrupted() const override
+    {
+        return false;
+    }
     
     /*
      * Seek on a file
      */
     virtual uint64_t Seek(uint64_t offset, Origin origin) override
     {
-        [[maybe_unused]] auto lock = ThreadingPolicy::Lock(m_Mutex);
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
         return SeekImpl(offset, origin);
     }
     /*
@@ -110,7 +132,7 @@ public:
     [[nodiscard]]
     virtual uint64_t Tell() const override
     {
-        [[maybe_unused]] auto lock = ThreadingPolicy::Lock(m_Mutex);
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
         return TellImpl();
     }
     
@@ -119,7 +141,7 @@ public:
      */
     virtual uint64_t Read(std::span<uint8_t> buffer) override
     {
-        [[maybe_unused]] auto lock = ThreadingPolicy::Lock(m_Mutex);
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
         return ReadImpl(buffer);
     }
 
@@ -128,16 +150,34 @@ public:
      */
     virtual uint64_t Read(std::vector<uint8_t>& buffer, uint64_t size) override
     {
-        [[maybe_unused]] auto lock = ThreadingPolicy::Lock(m_Mutex);
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
         return ReadImpl(buffer, size);
     }
 
+    /*
+     * Read data from absolute offset to buffer, doesn't move file cursor
+     */
+    virtual uint64_t ReadAt(uint64_t offset, std::span<uint8_t> buffer) override
+    {
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
+        return ReadAtImpl(offset, buffer);
+    }
+
+    /*
+     * Read consecutive data from file to several buffers filled in order, moves file cursor
+     */
+    virtual uint64_t ReadV(std::span<const std::span<uint8_t>> buffers) override
+    {
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
+        return ReadVImpl(buffers);
+    }
+
     /*
      * Write buffer data to file
      */
     virtual uint64_t Write(std::span<const uint8_t> buffer) override
     {
-        [[maybe_unused]] auto lock = ThreadingPolicy::Lock(m_Mutex);
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
         return WriteImpl(buffer);
     }
     
@@ -146,11 +186,73 @@ public:
      */
     virtual uint64_t Write(const std::vector<uint8_t>& buffer) override
     {
-        [[maybe_unused]] auto lock = ThreadingPolicy::Lock(m_Mutex);
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
         return WriteImpl(buffer);
     }
 
+    /*
+     * Read whole native file into buffer of exact size without creating file object
+     */
+    [[nodiscard]]
+    static std::optional<FileBuffer> ReadAll(const std::string& nativePath)
+    {
+#if defined(VFSPP_POSIX_IO_ENABLED)
+        const int fd = ::open(nativePath.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return std::nullopt;
+        }
+
+        struct stat st;
+        if (::fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+            ::close(fd);
+            return std::nullopt;
+        }
+
+        auto data = std::make_shared<std::vector<uint8_t>>(static_cast<size_t>(st.st_size));
+        const uint64_t read = PositionalRead(fd, 0, *data);
+        ::close(fd);
+#else
+        std::FILE* file = std::fopen(nativePath.c_str(), "rb");
+        if (!file) {
+            return std::nullopt;
+        }
+
+        std::error_code ec;
+        const auto size = fs::file_size(nativePath, ec);
+        if (ec) {
+            std::fclose(file);
+            return std::nullopt;
+        }
+
+        auto data = std::make_shared<std::vector<uint8_t>>(static_cast<size_t>(size));
+        const uint64_t read = std::fread(data->data(), 1, data->size(), file);
+        std::fclose(file);
+#endif
+        if (read != data->size()) {
+            return std::nullopt;
+        }
+        return FileBuffer(std::move(data));
+    }
+
 private:
+#if defined(VFSPP_POSIX_IO_ENABLED)
+    static uint64_t PositionalRead(int fd, uint64_t offset, std::span<uint8_t> buffer)
+    {
+        uint64_t total = 0;
+        while (total < buffer.size_bytes()) {
+            const ssize_t read = ::pread(fd, buffer.data() + total, static_cast<size_t>(buffer.size_bytes() - total), static_cast<off_t>(offset + total));
+            if (read < 0 && errno == EINTR) {
+                continue;
+            }
+            if (read <= 0) {
+                break;
+            }
+            total += static_cast<uint64_t>(read);
+        }
+        return total;
+    }
+#endif
+
     inline const FileInfo& GetFileInfoImpl() const
     {
         return m_FileInfo;
@@ -210,13 +312,17 @@ private:
         return (m_File != nullptr);
     }
 
-    inline void CloseImpl()
+    inline bool CloseImpl()
     {
-        if (IsOpenedImpl()) {
-            std::fclose(m_File);
-            m_File = nullptr;
-            m_Mode = FileMode::Read;
+        if (!IsOpenedImpl()) {
+            return true;
         }
+
+        // Buffered writes are flushed by fclose, stream is released even if flush failed
+        const bool isClosed = std::fclose(m_File) == 0;
+        m_File = nullptr;
+        m_Mode = FileMode::Read;
+        return isClosed;
     }
 
     inline bool IsOpenedImpl() const
@@ -237,7 +343,7 @@ private:
             whence = SEEK_CUR;
         }
 
-        if (std::fseek(m_File, static_cast<long>(offset), whence) != 0) {
+        if (!StdioFile::Seek(m_File, static_cast<int64_t>(offset), whence)) {
             return 0;
         }
 
@@ -250,8 +356,7 @@ private:
             return 0;
         }
 
-        long pos = std::ftell(m_File);
-        return (pos != -1L) ? static_cast<uint64_t>(pos) : 0;
+        return StdioFile::Tell(m_File).value_or(0);
     }
 
     inline uint64_t ReadImpl(std::span<uint8_t> buffer)
@@ -272,6 +377,111 @@ private:
         return 0;
     }
 
+    inline uint64_t ReadAtImpl(uint64_t offset, std::span<uint8_t> buffer)
+    {
+        if (!IsOpenedImpl()) {
+            return 0;
+        }
+
+        // Skip reading if file is not opened for reading
+        if (!IFile::ModeHasFlag(m_Mode, FileMode::Read)) {
+            return 0;
+        }
+
+        // Pending writes must reach the descriptor before positional read
+        if (IFile::ModeHasFlag(m_Mode, FileMode::Write)) {
+            std::fflush(m_File);
+        }
+
+#if defined(VFSPP_POSIX_IO_ENABLED)
+        return PositionalRead(::fileno(m_File), offset, buffer);
+#else
+        const auto pos = StdioFile::Tell(m_File);
+        if (!pos || !StdioFile::Seek(m_File, static_cast<int64_t>(offset), SEEK_SET)) {
+            return 0;
+        }
+
+        size_t read = std::fread(buffer.data(), 1, static_cast<size_t>(buffer.size_bytes()), m_File);
+        StdioFile::Seek(m_File, static_cast<int64_t>(*pos), SEEK_SET);
+        return static_cast<uint64_t>(read);
+#endif
+    }
+
+    inline uint64_t ReadVImpl(std::span<const std::span<uint8_t>> buffers)
+    {
+        if (!IsOpenedImpl()) {
+            return 0;
+        }
+
+        // Skip reading if file is not opened for reading
+        if (!IFile::ModeHasFlag(m_Mode, FileMode::Read)) {
+            return 0;
+        }
+
+#if defined(VFSPP_POSIX_IO_ENABLED)
+        // Pending writes must reach the descriptor before positional read
+        if (IFile::ModeHasFlag(m_Mode, FileMode::Write)) {
+            std::fflush(m_File);
+        }
+
+        const auto pos = StdioFile::Tell(m_File);
+        if (!pos) {
+            return 0;
+        }
+
+        const int fd = ::fileno(m_File);
+        uint64_t total = 0;
+        size_t index = 0;
+        size_t bufferOffset = 0;
+        std::array<iovec, 64> vectors;
+        while (index < buffers.size()) {
+            // Gather batch of remaining buffers, first one can be partially filled
+            size_t count = 0;
+            for (size_t i = index; i < buffers.size() && count < vectors.size(); ++i) {
+                const size_t skip = (i == index) ? bufferOffset : 0;
+                if (buffers[i].size() > skip) {
+                    vectors[count++] = iovec{ buffers[i].data() + skip, buffers[i].size() - skip };
+                }
+            }
+            if (count == 0) {
+                break;
+            }
+
+            const ssize_t read = ::preadv(fd, vectors.data(), static_cast<int>(count), static_cast<off_t>(*pos + total));
+            if (read < 0 && errno == EINTR) {
+                continue;
+            }
+            if (read <= 0) {
+                break;
+            }
+            total += static_cast<uint64_t>(read);
+
+            // Advance to first buffer not filled completely
+            size_t left = static_cast<size_t>(read);
+            while (index < buffers.size() && left >= buffers[index].size() - bufferOffset) {
+                left -= buffers[index].size() - bufferOffset;
+                bufferOffset = 0;
+                index++;
+            }
+            bufferOffset += left;
+        }
+
+        // Keep stream cursor in sync with data consumed by positional reads
+        StdioFile::Seek(m_File, static_cast<int64_t>(*pos + total), SEEK_SET);
+        return total;
+#else
+        uint64_t total = 0;
+        for (const auto& buffer : buffers) {
+            const size_t read = std::fread(buffer.data(), 1, buffer.size(), m_File);
+            total += read;
+            if (read != buffer.size()) {
+                break;
+            }
+        }
+        return total;
+#endif
+    }
+
     inline uint64_t WriteImpl(std::span<const uint8_t> buffer)
     {
         if (!IsOpenedImpl()) {
@@ -310,7 +520,7 @@ private:
     FileInfo m_FileInfo;
     std::FILE* m_File = nullptr;
     FileMode m_Mode = FileMode::Read;
-    mutable std::mutex m_Mutex;
+    [[no_unique_address]] mutable typename Policy::Mutex m_Mutex;
 };
     
 } // namespace vfspp
@@ -2,6 +2,7 @@
 #define VFSPP_NATIVEFILESYSTEM_HPP
 
 #include "IFileSystem.h"
+#include "FileIndex.hpp"
 #include "Global.h"
 #include "ThreadingPolicy.hpp"
 #include "NativeFile.hpp"
@@ -20,19 +21,27 @@ namespace fs = std::filesystem;
 namespace vfspp
 {
 
-using NativeFileSystemPtr = std::shared_ptr<class NativeFileSystem>;
-using NativeFileSystemWeakPtr = std::weak_ptr<class NativeFileSystem>;
+template<typename Policy>
+class BasicNativeFileSystem;
 
-class NativeFileSystem final : public IFileSystem
+using NativeFileSystem = BasicNativeFileSystem<ThreadingPolicy>;
+using NativeFileSystemPtr = std::shared_ptr<NativeFileSystem>;
+using NativeFileSystemWeakPtr = std::weak_ptr<NativeFileSystem>;
+
+/*
+ * Filesystem of native directory, calls are synchronized by Policy
+ */
+template<typename Policy>
+class BasicNativeFileSystem final : public IFileSystem
 {
 public:
-    NativeFileSystem(const std::string& aliasPath, const std::string& basePath)
+    BasicNativeFileSystem(const std::string& aliasPath, const std::string& basePath)
         : m_AliasPath(aliasPath)
         , m_BasePath(basePath)
     {
     }
 
-    ~NativeFileSystem()
+    ~BasicNativeFileSystem()
     {
         Shutdown();
     }
@@ -43,7 +52,7 @@ public:
     [[nodiscard]]
     virtual bool Initialize() override
     {
-        [[maybe_unused]] auto lock = ThreadingPolicy::Lock(m_Mutex);
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
         return InitializeImpl();
     }
 
@@ -52,9 +61,37 @@ public:
      */
     virtual void Shutdown() override
     {
-        [[maybe_unused]] auto lock = ThreadingPolicy::Lock(m_Mutex);
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
         ShutdownImpl();
     }
+
+    /*
+     * Set executor for parallel work
+     */
+    virtual void SetExecutor(ExecutorPtr executor) override
+    {
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
+        m_Executor = std::move(executor);
+    }
+
+    /*
+     * Switch case sensitivity of file lookups, fails if paths of files differ only by case
+     */
+    virtual bool SetCaseSensitive(bool isCaseSensitive) override
+    {
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
+        return m_Files.SetCaseSensitive(isCaseSensitive);
+    }
+
+    /*
+     * Check if file lookups are case sensitive
+     */
+    [[nodiscard]]
+    virtual bool IsCaseSensitive() const override
+    {
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
+        return m_Files.IsCaseSensitive();
+    }
     
     /*
      * Check if filesystem is initialized
@@ -62,7 +99,7 @@ public:
     [[nodiscard]]
     virtual bool IsInitialized() const override
     {
-        [[maybe_unused]] auto lock = ThreadingPolicy::Lock(m_Mutex);
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
         return IsInitializedImpl();
     }
     
@@ -72,7 +109,7 @@ public:
     [[nodiscard]]
     virtual const std::string& BasePath() const override
     {
-        [[maybe_unused]] auto lock = ThreadingPolicy::Lock(m_Mutex);
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
         return BasePathImpl();
     }
 
@@ -82,7 +119,7 @@ public:
     [[nodiscard]]
     virtual const std::string& VirtualPath() const override
     {
-        [[maybe_unused]] auto lock = ThreadingPolicy::Lock(m_Mutex);
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
         return AliasPathImpl();
     }
     
@@ -92,9 +129,42 @@ public:
     [[nodiscard]]
     virtual FilesList GetFilesList() const override
     {
-        [[maybe_unused]] auto lock = ThreadingPolicy::Lock(m_Mutex);
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
         return GetFilesListImpl();
     }
+
+    /*
+     * Call visitor for each file without copying file list, stops when visitor returns false
+     */
+    virtual void ForEachFile(const FileVisitor& visitor) const override
+    {
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
+        for (const auto& [path, entry] : m_Files) {
+            if (!visitor(entry.Info)) {
+                return;
+            }
+        }
+    }
+
+    /*
+     * List files and directories of directory, paths of directories end with '/'
+     */
+    [[nodiscard]]
+    virtual std::vector<std::string> ListDirectory(const std::string& virtualPath, bool recursive = false) const override
+    {
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
+        return m_Files.ListDirectory(virtualPath, recursive);
+    }
+
+    /*
+     * Find files matching pattern. Returns sorted virtual paths
+     */
+    [[nodiscard]]
+    virtual std::vector<std::string> FindFiles(const GlobPattern& pattern) const override
+    {
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
+        return m_Files.Find(pattern);
+    }
     
     /*
      * Check is readonly filesystem
@@ -102,7 +172,7 @@ public:
     [[nodiscard]]
     virtual bool IsReadOnly() const override
     {
-        [[maybe_unused]] auto lock = ThreadingPolicy::Lock(m_Mutex);
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
         return IsReadOnlyImpl();
     }
     
@@ -112,17 +182,17 @@ public:
      */
     virtual IFilePtr OpenFile(const std::string& virtualPath, IFile::FileMode mode) override
     {
-        [[maybe_unused]] auto lock = ThreadingPolicy::Lock(m_Mutex);
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
         return OpenFileImpl(virtualPath, mode);
     }
 
     /*
      * Close file
      */
-    virtual void CloseFile(IFilePtr file) override
+    virtual bool CloseFile(IFilePtr file) override
     {
-        [[maybe_unused]] auto lock = ThreadingPolicy::Lock(m_Mutex);
-        CloseFileImpl(file);
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
+        return CloseFileImpl(file);
     }
     
     /*
@@ -130,7 +200,7 @@ public:
      */
     virtual IFilePtr CreateFile(const std::string& virtualPath) override
     {
-        [[maybe_unused]] auto lock = ThreadingPolicy::Lock(m_Mutex);
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
         return OpenFileImpl(virtualPath, IFile::FileMode::ReadWrite | IFile::FileMode::Truncate);
     }
     
@@ -139,7 +209,7 @@ public:
      */
     virtual bool RemoveFile(const std::string& virtualPath) override
     {
-        [[maybe_unused]] auto lock = ThreadingPolicy::Lock(m_Mutex);
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
         return RemoveFileImpl(virtualPath);
     }
     
@@ -148,7 +218,7 @@ public:
      */
     virtual bool CopyFile(const std::string& srcVirtualPath, const std::string& dstVirtualPath, bool overwrite = false) override
     {
-        [[maybe_unused]] auto lock = ThreadingPolicy::Lock(m_Mutex);
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
         return CopyFileImpl(srcVirtualPath, dstVirtualPath, overwrite);
     }
     
@@ -157,7 +227,7 @@ public:
      */
     virtual bool RenameFile(const std::string& srcVirtualPath, const std::string& dstVirtualPath) override
     {
-        [[maybe_unused]] auto lock = ThreadingPolicy::Lock(m_Mutex);
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
         return RenameFileImpl(srcVirtualPath, dstVirtualPath);
     }
 
@@ -167,15 +237,35 @@ public:
     [[nodiscard]]
     virtual bool IsFileExists(const std::string& virtualPath) const override
     {
-        [[maybe_unused]] auto lock = ThreadingPolicy::Lock(m_Mutex);
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
         return IsFileExistsImpl(virtualPath);
     }
 
+    /*
+     * Get file metadata without opening file
+     */
+    [[nodiscard]]
+    virtual std::optional<FileStat> Stat(const std::string& virtualPath) const override
+    {
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
+        return StatImpl(virtualPath);
+    }
+
+    /*
+     * Read whole file without opening file object
+     */
+    [[nodiscard]]
+    virtual std::optional<FileBuffer> ReadAll(const std::string& virtualPath) const override
+    {
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
+        return ReadAllImpl(virtualPath);
+    }
+
 private:
     struct FileEntry
     {
         FileInfo Info;
-        std::vector<NativeFileWeakPtr> OpenedHandles;
+        std::vector<IFileWeakPtr> OpenedHandles;
 
         explicit FileEntry(const FileInfo& info)
             : Info(info)
@@ -184,8 +274,8 @@ private:
 
         void CleanupOpenedHandles(IFilePtr fileToExclude = nullptr)
         {
-            OpenedHandles.erase(std::remove_if(OpenedHandles.begin(), OpenedHandles.end(), [&](const NativeFileWeakPtr& weak) {
-                return weak.expired() || weak.lock() == fileToExclude;
+            OpenedHandles.erase(std::remove_if(OpenedHandles.begin(), OpenedHandles.end(), [&](const IFileWeakPtr& weak) {
+                return weak.expired() || IsSameFile(weak, fileToExclude);
             }), OpenedHandles.end());
         }
     };
@@ -257,20 +347,26 @@ private:
             return nullptr;
         }
 
-        const auto it = m_Files.find(virtualPath);
-        if (it == m_Files.end() && requestWrite) {
-            // Create new file entry if not exists in writable mode
+        auto entryIt = m_Files.find(virtualPath);
+        if (entryIt == m_Files.end() && requestWrite) {
+            // Create new file entry if not exists in writable mode, with missing directories
             FileInfo fileInfo(AliasPathImpl(), BasePathImpl(), virtualPath);
-            m_Files.emplace(fileInfo.VirtualPath(), fileInfo);
+            CreateParentDirectories(fileInfo.NativePath());
+            entryIt = m_Files.emplace(fileInfo.VirtualPath(), fileInfo).first;
         }
 
-        const auto entryIt = m_Files.find(virtualPath);
         if (entryIt == m_Files.end()) {
             return nullptr;
         }
         auto& entry = entryIt->second;
 
-        NativeFilePtr file = std::make_shared<NativeFile>(entry.Info);
+        IFilePtr file;
+        if (IFile::ModeHasFlag(mode, IFile::FileMode::ExclusiveOwner)) {
+            file = std::make_shared<ExclusiveNativeFile>(entry.Info);
+        } else {
+            file = std::make_shared<BasicNativeFile<Policy>>(entry.Info);
+        }
+
         if (!file || !file->Open(mode)) {
             return nullptr;
         }
@@ -280,9 +376,18 @@ private:
         return file;
     }
 
-    inline void CloseFileImpl(IFilePtr file)
+    inline bool CloseFileImpl(IFilePtr file)
+    {
+        return CloseFileAndCleanupOpenedHandles(file);
+    }
+
+    static void CreateParentDirectories(const std::string& nativePath)
     {
-        CloseFileAndCleanupOpenedHandles(file);
+        const size_t separator = nativePath.find_last_of("/\\");
+        if (separator != std::string::npos && separator > 0) {
+            std::error_code ec;
+            fs::create_directories(nativePath.substr(0, separator), ec);
+        }
     }
 
     inline bool RemoveFileImpl(const std::string& virtualPath)
@@ -298,9 +403,10 @@ private:
 
         CloseFileAndCleanupOpenedHandles();
 
+        const std::string nativePath = it->second.Info.NativePath();
         m_Files.erase(it);
         
-        return fs::remove(it->second.Info.NativePath());
+        return fs::remove(nativePath);
     }
 
     inline bool CopyFileImpl(const std::string& srcVirtualPath, const std::string& dstVirtualPath, bool overwrite = false)
@@ -399,6 +505,50 @@ private:
         return fileIt != m_Files.end() && fs::exists(fileIt->second.Info.NativePath());
     }
 
+    inline std::optional<FileBuffer> ReadAllImpl(const std::string& virtualPath) const
+    {
+        const auto fileIt = m_Files.find(virtualPath);
+        if (fileIt == m_Files.end()) {
+            return std::nullopt;
+        }
+        return NativeFile::ReadAll(fileIt->second.Info.NativePath());
+    }
+
+    inline std::optional<FileStat> StatImpl(const std::string& virtualPath) const
+    {
+        const auto fileIt = m_Files.find(virtualPath);
+        if (fileIt == m_Files.end()) {
+            return std::nullopt;
+        }
+        const auto& nativePath = fileIt->second.Info.NativePath();
+
+        FileStat fileStat;
+#if defined(VFSPP_POSIX_IO_ENABLED)
+        struct stat st;
+        if (::stat(nativePath.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) {
+            return std::nullopt;
+        }
+        fileStat.Size = static_cast<uint64_t>(st.st_size);
+        fileStat.ModifiedTime = st.st_mtime;
+#else
+        std::error_code ec;
+        const auto size = fs::file_size(nativePath, ec);
+        if (ec) {
+            return std::nullopt;
+        }
+        fileStat.Size = static_cast<uint64_t>(size);
+#ifndef VFSPP_DISABLE_STD_FILESYSTEM
+        const auto writeTime = fs::last_write_time(nativePath, ec);
+        if (!ec) {
+            const auto systemTime = std::chrono::time_point_cast<std::chrono::system_clock::duration>(writeTime - fs::file_time_type::clock::now() + std::chrono::system_clock::now());
+            fileStat.ModifiedTime = std::chrono::system_clock::to_time_t(systemTime);
+        }
+#endif
+#endif
+        fileStat.CompressedSize = fileStat.Size;
+        return fileStat;
+    }
+
     static bool IsDirectoryAccessible(const std::string& path)
     {
         const bool exists = fs::exists(path);
@@ -417,44 +567,93 @@ private:
         return false;
     }
 
-    void BuildFilelist(const std::string& aliasPath, const std::string& basePath, std::unordered_map<std::string, FileEntry>& outFiles)
+    void BuildFilelist(const std::string& aliasPath, const std::string& basePath, FileIndex<FileEntry, Policy>& outFiles)
     {
+        if (!m_Executor) {
+            std::vector<FileInfo> files;
+            ScanDirectory(aliasPath, basePath, files);
+            for (const auto& fileInfo : files) {
+                outFiles.emplace(fileInfo.VirtualPath(), fileInfo);
+            }
+            return;
+        }
+
+        // Top-level subdirectories are scanned in parallel, results are added in scan order
+        std::vector<FileInfo> rootFiles;
+        std::vector<std::string> directories;
         for (const auto& entry : fs::directory_iterator(basePath)) {
             if (fs::is_directory(entry.status())) {
-                BuildFilelist(aliasPath, entry.path().string(), outFiles);
-                continue;
-            } 
-            
-            FileInfo fileInfo(aliasPath, BasePathImpl(), entry.path().string());                
+                directories.push_back(entry.path().string());
+            } else {
+                std::string nativePath = entry.path().string();
+                if (nativePath.starts_with(BasePathImpl())) {
+                    nativePath.erase(0, BasePathImpl().length());
+                }
+                rootFiles.emplace_back(aliasPath, BasePathImpl(), nativePath);
+            }
+        }
+
+        std::vector<std::vector<FileInfo>> directoryFiles(directories.size());
+        ParallelFor(m_Executor.get(), directories.size(), [&](size_t i) {
+            ScanDirectory(aliasPath, directories[i], directoryFiles[i]);
+        });
+
+        for (const auto& fileInfo : rootFiles) {
             outFiles.emplace(fileInfo.VirtualPath(), fileInfo);
         }
+        for (const auto& files : directoryFiles) {
+            for (const auto& fileInfo : files) {
+                outFiles.emplace(fileInfo.VirtualPath(), fileInfo);
+            }
+        }
+    }
+
+    void ScanDirectory(const std::string& aliasPath, const std::string& directoryPath, std::vector<FileInfo>& outFiles) const
+    {
+        for (const auto& entry : fs::directory_iterator(directoryPath)) {
+            if (fs::is_directory(entry.status())) {
+                ScanDirectory(aliasPath, entry.path().string(), outFiles);
+                continue;
+            }
+
+            // Path relative to base, so absolute base is never mistaken for alias
+            std::string nativePath = entry.path().string();
+            if (nativePath.starts_with(BasePathImpl())) {
+                nativePath.erase(0, BasePathImpl().length());
+            }
+            outFiles.emplace_back(aliasPath, BasePathImpl(), nativePath);
+        }
     }
 
-    inline void CloseFileAndCleanupOpenedHandles(IFilePtr fileToClose = nullptr)
+    inline bool CloseFileAndCleanupOpenedHandles(IFilePtr fileToClose = nullptr)
     {
+        bool isClosed = true;
         if (fileToClose) {
             const auto virtualPath = fileToClose->GetFileInfo().VirtualPath();
 
             const auto it = m_Files.find(virtualPath);
             if (it == m_Files.end()) {
-                return;
+                return false;
             }
             
-            fileToClose->Close();
+            isClosed = fileToClose->Close();
         }
 
         for (auto& [path, entry] : m_Files) {
-            entry.CleanupOpenedHandles(fileToClose);
+            // Handle of file which failed to close stays registered
+            entry.CleanupOpenedHandles(isClosed ? fileToClose : nullptr);
         }
+        return isClosed;
     }
     
 private:    
     std::string m_AliasPath;
     std::string m_BasePath;
     bool m_IsInitialized = false;
-    mutable std::mutex m_Mutex;
+    ExecutorPtr m_Executor;
+    [[no_unique_address]] mutable typename Policy::Mutex m_Mutex;
 
-    std::unordered_map<std::string, FileEntry> m_Files;
+    FileIndex<FileEntry, Policy> m_Files;
 };
 
 } // namespace vfspp
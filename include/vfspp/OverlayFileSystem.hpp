@@ -0,0 +1,584 @@
+#ifndef VFSPP_OVERLAYFILESYSTEM_HPP
+#define VFSPP_OVERLAYFILESYSTEM_HPP
+
+#include "IFileSystem.h"
+#include "Alias.hpp"
+#include "FileIndex.hpp"
+#include "FileTransfer.hpp"
+#include "Global.h"
+#include "ThreadingPolicy.hpp"
+
+namespace vfspp
+{
+
+template<typename Policy>
+class BasicOverlayFileSystem;
+
+using OverlayFileSystem = BasicOverlayFileSystem<ThreadingPolicy>;
+using OverlayFileSystemPtr = std::shared_ptr<OverlayFileSystem>;
+using OverlayFileSystemWeakPtr = std::weak_ptr<OverlayFileSystem>;
+
+
+/*
+ * Union of read-only lower layer and writable upper layer mounted at same alias. Files of
+ * upper layer hide files of lower one. File of lower layer opened for writing is copied
+ * to upper layer first, removed file of lower layer is hidden by whiteout. Whiteouts are
+ * stored in upper layer as empty ".wh.<name>" files next to hidden file, so they persist
+ * with native upper layer. Reads of unmodified files go to lower layer directly.
+ * Calls are synchronized by Policy
+ */
+template<typename Policy>
+class BasicOverlayFileSystem final : public IFileSystem
+{
+public:
+    /*
+     * Layers must be created with same alias as overlay, they are initialized with
+     * overlay if needed
+     */
+    BasicOverlayFileSystem(const std::string& aliasPath, IFileSystemPtr lower, IFileSystemPtr upper)
+        : m_AliasPath(aliasPath)
+        , m_Lower(std::move(lower))
+        , m_Upper(std::move(upper))
+    {
+    }
+
+    ~BasicOverlayFileSystem()
+    {
+        Shutdown();
+    }
+
+    /*
+     * Initialize filesystem, call this method as soon as possible
+     */
+    [[nodiscard]]
+    virtual bool Initialize() override
+    {
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
+        return InitializeImpl();
+    }
+
+    /*
+     * Shutdown filesystem and both layers
+     */
+    virtual void Shutdown() override
+    {
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
+        ShutdownImpl();
+    }
+
+    /*
+     * Set executor for parallel work of layers
+     */
+    virtual void SetExecutor(ExecutorPtr executor) override
+    {
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
+        if (m_Lower && m_Upper) {
+            m_Lower->SetExecutor(executor);
+            m_Upper->SetExecutor(executor);
+        }
+    }
+
+    /*
+     * Switch case sensitivity of file lookups of overlay and both layers, if any of them
+     * fails all keep previous mode
+     */
+    virtual bool SetCaseSensitive(bool isCaseSensitive) override
+    {
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
+        if (!m_Lower || !m_Upper) {
+            return m_Whiteouts.SetCaseSensitive(isCaseSensitive);
+        }
+
+        // Switching back to previous mode can't fail, only folding finds collisions
+        const bool wasCaseSensitive = m_Whiteouts.IsCaseSensitive();
+        if (!m_Whiteouts.SetCaseSensitive(isCaseSensitive)) {
+            return false;
+        }
+        if (!m_Lower->SetCaseSensitive(isCaseSensitive)) {
+            m_Whiteouts.SetCaseSensitive(wasCaseSensitive);
+            return false;
+        }
+        if (!m_Upper->SetCaseSensitive(isCaseSensitive)) {
+            m_Lower->SetCaseSensitive(wasCaseSensitive);
+            m_Whiteouts.SetCaseSensitive(wasCaseSensitive);
+            return false;
+        }
+        return true;
+    }
+
+    /*
+     * Check if file lookups are case sensitive
+     */
+    [[nodiscard]]
+    virtual bool IsCaseSensitive() const override
+    {
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
+        return m_Whiteouts.IsCaseSensitive();
+    }
+
+    /*
+     * Check if filesystem is initialized
+     */
+    [[nodiscard]]
+    virtual bool IsInitialized() const override
+    {
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
+        return m_IsInitialized;
+    }
+
+    /*
+     * Get base path of upper layer
+     */
+    [[nodiscard]]
+    virtual const std::string& BasePath() const override
+    {
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
+        return m_Upper ? m_Upper->BasePath() : m_AliasPath;
+    }
+
+    /*
+     * Get mounted path
+     */
+    [[nodiscard]]
+    virtual const std::string& VirtualPath() const override
+    {
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
+        return m_AliasPath;
+    }
+
+    /*
+     * Retrieve all visible files of both layers. Heavy operation, avoid calling this often
+     */
+    [[nodiscard]]
+    virtual FilesList GetFilesList() const override
+    {
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
+
+        FilesList list;
+        ForEachFileImpl([&](const FileInfo& fileInfo) {
+            list.push_back(fileInfo);
+            return true;
+        });
+        return list;
+    }
+
+    /*
+     * Call visitor for each visible file, files of upper layer first. Stops when visitor
+     * returns false
+     */
+    virtual void ForEachFile(const FileVisitor& visitor) const override
+    {
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
+        ForEachFileImpl(visitor);
+    }
+
+    /*
+     * List files and directories of directory in both layers, paths of directories end
+     * with '/'. Directory of lower layer stays listed when all its files are removed
+     */
+    [[nodiscard]]
+    virtual std::vector<std::string> ListDirectory(const std::string& virtualPath, bool recursive = false) const override
+    {
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
+        if (!m_IsInitialized) {
+            return {};
+        }
+
+        std::set<std::string> entries;
+        for (auto& path : m_Upper->ListDirectory(virtualPath, recursive)) {
+            if (!IsWhiteoutMarker(path)) {
+                entries.insert(std::move(path));
+            }
+        }
+        for (auto& path : m_Lower->ListDirectory(virtualPath, recursive)) {
+            if (path.ends_with('/') || !IsWhiteoutImpl(path)) {
+                entries.insert(std::move(path));
+            }
+        }
+        return std::vector<std::string>(entries.begin(), entries.end());
+    }
+
+    /*
+     * Find visible files matching pattern. Returns sorted virtual paths
+     */
+    [[nodiscard]]
+    virtual std::vector<std::string> FindFiles(const GlobPattern& pattern) const override
+    {
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
+        if (!m_IsInitialized) {
+            return {};
+        }
+
+        std::set<std::string> files;
+        for (auto& path : m_Upper->FindFiles(pattern)) {
+            if (!IsWhiteoutMarker(path)) {
+                files.insert(std::move(path));
+            }
+        }
+        for (auto& path : m_Lower->FindFiles(pattern)) {
+            if (!IsWhiteoutImpl(path)) {
+                files.insert(std::move(path));
+            }
+        }
+        return std::vector<std::string>(files.begin(), files.end());
+    }
+
+    /*
+     * Overlay is writable through upper layer
+     */
+    [[nodiscard]]
+    virtual bool IsReadOnly() const override
+    {
+        return false;
+    }
+
+    /*
+     * Open file of layer it's visible in. File of lower layer opened for writing is
+     * copied to upper layer first, unless it's truncated. Missing file opened for
+     * writing is created in upper layer
+     */
+    virtual IFilePtr OpenFile(const std::string& virtualPath, IFile::FileMode mode) override
+    {
+        if (!IFile::ModeHasFlag(mode, IFile::FileMode::Write)) {
+            [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
+            const IFileSystemPtr* layer = FindLayerImpl(virtualPath);
+            return layer ? (*layer)->OpenFile(virtualPath, mode) : nullptr;
+        }
+
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
+        return OpenWritableImpl(virtualPath, mode);
+    }
+
+    /*
+     * Close file
+     */
+    virtual bool CloseFile(IFilePtr file) override
+    {
+        if (!file) {
+            return false;
+        }
+
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
+        const IFileSystemPtr* layer = FindLayerImpl(file->GetFileInfo().VirtualPath());
+        if (layer) {
+            return (*layer)->CloseFile(file);
+        }
+        return file->Close();
+    }
+
+    /*
+     * Create empty file in upper layer
+     */
+    virtual IFilePtr CreateFile(const std::string& virtualPath) override
+    {
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
+        return OpenWritableImpl(virtualPath, IFile::FileMode::ReadWrite | IFile::FileMode::Truncate);
+    }
+
+    /*
+     * Remove file from upper layer and hide file of lower layer by whiteout
+     */
+    virtual bool RemoveFile(const std::string& virtualPath) override
+    {
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
+        return RemoveFileImpl(virtualPath);
+    }
+
+    /*
+     * Copy visible file, copy is always written to upper layer
+     */
+    virtual bool CopyFile(const std::string& srcVirtualPath, const std::string& dstVirtualPath, bool overwrite = false) override
+    {
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
+        return CopyFileImpl(srcVirtualPath, dstVirtualPath, overwrite);
+    }
+
+    /*
+     * Rename visible file, renamed file of lower layer is copied up and hidden by whiteout
+     */
+    virtual bool RenameFile(const std::string& srcVirtualPath, const std::string& dstVirtualPath) override
+    {
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
+        return CopyFileImpl(srcVirtualPath, dstVirtualPath, false) && RemoveFileImpl(srcVirtualPath);
+    }
+
+    /*
+     * Check if file is visible in any layer
+     */
+    [[nodiscard]]
+    virtual bool IsFileExists(const std::string& virtualPath) const override
+    {
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
+        return FindLayerImpl(virtualPath) != nullptr;
+    }
+
+    /*
+     * Get metadata of file from layer it's visible in
+     */
+    [[nodiscard]]
+    virtual std::optional<FileStat> Stat(const std::string& virtualPath) const override
+    {
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
+        const IFileSystemPtr* layer = FindLayerImpl(virtualPath);
+        return layer ? (*layer)->Stat(virtualPath) : std::nullopt;
+    }
+
+    /*
+     * Read whole file from layer it's visible in
+     */
+    [[nodiscard]]
+    virtual std::optional<FileBuffer> ReadAll(const std::string& virtualPath) const override
+    {
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
+        const IFileSystemPtr* layer = FindLayerImpl(virtualPath);
+        return layer ? (*layer)->ReadAll(virtualPath) : std::nullopt;
+    }
+
+    /*
+     * Check if file of lower layer is hidden by whiteout
+     */
+    [[nodiscard]]
+    bool IsWhiteout(const std::string& virtualPath) const
+    {
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
+        return IsWhiteoutImpl(virtualPath);
+    }
+
+private:
+    inline bool InitializeImpl()
+    {
+        if (m_IsInitialized) {
+            return true;
+        }
+
+        if (!m_Lower || !m_Upper) {
+            return false;
+        }
+
+        // Layers resolve same virtual paths as overlay
+        const Alias alias(m_AliasPath);
+        if (Alias(m_Lower->VirtualPath()) != alias || Alias(m_Upper->VirtualPath()) != alias) {
+            return false;
+        }
+
+        if ((!m_Lower->IsInitialized() && !m_Lower->Initialize()) || (!m_Upper->IsInitialized() && !m_Upper->Initialize())) {
+            return false;
+        }
+
+        if (m_Upper->IsReadOnly()) {
+            return false;
+        }
+
+        m_Whiteouts.clear();
+        m_Upper->ForEachFile([&](const FileInfo& fileInfo) {
+            const std::string& path = fileInfo.VirtualPath();
+            if (IsWhiteoutMarker(path)) {
+                m_Whiteouts.try_emplace(WhiteoutTarget(path), true);
+            }
+            return true;
+        });
+
+        m_IsInitialized = true;
+        return true;
+    }
+
+    inline void ShutdownImpl()
+    {
+        if (!m_IsInitialized) {
+            return;
+        }
+
+        m_Lower->Shutdown();
+        m_Upper->Shutdown();
+        m_Whiteouts.clear();
+        m_IsInitialized = false;
+    }
+
+    // Layer file is visible in, null if file isn't visible
+    inline const IFileSystemPtr* FindLayerImpl(const std::string& virtualPath) const
+    {
+        if (!m_IsInitialized || IsWhiteoutMarker(virtualPath)) {
+            return nullptr;
+        }
+        if (m_Upper->IsFileExists(virtualPath)) {
+            return &m_Upper;
+        }
+        if (!IsWhiteoutImpl(virtualPath) && m_Lower->IsFileExists(virtualPath)) {
+            return &m_Lower;
+        }
+        return nullptr;
+    }
+
+    template<typename Visitor>
+    void ForEachFileImpl(Visitor&& visitor) const
+    {
+        if (!m_IsInitialized) {
+            return;
+        }
+
+        bool isStopped = false;
+        m_Upper->ForEachFile([&](const FileInfo& fileInfo) {
+            if (IsWhiteoutMarker(fileInfo.VirtualPath())) {
+                return true;
+            }
+            isStopped = !visitor(fileInfo);
+            return !isStopped;
+        });
+
+        if (isStopped) {
+            return;
+        }
+
+        m_Lower->ForEachFile([&](const FileInfo& fileInfo) {
+            const std::string& path = fileInfo.VirtualPath();
+            if (IsWhiteoutImpl(path) || m_Upper->IsFileExists(path)) {
+                return true;
+            }
+            return static_cast<bool>(visitor(fileInfo));
+        });
+    }
+
+    inline IFilePtr OpenWritableImpl(const std::string& virtualPath, IFile::FileMode mode)
+    {
+        if (!m_IsInitialized || IsWhiteoutMarker(virtualPath)) {
+            return nullptr;
+        }
+
+        if (!m_Upper->IsFileExists(virtualPath) && !IsWhiteoutImpl(virtualPath) && m_Lower->IsFileExists(virtualPath)) {
+            // Truncated file doesn't need old content
+            const bool isTruncated = IFile::ModeHasFlag(mode, IFile::FileMode::Truncate);
+            if (!isTruncated && !CopyUpImpl(virtualPath, virtualPath)) {
+                return nullptr;
+            }
+        }
+
+        IFilePtr file = m_Upper->OpenFile(virtualPath, mode);
+        if (file) {
+            RemoveWhiteoutImpl(virtualPath);
+        }
+        return file;
+    }
+
+    inline bool RemoveFileImpl(const std::string& virtualPath)
+    {
+        const IFileSystemPtr* layer = FindLayerImpl(virtualPath);
+        if (!layer) {
+            return false;
+        }
+
+        if (layer == &m_Upper && !m_Upper->RemoveFile(virtualPath)) {
+            return false;
+        }
+
+        // Hide file of lower layer that would show through
+        if (m_Lower->IsFileExists(virtualPath)) {
+            AddWhiteoutImpl(virtualPath);
+        }
+        return true;
+    }
+
+    inline bool CopyFileImpl(const std::string& srcVirtualPath, const std::string& dstVirtualPath, bool overwrite)
+    {
+        const IFileSystemPtr* srcLayer = FindLayerImpl(srcVirtualPath);
+        if (!srcLayer || IsWhiteoutMarker(dstVirtualPath)) {
+            return false;
+        }
+        if (!overwrite && FindLayerImpl(dstVirtualPath)) {
+            return false;
+        }
+
+        const bool isCopied = (srcLayer == &m_Upper) ? m_Upper->CopyFile(srcVirtualPath, dstVirtualPath, true) : CopyUpImpl(srcVirtualPath, dstVirtualPath);
+        if (isCopied) {
+            RemoveWhiteoutImpl(dstVirtualPath);
+        }
+        return isCopied;
+    }
+
+    inline bool CopyUpImpl(const std::string& srcVirtualPath, const std::string& dstVirtualPath)
+    {
+        IFilePtr target = m_Upper->OpenFile(dstVirtualPath, IFile::FileMode::Write | IFile::FileMode::Truncate);
+        if (!target) {
+            return false;
+        }
+
+        bool isCopied = FileTransfer::Copy(*m_Lower, srcVirtualPath, *target);
+        isCopied = m_Upper->CloseFile(target) && isCopied;
+        if (!isCopied) {
+            m_Upper->RemoveFile(dstVirtualPath);
+        }
+        return isCopied;
+    }
+
+    inline bool IsWhiteoutImpl(const std::string& virtualPath) const
+    {
+        return m_Whiteouts.find(virtualPath) != m_Whiteouts.end();
+    }
+
+    // Whiteout applies even if marker can't be stored, it's lost on reinitialization then
+    inline void AddWhiteoutImpl(const std::string& virtualPath)
+    {
+        if (IsWhiteoutImpl(virtualPath)) {
+            return;
+        }
+
+        IFilePtr marker = m_Upper->OpenFile(WhiteoutMarker(virtualPath), IFile::FileMode::Write | IFile::FileMode::Truncate);
+        const bool isStored = marker && m_Upper->CloseFile(marker);
+        m_Whiteouts.try_emplace(virtualPath, isStored);
+    }
+
+    inline void RemoveWhiteoutImpl(const std::string& virtualPath)
+    {
+        const auto it = m_Whiteouts.find(virtualPath);
+        if (it == m_Whiteouts.end()) {
+            return;
+        }
+
+        if (it->second) {
+            m_Upper->RemoveFile(WhiteoutMarker(virtualPath));
+        }
+        m_Whiteouts.erase(it);
+    }
+
+    static constexpr std::string_view kWhiteoutPrefix = ".wh.";
+
+    static size_t FileNameOffset(std::string_view virtualPath)
+    {
+        const size_t separator = virtualPath.rfind('/');
+        return separator == std::string_view::npos ? 0 : separator + 1;
+    }
+
+    static bool IsWhiteoutMarker(std::string_view virtualPath)
+    {
+        return virtualPath.substr(FileNameOffset(virtualPath)).starts_with(kWhiteoutPrefix);
+    }
+
+    // "/dir/name" to "/dir/.wh.name"
+    static std::string WhiteoutMarker(std::string_view virtualPath)
+    {
+        std::string marker(virtualPath);
+        marker.insert(FileNameOffset(virtualPath), kWhiteoutPrefix);
+        return marker;
+    }
+
+    // "/dir/.wh.name" to "/dir/name"
+    static std::string WhiteoutTarget(std::string_view markerPath)
+    {
+        std::string target(markerPath);
+        target.erase(FileNameOffset(markerPath), kWhiteoutPrefix.size());
+        return target;
+    }
+
+private:
+    std::string m_AliasPath;
+    IFileSystemPtr m_Lower;
+    IFileSystemPtr m_Upper;
+    bool m_IsInitialized = false;
+
+    // Hidden files of lower layer, value tells if marker is stored in upper layer
+    FileIndex<bool, Policy> m_Whiteouts;
+    [[no_unique_address]] mutable typename Policy::Mutex m_Mutex;
+};
+
+} // namespace vfspp
+
+#endif // VFSPP_OVERLAYFILESYSTEM_HPP
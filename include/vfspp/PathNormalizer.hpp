@@ -0,0 +1,332 @@
+#ifndef VFSPP_PATHNORMALIZER_HPP
+#define VFSPP_PATHNORMALIZER_HPP
+
+#include "Global.h"
+
+#include <bit>
+#include <string_view>
+
+// Vectorized scan of long paths, selected by compiler target flags
+#if defined(__AVX2__)
+#define VFSPP_PATH_AVX2
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define VFSPP_PATH_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace vfspp
+{
+
+/*
+ * Single pass virtual path normalization. Normalized path starts with '/', uses '/' as
+ * separator, has no duplicate separators and no '.' or '..' components, letters are
+ * optionally folded to lower case. Trailing separator is kept, so directory paths stay
+ * directory paths. Path is invalid if it contains '\0' or '..' goes above root
+ */
+class PathNormalizer final
+{
+public:
+    /*
+     * Get buffer size enough to normalize path of given length
+     */
+    [[nodiscard]]
+    static constexpr size_t BufferSize(size_t pathLength) noexcept
+    {
+        return pathLength + 1;
+    }
+
+    /*
+     * Normalize path into buffer of at least BufferSize(path.size()) bytes. Returns length
+     * of normalized path, nothing if path is invalid or buffer is too small
+     */
+    [[nodiscard]]
+    static std::optional<size_t> Normalize(std::string_view path, std::span<char> buffer, bool foldCase = false) noexcept
+    {
+        if (buffer.size() < BufferSize(path.size())) {
+            return std::nullopt;
+        }
+
+        const char* in = path.data();
+        const size_t size = path.size();
+        char* out = buffer.data();
+
+        out[0] = '/';
+        size_t length = 1;
+        size_t componentStart = 1;
+        size_t i = 0;
+
+        while (i < size) {
+#if defined(VFSPP_PATH_AVX2) || defined(VFSPP_PATH_SSE2)
+            // Characters before first one needing attention are copied by block. Block can't
+            // complete '.' or '..' component started before it
+            if (i + kBlockSize < size && !IsDotPrefix(out + componentStart, length - componentStart)) {
+                uint32_t separators = 0;
+                const size_t count = CopyBlock(in + i, out + length, foldCase, separators);
+                if (separators != 0) {
+                    componentStart = length + static_cast<size_t>(std::bit_width(separators));
+                }
+                length += count;
+                i += count;
+                if (count == kBlockSize) {
+                    continue;
+                }
+            }
+#endif
+            const char c = in[i++];
+            if (c == '/' || c == '\\') {
+                if (!EndComponent(out, length, componentStart, true)) {
+                    return std::nullopt;
+                }
+            } else if (c == '\0') {
+                return std::nullopt;
+            } else {
+                out[length++] = foldCase ? FoldCase(c) : c;
+            }
+        }
+
+        if (!EndComponent(out, length, componentStart, false)) {
+            return std::nullopt;
+        }
+        return length;
+    }
+
+    /*
+     * Normalize path into new string, nothing if path is invalid
+     */
+    [[nodiscard]]
+    static std::optional<std::string> Normalize(std::string_view path, bool foldCase = false)
+    {
+        std::string normalized(BufferSize(path.size()), '\0');
+        const auto length = Normalize(path, normalized, foldCase);
+        if (!length) {
+            return std::nullopt;
+        }
+        normalized.resize(*length);
+        return normalized;
+    }
+
+    /*
+     * Check if path is already normalized without writing anything
+     */
+    [[nodiscard]]
+    static bool IsNormalized(std::string_view path, bool foldCase = false) noexcept
+    {
+        if (path.empty() || path.front() != '/') {
+            return false;
+        }
+
+        const char* in = path.data();
+        const size_t size = path.size();
+        size_t i = 0;
+
+        while (i < size) {
+#if defined(VFSPP_PATH_AVX2) || defined(VFSPP_PATH_SSE2)
+            if (i + kBlockSize < size) {
+                const uint32_t mask = AttentionMask(in + i, foldCase);
+                if (mask == 0) {
+                    i += kBlockSize;
+                    continue;
+                }
+                i += static_cast<size_t>(std::countr_zero(mask));
+            }
+#endif
+            const char c = in[i];
+            if (c == '\\' || c == '\0' || (foldCase && FoldCase(c) != c)) {
+                return false;
+            }
+            if (c == '/') {
+                const std::string_view next = path.substr(i + 1);
+                if (next.starts_with('/') || IsDotComponent(next)) {
+                    return false;
+                }
+            }
+            i++;
+        }
+        return true;
+    }
+
+    /*
+     * Get normalized path, path itself is returned when it's already normalized, otherwise
+     * path is normalized into storage. Invalid path gives empty string, which doesn't
+     * match any virtual path
+     */
+    [[nodiscard]]
+    static const std::string& NormalizeIfNeeded(const std::string& path, std::string& storage, bool foldCase = false)
+    {
+        if (IsNormalized(path, foldCase)) {
+            return path;
+        }
+
+        storage.resize(BufferSize(path.size()));
+        const auto length = Normalize(path, storage, foldCase);
+        storage.resize(length.value_or(0));
+        return storage;
+    }
+
+    [[nodiscard]]
+    static constexpr char FoldCase(char c) noexcept
+    {
+        return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+    }
+
+    /*
+     * Compare paths ignoring ASCII case
+     */
+    [[nodiscard]]
+    static bool EqualsFolded(std::string_view first, std::string_view second) noexcept
+    {
+        return first.size() == second.size() && std::equal(first.begin(), first.end(), second.begin(), [](char a, char b) {
+            return FoldCase(a) == FoldCase(b);
+        });
+    }
+
+    /*
+     * Check if path starts with prefix ignoring ASCII case
+     */
+    [[nodiscard]]
+    static bool StartsWithFolded(std::string_view path, std::string_view prefix) noexcept
+    {
+        return path.size() >= prefix.size() && EqualsFolded(path.substr(0, prefix.size()), prefix);
+    }
+
+    /*
+     * Order paths ignoring ASCII case, bytes are compared unsigned as by std::string
+     */
+    [[nodiscard]]
+    static bool LessFolded(std::string_view first, std::string_view second) noexcept
+    {
+        return std::lexicographical_compare(first.begin(), first.end(), second.begin(), second.end(), [](char a, char b) {
+            return static_cast<uint8_t>(FoldCase(a)) < static_cast<uint8_t>(FoldCase(b));
+        });
+    }
+
+private:
+    // Component being written is "." or "..", or its prefix
+    static bool IsDotPrefix(const char* component, size_t length) noexcept
+    {
+        return length <= 2 && (length == 0 || component[length - 1] == '.') && (length < 2 || component[0] == '.');
+    }
+
+    // Path starts with "." or ".." component
+    static bool IsDotComponent(std::string_view path) noexcept
+    {
+        const size_t dots = path.starts_with("..") ? 2 : (path.starts_with('.') ? 1 : 0);
+        return dots > 0 && (path.size() == dots || path[dots] == '/' || path[dots] == '\\');
+    }
+
+    // Finish component written at componentStart, '.' is dropped and '..' removes previous component
+    static bool EndComponent(char* out, size_t& length, size_t& componentStart, bool appendSeparator) noexcept
+    {
+        const size_t componentLength = length - componentStart;
+        if (componentLength == 0) {
+            return true;
+        }
+
+        if (componentLength == 1 && out[componentStart] == '.') {
+            length = componentStart;
+            return true;
+        }
+
+        if (componentLength == 2 && out[componentStart] == '.' && out[componentStart + 1] == '.') {
+            if (componentStart == 1) {
+                return false;
+            }
+
+            size_t parentStart = componentStart - 1;
+            while (parentStart > 0 && out[parentStart - 1] != '/') {
+                parentStart--;
+            }
+            length = parentStart;
+            componentStart = parentStart;
+            return true;
+        }
+
+        if (appendSeparator) {
+            out[length++] = '/';
+        }
+        componentStart = length;
+        return true;
+    }
+
+#if defined(VFSPP_PATH_AVX2)
+    static constexpr size_t kBlockSize = 32;
+    using Block = __m256i;
+
+    static Block Load(const char* in) noexcept { return _mm256_loadu_si256(reinterpret_cast<const Block*>(in)); }
+    static void Store(char* out, Block block) noexcept { _mm256_storeu_si256(reinterpret_cast<Block*>(out), block); }
+    static Block Splat(char c) noexcept { return _mm256_set1_epi8(c); }
+    static Block Equal(Block a, Block b) noexcept { return _mm256_cmpeq_epi8(a, b); }
+    static Block Greater(Block a, Block b) noexcept { return _mm256_cmpgt_epi8(a, b); }
+    static Block And(Block a, Block b) noexcept { return _mm256_and_si256(a, b); }
+    static Block Or(Block a, Block b) noexcept { return _mm256_or_si256(a, b); }
+    static uint32_t Mask(Block block) noexcept { return static_cast<uint32_t>(_mm256_movemask_epi8(block)); }
+#elif defined(VFSPP_PATH_SSE2)
+    static constexpr size_t kBlockSize = 16;
+    using Block = __m128i;
+
+    static Block Load(const char* in) noexcept { return _mm_loadu_si128(reinterpret_cast<const Block*>(in)); }
+    static void Store(char* out, Block block) noexcept { _mm_storeu_si128(reinterpret_cast<Block*>(out), block); }
+    static Block Splat(char c) noexcept { return _mm_set1_epi8(c); }
+    static Block Equal(Block a, Block b) noexcept { return _mm_cmpeq_epi8(a, b); }
+    static Block Greater(Block a, Block b) noexcept { return _mm_cmpgt_epi8(a, b); }
+    static Block And(Block a, Block b) noexcept { return _mm_and_si128(a, b); }
+    static Block Or(Block a, Block b) noexcept { return _mm_or_si128(a, b); }
+    static uint32_t Mask(Block block) noexcept { return static_cast<uint32_t>(_mm_movemask_epi8(block)); }
+#endif
+
+#if defined(VFSPP_PATH_AVX2) || defined(VFSPP_PATH_SSE2)
+    // Upper case ASCII letters, signed compare leaves bytes above 0x7f untouched
+    static Block UpperMask(Block block) noexcept
+    {
+        return And(Greater(block, Splat('A' - 1)), Greater(Splat('Z' + 1), block));
+    }
+
+    // Mask of block positions scalar code has to look at: backslash, '\0' and separator
+    // followed by separator or '.'. Reads one byte past block
+    static uint32_t AttentionMask(const char* in, Block& outBlock, uint32_t& outSeparators) noexcept
+    {
+        outBlock = Load(in);
+        const Block next = Load(in + 1);
+
+        const Block separator = Equal(outBlock, Splat('/'));
+        const Block nextSpecial = Or(Or(Equal(next, Splat('/')), Equal(next, Splat('\\'))), Equal(next, Splat('.')));
+        const Block attention = Or(And(separator, nextSpecial), Or(Equal(outBlock, Splat('\\')), Equal(outBlock, Splat('\0'))));
+
+        outSeparators = Mask(separator);
+        return Mask(attention);
+    }
+
+    // Same as above, upper case letters need attention too when folding
+    static uint32_t AttentionMask(const char* in, bool foldCase) noexcept
+    {
+        Block block;
+        uint32_t separators = 0;
+        const uint32_t mask = AttentionMask(in, block, separators);
+        return foldCase ? mask | Mask(UpperMask(block)) : mask;
+    }
+
+    // Copy characters of block before first one needing attention, returns number of
+    // copied characters and mask of copied separators. Stores whole block, output has
+    // room for it because block is inside input
+    static size_t CopyBlock(const char* in, char* out, bool foldCase, uint32_t& outSeparators) noexcept
+    {
+        Block block;
+        uint32_t separators = 0;
+        const uint32_t mask = AttentionMask(in, block, separators);
+
+        if (foldCase) {
+            block = Or(block, And(UpperMask(block), Splat(0x20)));
+        }
+        Store(out, block);
+
+        const size_t count = mask == 0 ? kBlockSize : static_cast<size_t>(std::countr_zero(mask));
+        outSeparators = count >= 32 ? separators : separators & ((1u << count) - 1u);
+        return count;
+    }
+#endif
+};
+
+} // namespace vfspp
+
+#endif // VFSPP_PATHNORMALIZER_HPP
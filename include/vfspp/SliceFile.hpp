@@ -0,0 +1,278 @@
+#ifndef VFSPP_SLICEFILE_HPP
+#define VFSPP_SLICEFILE_HPP
+
+#include "IFile.h"
+#include "ThreadingPolicy.hpp"
+#include "NativeBlob.hpp"
+
+namespace vfspp
+{
+
+template<typename Policy, typename Blob = NativeBlob>
+class BasicSliceFile;
+
+using SliceFile = BasicSliceFile<ThreadingPolicy>;
+using SliceFilePtr = std::shared_ptr<SliceFile>;
+using SliceFileWeakPtr = std::weak_ptr<SliceFile>;
+
+// Handle owned by single thread, calls are not synchronized
+using ExclusiveSliceFile = BasicSliceFile<SingleThreadedPolicy>;
+
+
+/*
+ * Read-only file which is range of blob. Reads are positional reads of blob or copies
+ * from its mapped memory. Blob is NativeBlob or other blob with same Size, Memory and
+ * ReadAt, e.g. ZstdBlob. Calls are synchronized by Policy
+ */
+template<typename Policy, typename Blob>
+class BasicSliceFile final : public IFile
+{
+public:
+    BasicSliceFile(const FileInfo& fileInfo, std::weak_ptr<Blob> blob, uint64_t offset, uint64_t size)
+        : m_FileInfo(fileInfo)
+        , m_Blob(std::move(blob))
+        , m_Offset(offset)
+        , m_Size(size)
+    {
+    }
+
+    ~BasicSliceFile()
+    {
+        Close();
+    }
+
+    /*
+     * Get file information
+     */
+    [[nodiscard]]
+    virtual const FileInfo& GetFileInfo() const override
+    {
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
+        return m_FileInfo;
+    }
+
+    /*
+     * Returns file size
+     */
+    [[nodiscard]]
+    virtual uint64_t Size() const override
+    {
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
+        return m_Size;
+    }
+
+    /*
+     * Slices are always read-only
+     */
+    [[nodiscard]]
+    virtual bool IsReadOnly() const override
+    {
+        return true;
+    }
+
+    /*
+     * Open file for reading
+     */
+    [[nodiscard]]
+    virtual bool Open(FileMode mode) override
+    {
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
+        if (!IFile::IsModeValid(mode) || IFile::ModeHasFlag(mode, FileMode::Write) || m_Blob.expired()) {
+            return false;
+        }
+
+        m_IsOpened = true;
+        m_SeekPos = 0;
+        return true;
+    }
+
+    /*
+     * Close file
+     */
+    virtual bool Close() override
+    {
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
+        m_IsOpened = false;
+        m_SeekPos = 0;
+        return true;
+    }
+
+    /*
+     * Check is file ready for reading
+     */
+    [[nodiscard]]
+    virtual bool IsOpened() const override
+    {
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
+        return IsOpenedImpl();
+    }
+
+    /*
+     * Check if read data didn't match checksum, file has no checksum
+     */
+    [[nodiscard]]
+    virtual bool IsCorrupted() const override
+    {
+        return false;
+    }
+
+    /*
+     * Seek on a file
+     */
+    virtual uint64_t Seek(uint64_t offset, Origin origin) override
+    {
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
+        return SeekImpl(offset, origin);
+    }
+
+    /*
+     * Returns offset in file
+     */
+    [[nodiscard]]
+    virtual uint64_t Tell() const override
+    {
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
+        return m_SeekPos;
+    }
+
+    /*
+     * Read data from file to buffer
+     */
+    virtual uint64_t Read(std::span<uint8_t> buffer) override
+    {
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
+        return ReadVImpl(std::span<const std::span<uint8_t>>(&buffer, 1));
+    }
+
+    /*
+     * Read data from file to vector
+     */
+    virtual uint64_t Read(std::vector<uint8_t>& buffer, uint64_t size) override
+    {
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
+        buffer.resize(static_cast<size_t>(size));
+        const auto data = std::span<uint8_t>(buffer);
+        return ReadVImpl(std::span<const std::span<uint8_t>>(&data, 1));
+    }
+
+    /*
+     * Read data from absolute offset to buffer, doesn't move file cursor
+     */
+    virtual uint64_t ReadAt(uint64_t offset, std::span<uint8_t> buffer) override
+    {
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
+        return ReadVAtImpl(offset, std::span<const std::span<uint8_t>>(&buffer, 1));
+    }
+
+    /*
+     * Read consecutive data from file to several buffers filled in order, moves file cursor
+     */
+    virtual uint64_t ReadV(std::span<const std::span<uint8_t>> buffers) override
+    {
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
+        return ReadVImpl(buffers);
+    }
+
+    /*
+     * Slices are read-only
+     */
+    virtual uint64_t Write(std::span<const uint8_t> /*buffer*/) override
+    {
+        return 0;
+    }
+
+    /*
+     * Slices are read-only
+     */
+    virtual uint64_t Write(const std::vector<uint8_t>& /*buffer*/) override
+    {
+        return 0;
+    }
+
+    /*
+     * Get slice data if blob is mapped to memory
+     */
+    [[nodiscard]]
+    virtual std::optional<FileBuffer> MappedData() override
+    {
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
+        std::shared_ptr<Blob> blob = m_Blob.lock();
+        if (!blob || blob->Memory().empty()) {
+            return std::nullopt;
+        }
+        const auto memory = blob->Memory().subspan(static_cast<size_t>(m_Offset), static_cast<size_t>(m_Size));
+        return FileBuffer(std::move(blob), memory);
+    }
+
+private:
+    inline bool IsOpenedImpl() const
+    {
+        return m_IsOpened && !m_Blob.expired();
+    }
+
+    inline uint64_t SeekImpl(uint64_t offset, Origin origin)
+    {
+        if (!IsOpenedImpl()) {
+            return 0;
+        }
+
+        if (origin == IFile::Origin::Begin) {
+            m_SeekPos = offset;
+        } else if (origin == IFile::Origin::End) {
+            m_SeekPos = (offset <= m_Size) ? m_Size - offset : 0;
+        } else if (origin == IFile::Origin::Set) {
+            m_SeekPos += offset;
+        }
+        m_SeekPos = std::min(m_SeekPos, m_Size);
+
+        return m_SeekPos;
+    }
+
+    inline uint64_t ReadVImpl(std::span<const std::span<uint8_t>> buffers)
+    {
+        const auto read = ReadVAtImpl(m_SeekPos, buffers);
+        m_SeekPos += read;
+        return read;
+    }
+
+    inline uint64_t ReadVAtImpl(uint64_t offset, std::span<const std::span<uint8_t>> buffers)
+    {
+        if (!m_IsOpened) {
+            return 0;
+        }
+
+        std::shared_ptr<Blob> blob = m_Blob.lock();
+        if (!blob) {
+            return 0;
+        }
+
+        uint64_t total = 0;
+        for (const auto& buffer : buffers) {
+            const uint64_t position = offset + total;
+            if (position >= m_Size) {
+                break;
+            }
+
+            const auto size = static_cast<size_t>(std::min<uint64_t>(buffer.size(), m_Size - position));
+            const auto read = blob->ReadAt(m_Offset + position, buffer.first(size));
+            total += read;
+            if (read != buffer.size()) {
+                break;
+            }
+        }
+        return total;
+    }
+
+private:
+    FileInfo m_FileInfo;
+    std::weak_ptr<Blob> m_Blob;
+    uint64_t m_Offset;
+    uint64_t m_Size;
+    bool m_IsOpened = false;
+    uint64_t m_SeekPos = 0;
+    [[no_unique_address]] mutable typename Policy::Mutex m_Mutex;
+};
+
+} // namespace vfspp
+
+#endif // VFSPP_SLICEFILE_HPP
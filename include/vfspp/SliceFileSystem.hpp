@@ -0,0 +1,380 @@
+#ifndef VFSPP_SLICEFILESYSTEM_HPP
+#define VFSPP_SLICEFILESYSTEM_HPP
+
+#include "IFileSystem.h"
+#include "FileIndex.hpp"
+#include "Global.h"
+#include "ThreadingPolicy.hpp"
+#include "NativeBlob.hpp"
+#include "SliceFile.hpp"
+
+namespace vfspp
+{
+
+template<typename Policy>
+class BasicSliceFileSystem;
+
+using SliceFileSystem = BasicSliceFileSystem<ThreadingPolicy>;
+using SliceFileSystemPtr = std::shared_ptr<SliceFileSystem>;
+using SliceFileSystemWeakPtr = std::weak_ptr<SliceFileSystem>;
+
+
+/*
+ * File of slice filesystem, range of blob
+ */
+struct Slice
+{
+    std::string Path; // Path relative to alias
+    uint64_t Offset = 0;
+    uint64_t Size = 0;
+};
+
+
+/*
+ * Read-only filesystem of single large native file split to files by offset table.
+ * Blob is opened once and mapped to memory by default, so files are views of mapped
+ * memory without opening native files. Slices can overlap, slices out of blob are
+ * skipped. Calls are synchronized by Policy
+ */
+template<typename Policy>
+class BasicSliceFileSystem final : public IFileSystem
+{
+public:
+    /*
+     * Without memory mapping slices are read with positional reads
+     */
+    BasicSliceFileSystem(const std::string& aliasPath, const std::string& blobPath, std::vector<Slice> slices, bool memoryMap = true)
+        : m_AliasPath(aliasPath)
+        , m_BlobPath(blobPath)
+        , m_Slices(std::move(slices))
+        , m_IsMemoryMapped(memoryMap)
+    {
+    }
+
+    ~BasicSliceFileSystem()
+    {
+        Shutdown();
+    }
+
+    /*
+     * Initialize filesystem, call this method as soon as possible
+     */
+    [[nodiscard]]
+    virtual bool Initialize() override
+    {
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
+        return InitializeImpl();
+    }
+
+    /*
+     * Shutdown filesystem, blob is closed as soon as last file and buffer release it
+     */
+    virtual void Shutdown() override
+    {
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
+        ShutdownImpl();
+    }
+
+    /*
+     * Slice filesystem has no parallel work
+     */
+    virtual void SetExecutor(ExecutorPtr /*executor*/) override
+    {
+    }
+
+    /*
+     * Switch case sensitivity of file lookups, fails if paths of files differ only by case
+     */
+    virtual bool SetCaseSensitive(bool isCaseSensitive) override
+    {
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
+        return m_Files.SetCaseSensitive(isCaseSensitive);
+    }
+
+    /*
+     * Check if file lookups are case sensitive
+     */
+    [[nodiscard]]
+    virtual bool IsCaseSensitive() const override
+    {
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
+        return m_Files.IsCaseSensitive();
+    }
+
+    /*
+     * Check if filesystem is initialized
+     */
+    [[nodiscard]]
+    virtual bool IsInitialized() const override
+    {
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
+        return m_Blob != nullptr;
+    }
+
+    /*
+     * Get base path
+     */
+    [[nodiscard]]
+    virtual const std::string& BasePath() const override
+    {
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
+        return m_BasePath; // Empty for slice filesystem
+    }
+
+    /*
+     * Get mounted path
+     */
+    [[nodiscard]]
+    virtual const std::string& VirtualPath() const override
+    {
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
+        return m_AliasPath;
+    }
+
+    /*
+     * Retrieve all files of blob
+     */
+    [[nodiscard]]
+    virtual FilesList GetFilesList() const override
+    {
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
+
+        FilesList list;
+        list.reserve(m_Files.size());
+        for (const auto& [path, entry] : m_Files) {
+            list.push_back(entry.Info);
+        }
+        return list;
+    }
+
+    /*
+     * Call visitor for each file without copying file list, stops when visitor returns false
+     */
+    virtual void ForEachFile(const FileVisitor& visitor) const override
+    {
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
+        for (const auto& [path, entry] : m_Files) {
+            if (!visitor(entry.Info)) {
+                return;
+            }
+        }
+    }
+
+    /*
+     * List files and directories of directory, paths of directories end with '/'
+     */
+    [[nodiscard]]
+    virtual std::vector<std::string> ListDirectory(const std::string& virtualPath, bool recursive = false) const override
+    {
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
+        return m_Files.ListDirectory(virtualPath, recursive);
+    }
+
+    /*
+     * Find files matching pattern. Returns sorted virtual paths
+     */
+    [[nodiscard]]
+    virtual std::vector<std::string> FindFiles(const GlobPattern& pattern) const override
+    {
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
+        return m_Files.Find(pattern);
+    }
+
+    /*
+     * Slice filesystem is readonly
+     */
+    [[nodiscard]]
+    virtual bool IsReadOnly() const override
+    {
+        return true;
+    }
+
+    /*
+     * Open existing file for reading
+     */
+    virtual IFilePtr OpenFile(const std::string& virtualPath, IFile::FileMode mode) override
+    {
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
+        return OpenFileImpl(virtualPath, mode);
+    }
+
+    /*
+     * Close file
+     */
+    virtual bool CloseFile(IFilePtr file) override
+    {
+        return file && file->Close();
+    }
+
+    /*
+     * Not supported by readonly filesystem
+     */
+    virtual IFilePtr CreateFile(const std::string& /*virtualPath*/) override
+    {
+        return nullptr;
+    }
+
+    /*
+     * Not supported by readonly filesystem
+     */
+    virtual bool RemoveFile(const std::string& /*virtualPath*/) override
+    {
+        return false;
+    }
+
+    /*
+     * Not supported by readonly filesystem
+     */
+    virtual bool CopyFile(const std::string& /*srcVirtualPath*/, const std::string& /*dstVirtualPath*/, bool /*overwrite*/ = false) override
+    {
+        return false;
+    }
+
+    /*
+     * Not supported by readonly filesystem
+     */
+    virtual bool RenameFile(const std::string& /*srcVirtualPath*/, const std::string& /*dstVirtualPath*/) override
+    {
+        return false;
+    }
+
+    /*
+     * Check if file exists in blob
+     */
+    [[nodiscard]]
+    virtual bool IsFileExists(const std::string& virtualPath) const override
+    {
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
+        return m_Files.find(virtualPath) != m_Files.end();
+    }
+
+    /*
+     * Get file metadata, files have modification time of blob
+     */
+    [[nodiscard]]
+    virtual std::optional<FileStat> Stat(const std::string& virtualPath) const override
+    {
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
+
+        const auto it = m_Files.find(virtualPath);
+        if (it == m_Files.end()) {
+            return std::nullopt;
+        }
+
+        FileStat stat;
+        stat.Size = it->second.Size;
+        stat.ModifiedTime = m_Blob->ModifiedTime();
+        stat.CompressedSize = it->second.Size;
+        return stat;
+    }
+
+    /*
+     * Read whole file, files of mapped blob are referenced in-place
+     */
+    [[nodiscard]]
+    virtual std::optional<FileBuffer> ReadAll(const std::string& virtualPath) const override
+    {
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
+        return ReadAllImpl(virtualPath);
+    }
+
+private:
+    struct FileEntry
+    {
+        FileInfo Info;
+        uint64_t Offset;
+        uint64_t Size;
+    };
+
+    inline bool InitializeImpl()
+    {
+        if (m_Blob) {
+            return true;
+        }
+
+        auto blob = std::make_shared<NativeBlob>();
+        if (!blob->Open(m_BlobPath, m_IsMemoryMapped)) {
+            return false;
+        }
+
+        for (const Slice& slice : m_Slices) {
+            if (slice.Offset > blob->Size() || slice.Size > blob->Size() - slice.Offset) {
+                // TODO: log error
+                continue;
+            }
+
+            FileInfo info(m_AliasPath, m_BasePath, slice.Path);
+            const std::string virtualPath = info.VirtualPath();
+            m_Files.emplace(virtualPath, FileEntry{ std::move(info), slice.Offset, slice.Size });
+        }
+
+        m_Blob = std::move(blob);
+        return true;
+    }
+
+    inline void ShutdownImpl()
+    {
+        // Blob is closed as soon as reading file releases it
+        m_Blob = nullptr;
+        m_Files.clear();
+    }
+
+    inline IFilePtr OpenFileImpl(const std::string& virtualPath, IFile::FileMode mode) const
+    {
+        if (IFile::ModeHasFlag(mode, IFile::FileMode::Write)) {
+            return nullptr;
+        }
+
+        const auto it = m_Files.find(virtualPath);
+        if (it == m_Files.end()) {
+            return nullptr;
+        }
+        const FileEntry& entry = it->second;
+
+        IFilePtr file;
+        if (IFile::ModeHasFlag(mode, IFile::FileMode::ExclusiveOwner)) {
+            file = std::make_shared<ExclusiveSliceFile>(entry.Info, m_Blob, entry.Offset, entry.Size);
+        } else {
+            file = std::make_shared<BasicSliceFile<Policy>>(entry.Info, m_Blob, entry.Offset, entry.Size);
+        }
+
+        if (!file->Open(mode)) {
+            return nullptr;
+        }
+        return file;
+    }
+
+    inline std::optional<FileBuffer> ReadAllImpl(const std::string& virtualPath) const
+    {
+        const auto it = m_Files.find(virtualPath);
+        if (it == m_Files.end()) {
+            return std::nullopt;
+        }
+        const FileEntry& entry = it->second;
+
+        const auto memory = m_Blob->Memory();
+        if (!memory.empty()) {
+            return FileBuffer(m_Blob, memory.subspan(static_cast<size_t>(entry.Offset), static_cast<size_t>(entry.Size)));
+        }
+
+        auto data = std::make_shared<std::vector<uint8_t>>(static_cast<size_t>(entry.Size));
+        if (m_Blob->ReadAt(entry.Offset, *data) != entry.Size) {
+            return std::nullopt;
+        }
+        return FileBuffer(std::move(data));
+    }
+
+private:
+    std::string m_AliasPath;
+    std::string m_BasePath;
+    std::string m_BlobPath;
+    std::vector<Slice> m_Slices;
+    bool m_IsMemoryMapped;
+    NativeBlobPtr m_Blob;
+    FileIndex<FileEntry, Policy> m_Files;
+    [[no_unique_address]] mutable typename Policy::Mutex m_Mutex;
+};
+
+} // namespace vfspp
+
+#endif // VFSPP_SLICEFILESYSTEM_HPP
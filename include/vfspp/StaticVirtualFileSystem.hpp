@@ -0,0 +1,313 @@
+#ifndef VFSPP_STATICVIRTUALFILESYSTEM_HPP
+#define VFSPP_STATICVIRTUALFILESYSTEM_HPP
+
+#include "IFileSystem.h"
+#include "IFile.h"
+#include "Alias.hpp"
+#include "FileHandle.hpp"
+#include "PathNormalizer.hpp"
+#include "ThreadingPolicy.hpp"
+
+#include <algorithm>
+#include <tuple>
+#include <type_traits>
+#include <variant>
+
+namespace vfspp
+{
+
+/*
+ * Virtual filesystem with set of backend types known at compile time. Backends are kept
+ * as variant and called through their final type, so lookups are dispatched with
+ * std::visit instead of virtual calls and can be inlined by compiler
+ */
+template<typename Policy, typename... Backends>
+class BasicStaticVirtualFileSystem final
+{
+    static_assert(sizeof...(Backends) > 0, "At least one backend type is required");
+    static_assert((std::is_base_of_v<IFileSystem, Backends> && ...), "Backends must implement IFileSystem");
+
+public:
+    using BackendPtr = std::variant<std::shared_ptr<Backends>...>;
+
+public:
+    /*
+     * Executor is passed to filesystems created by CreateFileSystem for parallel
+     * initialization
+     */
+    explicit BasicStaticVirtualFileSystem(ExecutorPtr executor = nullptr)
+        : m_Executor(std::move(executor))
+    {
+    }
+
+    BasicStaticVirtualFileSystem(const BasicStaticVirtualFileSystem&) = delete;
+    BasicStaticVirtualFileSystem& operator=(const BasicStaticVirtualFileSystem&) = delete;
+
+    ~BasicStaticVirtualFileSystem()
+    {
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
+        for (const auto& mount : m_Mounts) {
+            std::visit([](const auto& fs) { fs->Shutdown(); }, mount.FileSystem);
+        }
+    }
+
+    /*
+     * Register filesystem with alias, filesystems added later override earlier ones
+     */
+    template<typename Backend>
+    void AddFileSystem(const Alias& alias, std::shared_ptr<Backend> filesystem)
+    {
+        if (!filesystem) {
+            return;
+        }
+
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
+
+        // Longer aliases are probed first, newest filesystem first within same alias
+        const auto it = std::find_if(m_Mounts.begin(), m_Mounts.end(), [&](const Mount& mount) {
+            return mount.MountAlias.Length() <= alias.Length();
+        });
+        m_Mounts.insert(it, Mount{ alias, BackendPtr(std::move(filesystem)) });
+    }
+
+    template<typename Backend, typename... Args>
+    [[nodiscard]] auto CreateFileSystem(const Alias& alias, Args&&... args) -> std::optional<std::shared_ptr<Backend>>
+    {
+        auto filesystem = std::make_shared<Backend>(alias.String(), std::forward<Args>(args)...);
+        filesystem->SetExecutor(m_Executor);
+        if (!filesystem->SetCaseSensitive(IsCaseSensitive()) || !filesystem->Initialize()) {
+            return {};
+        }
+
+        AddFileSystem(alias, filesystem);
+        return filesystem;
+    }
+
+    template<typename Backend, typename... Args>
+    [[nodiscard]] auto CreateFileSystem(std::string alias, Args&&... args) -> std::optional<std::shared_ptr<Backend>>
+    {
+        return CreateFileSystem<Backend>(Alias(std::move(alias)), std::forward<Args>(args)...);
+    }
+
+    /*
+     * Switch case sensitivity of lookups in mounted filesystems, filesystems created by
+     * CreateFileSystem later get the same mode. Returns false if some filesystem has paths
+     * differing only by case, it keeps previous mode
+     */
+    bool SetCaseSensitive(bool isCaseSensitive)
+    {
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
+
+        m_IsCaseSensitive = isCaseSensitive;
+        bool isAllSwitched = true;
+        for (const auto& mount : m_Mounts) {
+            std::visit([&](const auto& fs) { isAllSwitched = fs->SetCaseSensitive(isCaseSensitive) && isAllSwitched; }, mount.FileSystem);
+        }
+        return isAllSwitched;
+    }
+
+    [[nodiscard]]
+    bool IsCaseSensitive() const
+    {
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
+        return m_IsCaseSensitive;
+    }
+
+    /*
+     * Get executor passed to filesystems created by CreateFileSystem
+     */
+    [[nodiscard]]
+    const ExecutorPtr& GetExecutor() const
+    {
+        return m_Executor;
+    }
+
+    /*
+     * Remove registered filesystem
+     */
+    template<typename Backend>
+    void RemoveFileSystem(const Alias& alias, const std::shared_ptr<Backend>& filesystem)
+    {
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
+
+        m_Mounts.erase(std::remove_if(m_Mounts.begin(), m_Mounts.end(), [&](const Mount& mount) {
+            const auto* fs = std::get_if<std::shared_ptr<Backend>>(&mount.FileSystem);
+            return mount.MountAlias == alias && fs && *fs == filesystem;
+        }), m_Mounts.end());
+    }
+
+    /*
+     * Open file from first filesystem containing it, or open it on first writable
+     * filesystem when opened for writing. Lock is held only to find filesystem
+     */
+    IFilePtr OpenFile(const std::string& virtualPath, IFile::FileMode mode)
+    {
+        std::string normalizedPath;
+        const std::string& path = PathNormalizer::NormalizeIfNeeded(virtualPath, normalizedPath);
+
+        const bool requestWrite = IFile::ModeHasFlag(mode, IFile::FileMode::Write);
+        const auto filesystem = FindMount(path, [&](const auto& fs) {
+            return requestWrite ? !fs.IsReadOnly() : fs.IsFileExists(path);
+        });
+        if (!filesystem) {
+            return nullptr;
+        }
+        return std::visit([&](const auto& fs) { return fs->OpenFile(path, mode); }, *filesystem);
+    }
+
+    /*
+     * Open file owned by single caller, see OpenFile
+     */
+    [[nodiscard]]
+    FileHandle OpenFileHandle(const std::string& virtualPath, IFile::FileMode mode)
+    {
+        return FileHandle(OpenFile(virtualPath, mode));
+    }
+
+    /*
+     * Check if file exists in any registered filesystem
+     */
+    [[nodiscard]]
+    bool IsFileExists(const std::string& virtualPath) const
+    {
+        std::string normalizedPath;
+        const std::string& path = PathNormalizer::NormalizeIfNeeded(virtualPath, normalizedPath);
+
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
+
+        return VisitImpl(path, [&](const auto& fs) {
+            return fs.IsFileExists(path);
+        });
+    }
+
+    /*
+     * Get metadata of file from first filesystem containing it without opening file
+     */
+    [[nodiscard]]
+    std::optional<FileStat> Stat(const std::string& virtualPath) const
+    {
+        std::string normalizedPath;
+        const std::string& path = PathNormalizer::NormalizeIfNeeded(virtualPath, normalizedPath);
+
+        const auto filesystem = FindMount(path, [&](const auto& fs) {
+            return fs.IsFileExists(path);
+        });
+        if (!filesystem) {
+            return std::nullopt;
+        }
+
+        return std::visit([&](const auto& fs) {
+            std::optional<FileStat> result = fs->Stat(path);
+            if (result) {
+                result->FileSystem = fs;
+            }
+            return result;
+        }, *filesystem);
+    }
+
+    /*
+     * Read whole file from first filesystem containing it. Lock is held only to find
+     * filesystem, so long reads don't block other lookups
+     */
+    [[nodiscard]]
+    std::optional<FileBuffer> ReadAll(const std::string& virtualPath) const
+    {
+        std::string normalizedPath;
+        const std::string& path = PathNormalizer::NormalizeIfNeeded(virtualPath, normalizedPath);
+
+        const auto filesystem = FindMount(path, [&](const auto& fs) {
+            return fs.IsFileExists(path);
+        });
+        if (!filesystem) {
+            return std::nullopt;
+        }
+        return std::visit([&](const auto& fs) { return fs->ReadAll(path); }, *filesystem);
+    }
+
+    /*
+     * Call visitor with concrete type of each filesystem mounted at path, from the most
+     * recently added one. Stops on first result convertible to true and returns it
+     */
+    template<typename Visitor>
+    auto Visit(const std::string& virtualPath, Visitor&& visitor) const
+    {
+        std::string normalizedPath;
+        const std::string& path = PathNormalizer::NormalizeIfNeeded(virtualPath, normalizedPath);
+
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
+
+        return VisitImpl(path, visitor);
+    }
+
+private:
+    struct Mount
+    {
+        Alias MountAlias;
+        BackendPtr FileSystem;
+    };
+
+    // Copy of first filesystem matching predicate in lookup order, it stays alive after
+    // lock is released
+    template<typename Predicate>
+    std::optional<BackendPtr> FindMount(const std::string& virtualPath, Predicate&& predicate) const
+    {
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
+
+        std::optional<BackendPtr> result;
+        VisitMountsImpl(virtualPath, [&](const auto& fs) {
+            if (predicate(*fs)) {
+                result = BackendPtr(fs);
+            }
+            return result.has_value();
+        });
+        return result;
+    }
+
+    template<typename Visitor>
+    auto VisitImpl(const std::string& virtualPath, Visitor&& visitor) const
+    {
+        using Result = std::invoke_result_t<Visitor&, std::tuple_element_t<0, std::tuple<Backends&...>>>;
+
+        Result result{};
+        VisitMountsImpl(virtualPath, [&](const auto& fs) {
+            result = visitor(*fs);
+            return static_cast<bool>(result);
+        });
+        return result;
+    }
+
+    template<typename Visitor>
+    void VisitMountsImpl(const std::string& virtualPath, Visitor&& visitor) const
+    {
+        for (const auto& mount : m_Mounts) {
+            const std::string_view alias = mount.MountAlias.View();
+            const bool isMounted = m_IsCaseSensitive
+                ? virtualPath.starts_with(alias)
+                : virtualPath.size() >= alias.size() && PathNormalizer::EqualsFolded(std::string_view(virtualPath).substr(0, alias.size()), alias);
+            if (!isMounted) {
+                continue;
+            }
+
+            const bool isFound = std::visit([&](const auto& fs) {
+                return visitor(fs);
+            }, mount.FileSystem);
+
+            if (isFound) {
+                return;
+            }
+        }
+    }
+
+private:
+    std::vector<Mount> m_Mounts;
+    ExecutorPtr m_Executor;
+    bool m_IsCaseSensitive = true;
+    [[no_unique_address]] mutable typename Policy::Mutex m_Mutex;
+};
+
+template<typename... Backends>
+using StaticVirtualFileSystem = BasicStaticVirtualFileSystem<ThreadingPolicy, Backends...>;
+
+} // namespace vfspp
+
+#endif // VFSPP_STATICVIRTUALFILESYSTEM_HPP
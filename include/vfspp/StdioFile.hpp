@@ -0,0 +1,75 @@
+#ifndef VFSPP_STDIOFILE_HPP
+#define VFSPP_STDIOFILE_HPP
+
+#include "Global.h"
+
+#if defined(_WIN32)
+#include <io.h>
+#endif
+
+namespace vfspp
+{
+
+/*
+ * Stdio file operations with 64-bit offsets. Plain fseek and ftell take long offset,
+ * which is 32-bit on Windows, so files past 2 GiB need platform functions
+ */
+struct StdioFile
+{
+    /*
+     * Move file position, offset is relative to origin (SEEK_SET, SEEK_CUR or SEEK_END)
+     */
+    static bool Seek(std::FILE* file, int64_t offset, int origin)
+    {
+#if defined(_WIN32)
+        return _fseeki64(file, static_cast<__int64>(offset), origin) == 0;
+#elif defined(VFSPP_POSIX_IO_ENABLED)
+        return ::fseeko(file, static_cast<off_t>(offset), origin) == 0;
+#else
+        if (offset < std::numeric_limits<long>::min() || offset > std::numeric_limits<long>::max()) {
+            return false;
+        }
+        return std::fseek(file, static_cast<long>(offset), origin) == 0;
+#endif
+    }
+
+    /*
+     * Current file position, empty on error
+     */
+    static std::optional<uint64_t> Tell(std::FILE* file)
+    {
+#if defined(_WIN32)
+        const __int64 position = _ftelli64(file);
+#elif defined(VFSPP_POSIX_IO_ENABLED)
+        const off_t position = ::ftello(file);
+#else
+        const long position = std::ftell(file);
+#endif
+        if (position < 0) {
+            return std::nullopt;
+        }
+        return static_cast<uint64_t>(position);
+    }
+
+    /*
+     * Cut file to size, buffered writes are flushed first. Fails on platforms without
+     * truncation support
+     */
+    static bool Truncate(std::FILE* file, uint64_t size)
+    {
+        if (std::fflush(file) != 0) {
+            return false;
+        }
+#if defined(_WIN32)
+        return _chsize_s(_fileno(file), static_cast<__int64>(size)) == 0;
+#elif defined(VFSPP_POSIX_IO_ENABLED)
+        return ::ftruncate(::fileno(file), static_cast<off_t>(size)) == 0;
+#else
+        return false;
+#endif
+    }
+};
+
+} // namespace vfspp
+
+#endif // VFSPP_STDIOFILE_HPP
@@ -0,0 +1,660 @@
+#ifndef VFSPP_TARFILESYSTEM_HPP
+#define VFSPP_TARFILESYSTEM_HPP
+
+#include "IFileSystem.h"
+#include "FileIndex.hpp"
+#include "Global.h"
+#include "ThreadingPolicy.hpp"
+#include "NativeBlob.hpp"
+#include "ZstdBlob.hpp"
+#include "SliceFile.hpp"
+
+#include <charconv>
+
+namespace vfspp
+{
+
+template<typename Policy>
+class BasicTarFileSystem;
+
+using TarFileSystem = BasicTarFileSystem<ThreadingPolicy>;
+using TarFileSystemPtr = std::shared_ptr<TarFileSystem>;
+using TarFileSystemWeakPtr = std::weak_ptr<TarFileSystem>;
+
+
+/*
+ * Tar filesystem settings
+ */
+struct TarOptions
+{
+    // Map archive to memory, otherwise files are read with positional reads
+    bool MemoryMap = true;
+
+    // Memory used by decompressed frames of seekable zstd archive
+    uint64_t FrameCacheCapacity = 32 * 1024 * 1024;
+};
+
+
+/*
+ * Read-only filesystem of tar archive, ustar with pax and GNU long name extensions.
+ * Headers are indexed once on initialization, files are ranges of archive, see
+ * SliceFileSystem. Archive compressed with zstd is supported when VFSPP_ZSTD_SUPPORT_ENABLED
+ * is defined, archive in seekable zstd format is decompressed by frames on access, other
+ * zstd archive is decompressed to memory on initialization.
+ * Directories, symbolic links and special files are skipped, hard links share data of
+ * their target. Calls are synchronized by Policy
+ */
+template<typename Policy>
+class BasicTarFileSystem final : public IFileSystem
+{
+public:
+    static constexpr uint64_t kBlockSize = 512;
+
+public:
+    BasicTarFileSystem(const std::string& aliasPath, const std::string& tarPath, TarOptions options = {})
+        : m_AliasPath(aliasPath)
+        , m_TarPath(tarPath)
+        , m_Options(std::move(options))
+    {
+    }
+
+    ~BasicTarFileSystem()
+    {
+        Shutdown();
+    }
+
+    /*
+     * Initialize filesystem, call this method as soon as possible
+     */
+    [[nodiscard]]
+    virtual bool Initialize() override
+    {
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
+        return InitializeImpl();
+    }
+
+    /*
+     * Shutdown filesystem, archive is closed as soon as last file and buffer release it
+     */
+    virtual void Shutdown() override
+    {
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
+        ShutdownImpl();
+    }
+
+    /*
+     * Tar headers are chained, so they are indexed sequentially
+     */
+    virtual void SetExecutor(ExecutorPtr /*executor*/) override
+    {
+    }
+
+    /*
+     * Switch case sensitivity of file lookups, fails if paths of files differ only by case
+     */
+    virtual bool SetCaseSensitive(bool isCaseSensitive) override
+    {
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
+        return m_Files.SetCaseSensitive(isCaseSensitive);
+    }
+
+    /*
+     * Check if file lookups are case sensitive
+     */
+    [[nodiscard]]
+    virtual bool IsCaseSensitive() const override
+    {
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
+        return m_Files.IsCaseSensitive();
+    }
+
+    /*
+     * Check if filesystem is initialized
+     */
+    [[nodiscard]]
+    virtual bool IsInitialized() const override
+    {
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
+        return m_IsInitialized;
+    }
+
+    /*
+     * Get base path
+     */
+    [[nodiscard]]
+    virtual const std::string& BasePath() const override
+    {
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
+        return m_BasePath; // Empty for tar filesystem
+    }
+
+    /*
+     * Get mounted path
+     */
+    [[nodiscard]]
+    virtual const std::string& VirtualPath() const override
+    {
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
+        return m_AliasPath;
+    }
+
+    /*
+     * Retrieve all files of archive
+     */
+    [[nodiscard]]
+    virtual FilesList GetFilesList() const override
+    {
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
+
+        FilesList list;
+        list.reserve(m_Files.size());
+        for (const auto& [path, entry] : m_Files) {
+            list.push_back(entry.Info);
+        }
+        return list;
+    }
+
+    /*
+     * Call visitor for each file without copying file list, stops when visitor returns false
+     */
+    virtual void ForEachFile(const FileVisitor& visitor) const override
+    {
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
+        for (const auto& [path, entry] : m_Files) {
+            if (!visitor(entry.Info)) {
+                return;
+            }
+        }
+    }
+
+    /*
+     * List files and directories of directory, paths of directories end with '/'
+     */
+    [[nodiscard]]
+    virtual std::vector<std::string> ListDirectory(const std::string& virtualPath, bool recursive = false) const override
+    {
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
+        return m_Files.ListDirectory(virtualPath, recursive);
+    }
+
+    /*
+     * Find files matching pattern. Returns sorted virtual paths
+     */
+    [[nodiscard]]
+    virtual std::vector<std::string> FindFiles(const GlobPattern& pattern) const override
+    {
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
+        return m_Files.Find(pattern);
+    }
+
+    /*
+     * Tar filesystem is readonly
+     */
+    [[nodiscard]]
+    virtual bool IsReadOnly() const override
+    {
+        return true;
+    }
+
+    /*
+     * Open existing file for reading
+     */
+    virtual IFilePtr OpenFile(const std::string& virtualPath, IFile::FileMode mode) override
+    {
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
+        return OpenFileImpl(virtualPath, mode);
+    }
+
+    /*
+     * Close file
+     */
+    virtual bool CloseFile(IFilePtr file) override
+    {
+        return file && file->Close();
+    }
+
+    /*
+     * Not supported by readonly filesystem
+     */
+    virtual IFilePtr CreateFile(const std::string& /*virtualPath*/) override
+    {
+        return nullptr;
+    }
+
+    /*
+     * Not supported by readonly filesystem
+     */
+    virtual bool RemoveFile(const std::string& /*virtualPath*/) override
+    {
+        return false;
+    }
+
+    /*
+     * Not supported by readonly filesystem
+     */
+    virtual bool CopyFile(const std::string& /*srcVirtualPath*/, const std::string& /*dstVirtualPath*/, bool /*overwrite*/ = false) override
+    {
+        return false;
+    }
+
+    /*
+     * Not supported by readonly filesystem
+     */
+    virtual bool RenameFile(const std::string& /*srcVirtualPath*/, const std::string& /*dstVirtualPath*/) override
+    {
+        return false;
+    }
+
+    /*
+     * Check if file exists in archive
+     */
+    [[nodiscard]]
+    virtual bool IsFileExists(const std::string& virtualPath) const override
+    {
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
+        return m_Files.find(virtualPath) != m_Files.end();
+    }
+
+    /*
+     * Get file metadata, modification time is taken from tar header
+     */
+    [[nodiscard]]
+    virtual std::optional<FileStat> Stat(const std::string& virtualPath) const override
+    {
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
+
+        const auto it = m_Files.find(virtualPath);
+        if (it == m_Files.end()) {
+            return std::nullopt;
+        }
+
+        FileStat stat;
+        stat.Size = it->second.Size;
+        stat.ModifiedTime = it->second.ModifiedTime;
+        stat.CompressedSize = it->second.Size;
+        return stat;
+    }
+
+    /*
+     * Read whole file, files of mapped archive and files within one decompressed frame
+     * are referenced in-place
+     */
+    [[nodiscard]]
+    virtual std::optional<FileBuffer> ReadAll(const std::string& virtualPath) const override
+    {
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
+
+        const auto it = m_Files.find(virtualPath);
+        if (it == m_Files.end()) {
+            return std::nullopt;
+        }
+        const FileEntry& entry = it->second;
+
+#if defined(VFSPP_ZSTD_SUPPORT_ENABLED)
+        if (m_ZstdBlob) {
+            if (auto buffer = m_ZstdBlob->Reference(entry.Offset, entry.Size)) {
+                return buffer;
+            }
+            return ReadAllImpl(m_ZstdBlob, entry);
+        }
+#endif
+        return ReadAllImpl(m_Blob, entry);
+    }
+
+private:
+    struct FileEntry
+    {
+        FileInfo Info;
+        uint64_t Offset;
+        uint64_t Size;
+        std::time_t ModifiedTime;
+    };
+
+    // Values of pax extended header or GNU long name entry applied to next entry
+    struct PendingHeader
+    {
+        std::optional<std::string> Path;
+        std::optional<std::string> LinkPath;
+        std::optional<uint64_t> Size;
+        std::optional<std::time_t> ModifiedTime;
+    };
+
+    inline bool InitializeImpl()
+    {
+        if (m_IsInitialized) {
+            return true;
+        }
+
+        auto blob = std::make_shared<NativeBlob>();
+        if (!blob->Open(m_TarPath, m_Options.MemoryMap)) {
+            return false;
+        }
+
+        if (IsZstdCompressed(*blob)) {
+#if defined(VFSPP_ZSTD_SUPPORT_ENABLED)
+            auto zstdBlob = std::make_shared<BasicZstdBlob<Policy>>();
+            if (!zstdBlob->Open(std::move(blob), m_Options.FrameCacheCapacity) || !IndexImpl(*zstdBlob)) {
+                m_Files.clear();
+                return false;
+            }
+            m_ZstdBlob = std::move(zstdBlob);
+#else
+            // TODO: log error, zstd support is not enabled
+            return false;
+#endif
+        } else {
+            if (!IndexImpl(*blob)) {
+                m_Files.clear();
+                return false;
+            }
+            m_Blob = std::move(blob);
+        }
+
+        m_IsInitialized = true;
+        return true;
+    }
+
+    inline void ShutdownImpl()
+    {
+        // Archive is closed as soon as reading file releases it
+        m_Blob = nullptr;
+#if defined(VFSPP_ZSTD_SUPPORT_ENABLED)
+        m_ZstdBlob = nullptr;
+#endif
+        m_Files.clear();
+        m_IsInitialized = false;
+    }
+
+    inline IFilePtr OpenFileImpl(const std::string& virtualPath, IFile::FileMode mode) const
+    {
+        if (IFile::ModeHasFlag(mode, IFile::FileMode::Write)) {
+            return nullptr;
+        }
+
+        const auto it = m_Files.find(virtualPath);
+        if (it == m_Files.end()) {
+            return nullptr;
+        }
+
+#if defined(VFSPP_ZSTD_SUPPORT_ENABLED)
+        if (m_ZstdBlob) {
+            return OpenSliceImpl(m_ZstdBlob, it->second, mode);
+        }
+#endif
+        return OpenSliceImpl(m_Blob, it->second, mode);
+    }
+
+    template<typename Blob>
+    IFilePtr OpenSliceImpl(const std::shared_ptr<Blob>& blob, const FileEntry& entry, IFile::FileMode mode) const
+    {
+        IFilePtr file;
+        if (IFile::ModeHasFlag(mode, IFile::FileMode::ExclusiveOwner)) {
+            file = std::make_shared<BasicSliceFile<SingleThreadedPolicy, Blob>>(entry.Info, blob, entry.Offset, entry.Size);
+        } else {
+            file = std::make_shared<BasicSliceFile<Policy, Blob>>(entry.Info, blob, entry.Offset, entry.Size);
+        }
+
+        if (!file->Open(mode)) {
+            return nullptr;
+        }
+        return file;
+    }
+
+    template<typename Blob>
+    static std::optional<FileBuffer> ReadAllImpl(const std::shared_ptr<Blob>& blob, const FileEntry& entry)
+    {
+        const auto memory = blob->Memory();
+        if (!memory.empty()) {
+            return FileBuffer(blob, memory.subspan(static_cast<size_t>(entry.Offset), static_cast<size_t>(entry.Size)));
+        }
+
+        auto data = std::make_shared<std::vector<uint8_t>>(static_cast<size_t>(entry.Size));
+        if (blob->ReadAt(entry.Offset, *data) != entry.Size) {
+            return std::nullopt;
+        }
+        return FileBuffer(std::move(data));
+    }
+
+    // Zstd frame or skippable frame, seekable archive may start with either
+    static bool IsZstdCompressed(const NativeBlob& blob)
+    {
+        std::array<uint8_t, 4> magic{};
+        if (blob.ReadAt(0, magic) != magic.size()) {
+            return false;
+        }
+
+        const uint32_t value = static_cast<uint32_t>(magic[0]) | (static_cast<uint32_t>(magic[1]) << 8) |
+            (static_cast<uint32_t>(magic[2]) << 16) | (static_cast<uint32_t>(magic[3]) << 24);
+        return value == 0xFD2FB528 || (value & 0xFFFFFFF0) == 0x184D2A50;
+    }
+
+    // Walk header chain until end of archive marker, archive without marker ends at end of
+    // blob. Partial header at the end means archive is truncated
+    template<typename Blob>
+    bool IndexImpl(const Blob& blob)
+    {
+        const uint64_t blobSize = blob.Size();
+        std::array<uint8_t, kBlockSize> header;
+        PendingHeader pending;
+
+        uint64_t offset = 0;
+        while (offset + kBlockSize <= blobSize) {
+            if (blob.ReadAt(offset, header) != kBlockSize) {
+                return false;
+            }
+            if (std::ranges::all_of(header, [](uint8_t value) { return value == 0; })) {
+                return true;
+            }
+            if (!IsChecksumValid(header)) {
+                // TODO: log error
+                return false;
+            }
+
+            const char type = static_cast<char>(header[156]);
+            const uint64_t dataOffset = offset + kBlockSize;
+            const bool isExtension = type == 'x' || type == 'g' || type == 'L' || type == 'K';
+
+            uint64_t size = ParseNumber(header, 124, 12);
+            if (!isExtension && pending.Size) {
+                size = *pending.Size;
+            }
+            if (size > blobSize - dataOffset) {
+                return false;
+            }
+
+            if (isExtension) {
+                if (!ReadExtension(blob, type, dataOffset, size, pending)) {
+                    return false;
+                }
+            } else {
+                const std::string path = pending.Path ? *pending.Path : HeaderPath(header);
+                const std::time_t modifiedTime = pending.ModifiedTime ? *pending.ModifiedTime : static_cast<std::time_t>(ParseNumber(header, 136, 12));
+
+                if (type == '0' || type == '\0' || type == '7') {
+                    AddEntry(path, dataOffset, size, modifiedTime);
+                } else if (type == '1') {
+                    AddLink(path, pending.LinkPath ? *pending.LinkPath : std::string(Field(header, 157, 100)), modifiedTime);
+                }
+                pending = {};
+            }
+
+            offset = dataOffset + (size + kBlockSize - 1) / kBlockSize * kBlockSize;
+        }
+        return offset >= blobSize;
+    }
+
+    template<typename Blob>
+    static bool ReadExtension(const Blob& blob, char type, uint64_t offset, uint64_t size, PendingHeader& pending)
+    {
+        // Global pax header applies to all following entries, its values are rarely used
+        // for paths, so it's skipped
+        if (type == 'g') {
+            return true;
+        }
+
+        constexpr uint64_t kMaxExtensionSize = 1024 * 1024;
+        if (size > kMaxExtensionSize) {
+            return false;
+        }
+
+        std::string data(static_cast<size_t>(size), '\0');
+        if (blob.ReadAt(offset, std::span<uint8_t>(reinterpret_cast<uint8_t*>(data.data()), data.size())) != size) {
+            return false;
+        }
+
+        if (type == 'L' || type == 'K') {
+            data.resize(std::strlen(data.c_str()));
+            (type == 'L' ? pending.Path : pending.LinkPath) = std::move(data);
+            return true;
+        }
+
+        // Pax records are "<length> <key>=<value>\n", length counts whole record
+        std::string_view records = data;
+        while (!records.empty()) {
+            const size_t space = records.find(' ');
+            size_t length = 0;
+            const auto [end, ec] = std::from_chars(records.data(), records.data() + std::min(space, records.size()), length);
+            if (ec != std::errc() || space == std::string_view::npos || length <= space + 1 || length > records.size()) {
+                return false;
+            }
+
+            const std::string_view record = records.substr(space + 1, length - space - 2);
+            records.remove_prefix(length);
+
+            const size_t equals = record.find('=');
+            if (equals == std::string_view::npos) {
+                continue;
+            }
+            const std::string_view key = record.substr(0, equals);
+            const std::string_view value = record.substr(equals + 1);
+
+            if (key == "path") {
+                pending.Path = std::string(value);
+            } else if (key == "linkpath") {
+                pending.LinkPath = std::string(value);
+            } else if (key == "size") {
+                uint64_t number = 0;
+                if (std::from_chars(value.data(), value.data() + value.size(), number).ec == std::errc()) {
+                    pending.Size = number;
+                }
+            } else if (key == "mtime") {
+                // Fraction of second is dropped
+                int64_t number = 0;
+                if (std::from_chars(value.data(), value.data() + value.size(), number).ec == std::errc()) {
+                    pending.ModifiedTime = static_cast<std::time_t>(number);
+                }
+            }
+        }
+        return true;
+    }
+
+    // Later entry with same path replaces earlier one, as on extraction
+    void AddEntry(const std::string& path, uint64_t offset, uint64_t size, std::time_t modifiedTime)
+    {
+        if (path.empty() || path.back() == '/') {
+            return;
+        }
+
+        FileInfo info(m_AliasPath, m_BasePath, path);
+        const std::string virtualPath = info.VirtualPath();
+        FileEntry entry{ std::move(info), offset, size, modifiedTime };
+
+        auto [it, isInserted] = m_Files.try_emplace(virtualPath, entry);
+        if (!isInserted) {
+            it->second = std::move(entry);
+        }
+    }
+
+    void AddLink(const std::string& path, const std::string& linkPath, std::time_t modifiedTime)
+    {
+        const auto it = m_Files.find(FileInfo(m_AliasPath, m_BasePath, linkPath).VirtualPath());
+        if (it == m_Files.end()) {
+            // TODO: log error
+            return;
+        }
+
+        const FileEntry target = it->second;
+        AddEntry(path, target.Offset, target.Size, modifiedTime);
+    }
+
+    static std::string_view Field(const std::array<uint8_t, kBlockSize>& header, size_t offset, size_t size)
+    {
+        const auto field = std::string_view(reinterpret_cast<const char*>(header.data()) + offset, size);
+        return field.substr(0, field.find('\0'));
+    }
+
+    // POSIX ustar splits long names to prefix and name, GNU tar uses prefix field otherwise
+    static std::string HeaderPath(const std::array<uint8_t, kBlockSize>& header)
+    {
+        const std::string_view name = Field(header, 0, 100);
+        if (std::memcmp(header.data() + 257, "ustar\0", 6) != 0) {
+            return std::string(name);
+        }
+
+        const std::string_view prefix = Field(header, 345, 155);
+        if (prefix.empty()) {
+            return std::string(name);
+        }
+        return std::string(prefix) + "/" + std::string(name);
+    }
+
+    // Octal number terminated by space or null, or big-endian base-256 number if high bit
+    // of first byte is set, as GNU tar stores large sizes
+    static uint64_t ParseNumber(const std::array<uint8_t, kBlockSize>& header, size_t offset, size_t size)
+    {
+        const auto field = std::string_view(reinterpret_cast<const char*>(header.data()) + offset, size);
+        const auto first = static_cast<uint8_t>(field.front());
+        if (first & 0x80) {
+            if (first & 0x40) {
+                return 0; // Negative
+            }
+
+            uint64_t value = first & 0x3F;
+            for (const char c : field.substr(1)) {
+                value = (value << 8) | static_cast<uint8_t>(c);
+            }
+            return value;
+        }
+
+        const size_t begin = field.find_first_not_of(' ');
+        if (begin == std::string_view::npos) {
+            return 0;
+        }
+
+        uint64_t value = 0;
+        std::from_chars(field.data() + begin, field.data() + field.size(), value, 8);
+        return value;
+    }
+
+    // Checksum is sum of header bytes with checksum field as spaces, old archives sum signed bytes
+    static bool IsChecksumValid(const std::array<uint8_t, kBlockSize>& header)
+    {
+        const uint64_t expected = ParseNumber(header, 148, 8);
+
+        uint64_t unsignedSum = 0;
+        int64_t signedSum = 0;
+        for (size_t i = 0; i < kBlockSize; ++i) {
+            const uint8_t value = (i >= 148 && i < 156) ? ' ' : header[i];
+            unsignedSum += value;
+            signedSum += static_cast<int8_t>(value);
+        }
+        return expected == unsignedSum || static_cast<int64_t>(expected) == signedSum;
+    }
+
+private:
+    std::string m_AliasPath;
+    std::string m_BasePath;
+    std::string m_TarPath;
+    TarOptions m_Options;
+    bool m_IsInitialized = false;
+    NativeBlobPtr m_Blob;
+#if defined(VFSPP_ZSTD_SUPPORT_ENABLED)
+    std::shared_ptr<BasicZstdBlob<Policy>> m_ZstdBlob;
+#endif
+    FileIndex<FileEntry, Policy> m_Files;
+    [[no_unique_address]] mutable typename Policy::Mutex m_Mutex;
+};
+
+} // namespace vfspp
+
+#endif // VFSPP_TARFILESYSTEM_HPP
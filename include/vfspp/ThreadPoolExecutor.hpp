@@ -0,0 +1,166 @@
+#ifndef VFSPP_THREADPOOLEXECUTOR_HPP
+#define VFSPP_THREADPOOLEXECUTOR_HPP
+
+#include "Executor.hpp"
+
+#include <deque>
+#include <thread>
+
+namespace vfspp
+{
+
+using ThreadPoolExecutorPtr = std::shared_ptr<class ThreadPoolExecutor>;
+using ThreadPoolExecutorWeakPtr = std::weak_ptr<class ThreadPoolExecutor>;
+
+/*
+ * Work-stealing thread pool. Each worker has own task deque, tasks submitted by worker go
+ * to its deque and are taken newest first, idle workers steal oldest tasks of others.
+ * Tasks submitted from other threads are distributed round-robin
+ */
+class ThreadPoolExecutor final : public Executor
+{
+public:
+    /*
+     * Start pool, 0 threads uses all hardware threads
+     */
+    explicit ThreadPoolExecutor(size_t threadCount = 0)
+    {
+        if (threadCount == 0) {
+            threadCount = std::max(1u, std::thread::hardware_concurrency());
+        }
+
+        m_Queues.reserve(threadCount);
+        for (size_t i = 0; i < threadCount; ++i) {
+            m_Queues.push_back(std::make_unique<TaskQueue>());
+        }
+
+        m_Threads.reserve(threadCount);
+        for (size_t i = 0; i < threadCount; ++i) {
+            m_Threads.emplace_back([this, i]() { WorkerLoop(i); });
+        }
+    }
+
+    ThreadPoolExecutor(const ThreadPoolExecutor&) = delete;
+    ThreadPoolExecutor& operator=(const ThreadPoolExecutor&) = delete;
+
+    /*
+     * Run all submitted tasks and stop workers
+     */
+    ~ThreadPoolExecutor()
+    {
+        {
+            std::lock_guard lock(m_SleepMutex);
+            m_IsStopping = true;
+        }
+        m_WakeUp.notify_all();
+
+        for (auto& thread : m_Threads) {
+            thread.join();
+        }
+    }
+
+    virtual void Submit(Task task) override
+    {
+        const WorkerContext& worker = CurrentWorker();
+        const size_t index = (worker.Pool == this) ? worker.Index : m_NextQueue++ % m_Queues.size();
+
+        // Counted before push, so counter never drops below number of queued tasks
+        {
+            std::lock_guard lock(m_SleepMutex);
+            m_PendingCount++;
+        }
+
+        {
+            std::lock_guard lock(m_Queues[index]->Mutex);
+            m_Queues[index]->Tasks.push_back(std::move(task));
+        }
+        m_WakeUp.notify_one();
+    }
+
+    [[nodiscard]]
+    virtual size_t Concurrency() const override
+    {
+        return m_Threads.size();
+    }
+
+private:
+    struct TaskQueue
+    {
+        std::mutex Mutex;
+        std::deque<Task> Tasks;
+    };
+
+    struct WorkerContext
+    {
+        const ThreadPoolExecutor* Pool = nullptr;
+        size_t Index = 0;
+    };
+
+    static WorkerContext& CurrentWorker()
+    {
+        static thread_local WorkerContext context;
+        return context;
+    }
+
+    void WorkerLoop(size_t index)
+    {
+        CurrentWorker() = WorkerContext{ this, index };
+
+        Task task;
+        while (true) {
+            if (PopTask(index, task)) {
+                task();
+                task = nullptr;
+                continue;
+            }
+
+            std::unique_lock lock(m_SleepMutex);
+            m_WakeUp.wait(lock, [&] { return m_IsStopping || m_PendingCount > 0; });
+            if (m_IsStopping && m_PendingCount == 0) {
+                return;
+            }
+        }
+    }
+
+    bool PopTask(size_t index, Task& outTask)
+    {
+        // Own tasks newest first, data they use is likely in cache
+        {
+            TaskQueue& queue = *m_Queues[index];
+            std::lock_guard lock(queue.Mutex);
+            if (!queue.Tasks.empty()) {
+                outTask = std::move(queue.Tasks.back());
+                queue.Tasks.pop_back();
+                m_PendingCount--;
+                return true;
+            }
+        }
+
+        // Steal oldest task of other workers
+        for (size_t i = 1; i < m_Queues.size(); ++i) {
+            TaskQueue& queue = *m_Queues[(index + i) % m_Queues.size()];
+            std::lock_guard lock(queue.Mutex);
+            if (!queue.Tasks.empty()) {
+                outTask = std::move(queue.Tasks.front());
+                queue.Tasks.pop_front();
+                m_PendingCount--;
+                return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    std::vector<std::unique_ptr<TaskQueue>> m_Queues;
+    std::vector<std::thread> m_Threads;
+    std::atomic<size_t> m_NextQueue{ 0 };
+
+    std::mutex m_SleepMutex;
+    std::condition_variable m_WakeUp;
+    std::atomic<size_t> m_PendingCount{ 0 };
+    bool m_IsStopping = false;
+};
+
+} // namespace vfspp
+
+#endif // VFSPP_THREADPOOLEXECUTOR_HPP
@@ -2,6 +2,7 @@
 #define VFSPP_THREADINGPOLICY_HPP
 
 #include <mutex>
+#include <shared_mutex>
 
 #include "Global.h"
 
@@ -12,16 +13,31 @@ namespace vfspp
 * Use this policy for multi-threaded applications
 */
 struct MultiThreadedPolicy {
+    using Mutex = std::mutex;
     static std::lock_guard<std::mutex> Lock(std::mutex& m) noexcept { return std::lock_guard(m); }
+    static std::lock_guard<std::mutex> SharedLock(std::mutex& m) noexcept { return std::lock_guard(m); }
 };
 
 
 /*
-* Use this policy for single-threaded applications
+* Use this policy for multi-threaded applications with mostly read access,
+* lookups from several threads don't block each other
+*/
+struct SharedMutexPolicy {
+    using Mutex = std::shared_mutex;
+    static std::unique_lock<std::shared_mutex> Lock(std::shared_mutex& m) noexcept { return std::unique_lock(m); }
+    static std::shared_lock<std::shared_mutex> SharedLock(std::shared_mutex& m) noexcept { return std::shared_lock(m); }
+};
+
+
+/*
+* Use this policy for single-threaded applications, has no mutex storage and no locking
 */
 struct SingleThreadedPolicy {
+    struct Mutex {};
     struct DummyLock {};
-    static DummyLock Lock(std::mutex&) noexcept { return {}; }
+    static DummyLock Lock(Mutex&) noexcept { return {}; }
+    static DummyLock SharedLock(Mutex&) noexcept { return {}; }
 };
 
 // Select default `ThreadingPolicy` based on compile-time macro.
@@ -33,4 +49,4 @@ using ThreadingPolicy = SingleThreadedPolicy;
 
 } // namespace vfspp
 
-#endif // VFSPP_THREADINGPOLICY_HPP
\ No newline at end of file
+#endif // VFSPP_THREADINGPOLICY_HPP
@@ -2,8 +2,15 @@
 #define VFSPP_H
 
 #include "VirtualFileSystem.hpp"
+#include "StaticVirtualFileSystem.hpp"
 #include "NativeFileSystem.hpp"
 #include "MemoryFileSystem.hpp"
 #include "ZipFileSystem.hpp"
+#include "OverlayFileSystem.hpp"
+#include "CachingFileSystem.hpp"
+#include "ChunkStoreFileSystem.hpp"
+#include "SliceFileSystem.hpp"
+#include "TarFileSystem.hpp"
+#include "ThreadPoolExecutor.hpp"
 
 #endif // VFSPP_H
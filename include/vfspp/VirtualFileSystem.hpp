@@ -4,34 +4,65 @@
 #include "IFileSystem.h"
 #include "IFile.h"
 #include "Alias.hpp"
+#include "ContentIndex.hpp"
+#include "DirectoryTree.hpp"
+#include "FileHandle.hpp"
+#include "PathNormalizer.hpp"
 #include "ThreadingPolicy.hpp"
 
 #include <concepts>
 #include <type_traits>
 #include <algorithm>
+#include <future>
 
 
 namespace vfspp
 {
 
-using VirtualFileSystemPtr = std::shared_ptr<class VirtualFileSystem>;
-using VirtualFileSystemWeakPtr = std::weak_ptr<class VirtualFileSystem>;
+template<typename Policy>
+class BasicVirtualFileSystem;
+
+using VirtualFileSystem = BasicVirtualFileSystem<ThreadingPolicy>;
+using VirtualFileSystemPtr = std::shared_ptr<VirtualFileSystem>;
+using VirtualFileSystemWeakPtr = std::weak_ptr<VirtualFileSystem>;
     
 
-class VirtualFileSystem final
+/*
+ * Filesystems mounted under aliases, calls are synchronized by Policy
+ */
+template<typename Policy>
+class BasicVirtualFileSystem final
 {
 public:
     using FileSystemList = std::vector<IFileSystemPtr>;
     using FileSystemMap = std::unordered_map<Alias, FileSystemList, Alias::Hash>;
+
+    // Number of paths of overridable filesystem collected by unsorted ForEachFile before
+    // their visibility is probed
+    static constexpr size_t kVisibilityBatchSize = 1024;
+
+    /*
+     * Filesystem to be initialized and registered with alias by CreateFileSystems
+     */
+    struct MountRequest
+    {
+        Alias MountAlias;
+        IFileSystemPtr FileSystem;
+    };
     
 public:
-    VirtualFileSystem()
+    /*
+     * Executor is passed to filesystems created by CreateFileSystem for parallel
+     * initialization
+     */
+    explicit BasicVirtualFileSystem(ExecutorPtr executor = nullptr)
+        : m_Executor(std::move(executor))
     {
     }
 
-    ~VirtualFileSystem()
+    ~BasicVirtualFileSystem()
     {
-        [[maybe_unused]] auto lock = ThreadingPolicy::Lock(m_Mutex);
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
         for (const auto& fs : m_FileSystems) {
             for (const auto& f : fs.second) {
                 f->Shutdown();
@@ -51,15 +82,9 @@ public:
             return;
         }
 
-        [[maybe_unused]] auto lock = ThreadingPolicy::Lock(m_Mutex);
-
-        m_FileSystems[alias].push_back(filesystem);
-        if (std::find(m_SortedAlias.begin(), m_SortedAlias.end(), alias) == m_SortedAlias.end()) {
-            m_SortedAlias.push_back(alias);
-        }
-        std::sort(m_SortedAlias.begin(), m_SortedAlias.end(), [](const Alias& first, const Alias& second) {
-            return first.Length() > second.Length();
-        });
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
+        AddFileSystemImpl(alias, std::move(filesystem));
+        SortAliases();
     }
 
     void AddFileSystem(std::string alias, IFileSystemPtr filesystem)
@@ -75,7 +100,8 @@ public:
             return {};
         }
 
-        if (!filesystem->Initialize()) {
+        filesystem->SetExecutor(m_Executor);
+        if (!filesystem->SetCaseSensitive(IsCaseSensitive()) || !filesystem->Initialize()) {
             return {};
         }
 
@@ -88,13 +114,159 @@ public:
     {
         return CreateFileSystem<FileSystemType>(Alias(std::move(alias)), std::forward<Args>(args)...);
     }
+
+    /*
+     * Create filesystem of given type to be mounted by CreateFileSystems
+     */
+    template <typename FileSystemType, typename... Args>
+    [[nodiscard]] static MountRequest MakeMountRequest(std::string alias, Args&&... args)
+    {
+        Alias mountAlias(std::move(alias));
+        auto filesystem = std::make_shared<FileSystemType>(mountAlias.String(), std::forward<Args>(args)...);
+        return MountRequest{ std::move(mountAlias), std::move(filesystem) };
+    }
+
+    /*
+     * Initialize filesystems of batch in parallel on executor, then register them in batch
+     * order, so later filesystems override earlier ones same as with sequential
+     * CreateFileSystem calls. Filesystems failed to initialize are skipped, returns true
+     * when all filesystems are mounted
+     */
+    [[nodiscard]]
+    bool CreateFileSystems(const std::vector<MountRequest>& batch)
+    {
+        const bool isCaseSensitive = IsCaseSensitive();
+        std::vector<uint8_t> isInitialized(batch.size(), 0);
+        ParallelFor(m_Executor.get(), batch.size(), [&](size_t i) {
+            const IFileSystemPtr& filesystem = batch[i].FileSystem;
+            if (filesystem) {
+                filesystem->SetExecutor(m_Executor);
+                isInitialized[i] = filesystem->SetCaseSensitive(isCaseSensitive) && filesystem->Initialize() ? 1 : 0;
+            }
+        });
+
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
+
+        bool isAllMounted = true;
+        for (size_t i = 0; i < batch.size(); ++i) {
+            if (isInitialized[i]) {
+                AddFileSystemImpl(batch[i].MountAlias, batch[i].FileSystem);
+            } else {
+                isAllMounted = false;
+            }
+        }
+        SortAliases();
+        return isAllMounted;
+    }
+
+    /*
+     * Run CreateFileSystems on executor, runs on calling thread without executor.
+     * Exception thrown by filesystem initialization is passed to returned future.
+     * Virtual filesystem must outlive returned future
+     */
+    [[nodiscard]]
+    std::future<bool> MountAsync(std::vector<MountRequest> batch)
+    {
+        auto promise = std::make_shared<std::promise<bool>>();
+        std::future<bool> result = promise->get_future();
+
+        auto task = [this, promise, batch = std::move(batch)]() mutable {
+            bool isAllMounted = false;
+            std::exception_ptr error;
+            try {
+                isAllMounted = CreateFileSystems(batch);
+            } catch (...) {
+                error = std::current_exception();
+            }
+
+            // Filesystems hold executor, release them before caller is woken up,
+            // so executor is never destroyed by its own worker
+            batch.clear();
+            if (error) {
+                promise->set_exception(error);
+            } else {
+                promise->set_value(isAllMounted);
+            }
+        };
+
+        if (m_Executor) {
+            m_Executor->Submit(std::move(task));
+        } else {
+            task();
+        }
+        return result;
+    }
+
+    /*
+     * Switch case sensitivity of lookups in mounted filesystems, filesystems created by
+     * CreateFileSystem later get the same mode. Filesystems added with AddFileSystem
+     * keep their own mode. Returns false if some filesystem has paths differing only by
+     * case, it keeps previous mode
+     */
+    bool SetCaseSensitive(bool isCaseSensitive)
+    {
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
+
+        m_IsCaseSensitive = isCaseSensitive;
+        bool isAllSwitched = true;
+        for (const auto& [alias, filesystems] : m_FileSystems) {
+            for (const IFileSystemPtr& fs : filesystems) {
+                isAllSwitched = fs->SetCaseSensitive(isCaseSensitive) && isAllSwitched;
+            }
+        }
+        return isAllSwitched;
+    }
+
+    [[nodiscard]]
+    bool IsCaseSensitive() const
+    {
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
+        return m_IsCaseSensitive;
+    }
+
+    /*
+     * Set content index used by Stat, null disables content hashes
+     */
+    void SetContentIndex(ContentIndexPtr index)
+    {
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
+        m_ContentIndex = std::move(index);
+    }
+
+    [[nodiscard]]
+    ContentIndexPtr GetContentIndex() const
+    {
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
+        return m_ContentIndex;
+    }
+
+    /*
+     * Hash content of all files and set result as content index. Only files added or
+     * changed since previous update are read
+     */
+    ContentIndexPtr UpdateContentIndex()
+    {
+        ContentIndexPtr previous = GetContentIndex();
+        ContentIndexPtr index = ContentIndex::Build(*this, previous.get());
+        SetContentIndex(index);
+        return index;
+    }
+
+    /*
+     * Get executor passed to filesystems created by CreateFileSystem
+     */
+    [[nodiscard]]
+    const ExecutorPtr& GetExecutor() const
+    {
+        return m_Executor;
+    }
     
     /*
      * Remove registered filesystem
      */
     void RemoveFileSystem(const Alias& alias, IFileSystemPtr filesystem)
     {
-        [[maybe_unused]] auto lock = ThreadingPolicy::Lock(m_Mutex);
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
 
         auto it = m_FileSystems.find(alias);
         if (it != m_FileSystems.end()) {
@@ -118,7 +290,7 @@ public:
     [[nodiscard]]
     bool HasFileSystem(const Alias& alias, IFileSystemPtr fileSystem) const
     {
-        [[maybe_unused]] auto lock = ThreadingPolicy::Lock(m_Mutex);
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
         auto it = m_FileSystems.find(alias);
         if (it != m_FileSystems.end()) {
             return std::find(it->second.begin(), it->second.end(), fileSystem) != it->second.end();
@@ -137,7 +309,7 @@ public:
      */
     void UnregisterAlias(const Alias& alias)
     {
-        [[maybe_unused]] auto lock = ThreadingPolicy::Lock(m_Mutex);
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
         m_FileSystems.erase(alias);
         m_SortedAlias.erase(std::remove(m_SortedAlias.begin(), m_SortedAlias.end(), alias), m_SortedAlias.end());
     }
@@ -153,7 +325,7 @@ public:
     [[nodiscard]]
     bool IsAliasRegistered(const Alias& alias) const
     {
-        [[maybe_unused]] auto lock = ThreadingPolicy::Lock(m_Mutex);
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
         return m_FileSystems.find(alias) != m_FileSystems.end();
     }
 
@@ -169,7 +341,7 @@ public:
     [[nodiscard]]
     std::optional<std::reference_wrapper<const FileSystemList>> GetFilesystems(const Alias& alias)
     {
-        [[maybe_unused]] auto lock = ThreadingPolicy::Lock(m_Mutex);
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
         
         return GetFilesystemsImpl(alias);
     }
@@ -181,13 +353,38 @@ public:
     }
 
 private:
+    void AddFileSystemImpl(const Alias& alias, IFileSystemPtr filesystem)
+    {
+        m_FileSystems[alias].push_back(std::move(filesystem));
+        if (std::find(m_SortedAlias.begin(), m_SortedAlias.end(), alias) == m_SortedAlias.end()) {
+            m_SortedAlias.push_back(alias);
+        }
+    }
+
+    bool IsMountedAtImpl(std::string_view virtualPath, const Alias& alias) const
+    {
+        return StartsWithImpl(virtualPath, alias.View());
+    }
+
+    bool StartsWithImpl(std::string_view path, std::string_view prefix) const
+    {
+        return m_IsCaseSensitive ? path.starts_with(prefix) : PathNormalizer::StartsWithFolded(path, prefix);
+    }
+
+    void SortAliases()
+    {
+        std::sort(m_SortedAlias.begin(), m_SortedAlias.end(), [](const Alias& first, const Alias& second) {
+            return first.Length() > second.Length();
+        });
+    }
+
     template<typename Callback>
     auto VisitMountedFileSystems(const std::string& virtualPath, Callback&& callback) const
     {
-        using CallbackResult = decltype(callback(std::declval<IFileSystemPtr>(), std::declval<bool>()));
+        using CallbackResult = decltype(callback(std::declval<const IFileSystemPtr&>(), std::declval<bool>()));
 
         for (const Alias& alias : m_SortedAlias) {
-            if (!virtualPath.starts_with(alias.String())) {
+            if (!IsMountedAtImpl(virtualPath, alias)) {
                 continue;
             }
 
@@ -196,10 +393,11 @@ private:
                 continue;
             }
 
+            // Filesystems are borrowed from the list, no reference counting per probe
             const auto& filesystems = fsResult->get();
             for (auto it = filesystems.rbegin(); it != filesystems.rend(); ++it) {
-                IFileSystemPtr fs = *it;
-                bool isMain = (fs == filesystems.front());
+                const IFileSystemPtr& fs = *it;
+                const bool isMain = (it + 1 == filesystems.rend());
 
                 CallbackResult result = callback(fs, isMain);
                 if (result) {
@@ -211,30 +409,49 @@ private:
         return CallbackResult{};
     }
 
+    // Find first filesystem matching predicate in lookup order under shared lock. Returned
+    // pointer keeps filesystem alive, so caller uses it after lock is released
+    template<typename Predicate>
+    IFileSystemPtr FindFileSystem(const std::string& virtualPath, Predicate&& predicate, ContentIndexPtr* outContentIndex = nullptr) const
+    {
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
+
+        if (outContentIndex) {
+            *outContentIndex = m_ContentIndex;
+        }
+
+        return VisitMountedFileSystems(virtualPath, [&](const IFileSystemPtr& fs, bool /*isMain*/) -> IFileSystemPtr {
+            return predicate(*fs) ? fs : nullptr;
+        });
+    }
+
 public:
     
     /*
      * Iterate over all registered filesystems and find first ocurrences of file.
      * Iteration occurs from the most recently added filesystem to the oldest one.
+     * Lock is held only to find filesystem, file is opened without it
      */
     IFilePtr OpenFile(const std::string& virtualPath, IFile::FileMode mode)
     {
-        [[maybe_unused]] auto lock = ThreadingPolicy::Lock(m_Mutex);
+        std::string normalizedPath;
+        const std::string& path = PathNormalizer::NormalizeIfNeeded(virtualPath, normalizedPath);
 
-        auto result = VisitMountedFileSystems(virtualPath, [&](IFileSystemPtr fs, bool /*isMain*/) -> std::optional<IFilePtr> {
-            if (fs->IsFileExists(virtualPath)) {
-                if (IFilePtr file = fs->OpenFile(virtualPath, mode)) {
-                    return file;
-                }
-            } else if (!fs->IsReadOnly() && IFile::ModeHasFlag(mode, IFile::FileMode::Write)) {
-                if (IFilePtr file = fs->OpenFile(virtualPath, mode)) {
-                    return file;
-                }
-            }
-            return std::nullopt;
+        // File opened for writing is opened or created on first writable filesystem
+        const bool requestWrite = IFile::ModeHasFlag(mode, IFile::FileMode::Write);
+        const IFileSystemPtr fs = FindFileSystem(path, [&](const IFileSystem& candidate) {
+            return requestWrite ? !candidate.IsReadOnly() : candidate.IsFileExists(path);
         });
+        return fs ? fs->OpenFile(path, mode) : nullptr;
+    }
 
-        return result.value_or(nullptr);
+    /*
+     * Open file owned by single caller, see OpenFile
+     */
+    [[nodiscard]]
+    FileHandle OpenFileHandle(const std::string& virtualPath, IFile::FileMode mode)
+    {
+        return FileHandle(OpenFile(virtualPath, mode));
     }
 
     /*
@@ -242,10 +459,13 @@ public:
      */
     bool IsFileExists(const std::string& virtualPath) const
     {
-        [[maybe_unused]] auto lock = ThreadingPolicy::Lock(m_Mutex);
+        std::string normalizedPath;
+        const std::string& path = PathNormalizer::NormalizeIfNeeded(virtualPath, normalizedPath);
 
-        auto result = VisitMountedFileSystems(virtualPath, [&](IFileSystemPtr fs, bool /*isMain*/) -> std::optional<bool> {
-            if (fs->IsFileExists(virtualPath)) {
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
+
+        auto result = VisitMountedFileSystems(path, [&](const IFileSystemPtr& fs, bool /*isMain*/) -> std::optional<bool> {
+            if (fs->IsFileExists(path)) {
                 return true;
             }
             return std::nullopt;
@@ -254,44 +474,279 @@ public:
         return result.value_or(false);
     }
 
+    /*
+     * Get metadata of file from first filesystem containing it without opening file.
+     * Content hash is set if content index has entry matching file
+     */
+    std::optional<FileStat> Stat(const std::string& virtualPath) const
+    {
+        std::string normalizedPath;
+        const std::string& path = PathNormalizer::NormalizeIfNeeded(virtualPath, normalizedPath);
+
+        ContentIndexPtr contentIndex;
+        const IFileSystemPtr fs = FindFileSystem(path, [&](const IFileSystem& candidate) {
+            return candidate.IsFileExists(path);
+        }, &contentIndex);
+        if (!fs) {
+            return std::nullopt;
+        }
+
+        auto stat = fs->Stat(path);
+        if (stat) {
+            stat->FileSystem = fs;
+            if (contentIndex) {
+                stat->ContentHash = contentIndex->FindHash(path, *stat);
+            }
+        }
+        return stat;
+    }
+
+    /*
+     * Read whole file from first filesystem containing it. Buffer is allocated once with
+     * exact size or references filesystem data without copying. Lock is held only to find
+     * filesystem, so long reads don't block other lookups
+     */
+    std::optional<FileBuffer> ReadAll(const std::string& virtualPath) const
+    {
+        std::string normalizedPath;
+        const std::string& path = PathNormalizer::NormalizeIfNeeded(virtualPath, normalizedPath);
+
+        const IFileSystemPtr fs = FindFileSystem(path, [&](const IFileSystem& candidate) {
+            return candidate.IsFileExists(path);
+        });
+        return fs ? fs->ReadAll(path) : std::nullopt;
+    }
+
     /*
      * List all files from all registered filesystems
-     * Returns a vector of all file paths with their aliases
+     * Returns a sorted vector of all file paths with their aliases
      * Files from later registered filesystems override earlier ones
      */
     std::vector<std::string> ListAllFiles() const
     {
-        [[maybe_unused]] auto lock = ThreadingPolicy::Lock(m_Mutex);
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
         
         std::vector<std::string> allFiles;
-        std::unordered_set<std::string> seenFiles;
+        auto collect = [&](std::string_view virtualPath) {
+            allFiles.emplace_back(virtualPath);
+        };
+        ForEachFileSortedImpl(Alias::Root().String(), collect);
+        return allFiles;
+    }
+
+    /*
+     * Call visitor with virtual path of each file, files overridden by later registered
+     * filesystems are skipped. Unsorted enumeration streams files of filesystems nothing is
+     * mounted over and probes files of overridable filesystem in batches of
+     * kVisibilityBatchSize, enumeration of such filesystem is restarted for each batch.
+     * Sorted enumeration walks directory trees and keeps listing of current directories only.
+     * Enumeration stops if visitor returns false, visitor must not call virtual filesystem
+     */
+    template<typename Visitor>
+    void ForEachFile(Visitor&& visitor, bool sorted = false) const
+    {
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
+
+        if (sorted) {
+            ForEachFileSortedImpl(Alias::Root().String(), visitor);
+        } else {
+            ForEachFileImpl(visitor);
+        }
+    }
+
+    /*
+     * List files and directories of directory merged from all filesystems mounted to it,
+     * its parents or its subdirectories. Returns sorted virtual paths without duplicates,
+     * paths of directories end with '/'. Case insensitive mode ignores case of paths
+     */
+    std::vector<std::string> ListDirectory(const std::string& virtualPath, bool recursive = false) const
+    {
+        std::string normalizedPath;
+        const std::string& path = PathNormalizer::NormalizeIfNeeded(virtualPath, normalizedPath);
+
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
+
+        return ListDirectoryImpl(path, recursive);
+    }
+
+    /*
+     * Find files matching glob pattern in all registered filesystems. '*' and '?' match
+     * within path component, "**" component matches any number of directories.
+     * Only directories matching pattern are visited. Returns sorted virtual paths without duplicates.
+     * Case insensitive mode ignores case of pattern and paths. Pattern is normalized like
+     * virtual paths, so '\\' separators and '.' or '..' components are accepted
+     */
+    std::vector<std::string> Find(const std::string& pattern) const
+    {
+        std::string normalizedPattern;
+        const std::string& path = PathNormalizer::NormalizeIfNeeded(pattern, normalizedPattern);
+        if (path.empty()) {
+            return {};
+        }
+
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
+
+        const GlobPattern glob(path);
+        const std::string& directory = glob.Directory();
+        std::set<std::string, PathLess> files(PathLess{ !m_IsCaseSensitive });
 
         for (const Alias& alias : m_SortedAlias) {
+            if (!IsMountedAtImpl(directory, alias) && !StartsWithImpl(alias.View(), directory)) {
+                continue;
+            }
+
             auto fsResult = GetFilesystemsImpl(alias);
             if (!fsResult) {
                 continue;
             }
 
-            const auto& filesystems = fsResult->get();
-            for (auto it = filesystems.rbegin(); it != filesystems.rend(); ++it) {
+            for (const IFileSystemPtr& fs : fsResult->get()) {
+                for (auto& path : fs->FindFiles(glob)) {
+                    files.emplace(std::move(path));
+                }
+            }
+        }
+
+        return std::vector<std::string>(std::make_move_iterator(files.begin()), std::make_move_iterator(files.end()));
+    }
+
+private:
+    std::vector<std::string> ListDirectoryImpl(const std::string& virtualPath, bool recursive) const
+    {
+        const std::string directory = DirectoryTree::DirectoryPath(virtualPath);
+        std::set<std::string, PathLess> entries(PathLess{ !m_IsCaseSensitive });
+
+        for (const Alias& alias : m_SortedAlias) {
+            const bool isParentMount = IsMountedAtImpl(directory, alias);
+            const bool isChildMount = !isParentMount && StartsWithImpl(alias.View(), directory);
+            if (!isParentMount && !isChildMount) {
+                continue;
+            }
+
+            // Mount point is visible even if filesystem is empty
+            if (isChildMount) {
+                AddMountPointImpl(directory, alias.View(), recursive, entries);
+            }
+
+            auto fsResult = GetFilesystemsImpl(alias);
+            if (!fsResult) {
+                continue;
+            }
+
+            for (const IFileSystemPtr& fs : fsResult->get()) {
+                for (auto& path : fs->ListDirectory(directory, recursive)) {
+                    entries.emplace(std::move(path));
+                }
+            }
+        }
 
-                IFileSystemPtr fs = *it;
-                const IFileSystem::FilesList& fileList = fs->GetFilesList();
+        return std::vector<std::string>(std::make_move_iterator(entries.begin()), std::make_move_iterator(entries.end()));
+    }
+    template<typename Visitor>
+    static bool InvokeVisitor(Visitor& visitor, std::string_view virtualPath)
+    {
+        if constexpr (std::is_same_v<std::invoke_result_t<Visitor&, std::string_view>, bool>) {
+            return visitor(virtualPath);
+        } else {
+            visitor(virtualPath);
+            return true;
+        }
+    }
+
+    template<typename Visitor>
+    void ForEachFileImpl(Visitor& visitor) const
+    {
+        std::vector<std::string> candidates;
+        for (const Alias& alias : m_SortedAlias) {
+            auto fsResult = GetFilesystemsImpl(alias);
+            if (!fsResult) {
+                continue;
+            }
+
+            const auto& filesystems = fsResult->get();
+            for (size_t i = 0; i < filesystems.size(); ++i) {
+                const IFileSystemPtr& fs = filesystems[i];
+
+                // All files of filesystem nothing is mounted over are visible
+                if (i + 1 == filesystems.size() && !IsOverlappedImpl(alias)) {
+                    bool isStopped = false;
+                    fs->ForEachFile([&](const FileInfo& fileInfo) {
+                        isStopped = !InvokeVisitor(visitor, fileInfo.VirtualPath());
+                        return !isStopped;
+                    });
+
+                    if (isStopped) {
+                        return;
+                    }
+                    continue;
+                }
 
-                for (const auto& fileInfo : fileList) {
-                    const auto& virtualPath = fileInfo.VirtualPath();
-                    if (seenFiles.emplace(virtualPath).second) {
-                        allFiles.push_back(std::move(virtualPath));
+                // Other filesystems are probed when enumeration is stopped, so locks of
+                // filesystems are never nested. Enumeration stops after each batch and
+                // resumes by skipping files already probed, so memory use is bounded
+                size_t probedCount = 0;
+                bool isLastBatch = false;
+                while (!isLastBatch) {
+                    size_t skippedCount = 0;
+                    candidates.clear();
+                    fs->ForEachFile([&](const FileInfo& fileInfo) {
+                        if (skippedCount < probedCount) {
+                            ++skippedCount;
+                            return true;
+                        }
+                        candidates.push_back(fileInfo.VirtualPath());
+                        return candidates.size() < kVisibilityBatchSize;
+                    });
+                    isLastBatch = candidates.size() < kVisibilityBatchSize;
+                    probedCount += candidates.size();
+
+                    for (const std::string& virtualPath : candidates) {
+                        if (IsVisibleImpl(virtualPath, fs) && !InvokeVisitor(visitor, virtualPath)) {
+                            return;
+                        }
                     }
                 }
             }
-        }   
+        }
+    }
 
-        std::sort(allFiles.begin(), allFiles.end());
-        return allFiles;
+    template<typename Visitor>
+    bool ForEachFileSortedImpl(const std::string& directory, Visitor& visitor) const
+    {
+        for (const std::string& virtualPath : ListDirectoryImpl(directory, false)) {
+            const bool isDirectory = virtualPath.back() == '/';
+            const bool isContinued = isDirectory ? ForEachFileSortedImpl(virtualPath, visitor) : InvokeVisitor(visitor, virtualPath);
+            if (!isContinued) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Check if longer alias is mounted inside alias, its filesystems are looked up first
+    bool IsOverlappedImpl(const Alias& alias) const
+    {
+        return std::any_of(m_SortedAlias.begin(), m_SortedAlias.end(), [&](const Alias& other) {
+            return other.Length() > alias.Length() && IsMountedAtImpl(other.View(), alias);
+        });
+    }
+
+    // File is visible if owner is first filesystem containing it in lookup order
+    bool IsVisibleImpl(const std::string& virtualPath, const IFileSystemPtr& owner) const
+    {
+        auto result = VisitMountedFileSystems(virtualPath, [&](const IFileSystemPtr& fs, bool /*isMain*/) -> std::optional<bool> {
+            if (fs == owner) {
+                return true;
+            }
+            if (fs->IsFileExists(virtualPath)) {
+                return false;
+            }
+            return std::nullopt;
+        });
+
+        return result.value_or(false);
     }
 
-private:
     [[nodiscard]]
     std::optional<std::reference_wrapper<const FileSystemList>> GetFilesystemsImpl(const Alias& alias) const
     {
@@ -302,11 +757,27 @@ private:
         
         return {};
     }
+
+    // Add directories between listed directory and alias, e.g. "/a/" and "/a/b/c/" adds "/a/b/"
+    static void AddMountPointImpl(std::string_view directory, std::string_view alias, bool recursive, std::set<std::string, PathLess>& outEntries)
+    {
+        size_t separator = alias.find('/', directory.size());
+        while (separator != std::string_view::npos) {
+            outEntries.emplace(alias.substr(0, separator + 1));
+            if (!recursive) {
+                break;
+            }
+            separator = alias.find('/', separator + 1);
+        }
+    }
     
 private:
     FileSystemMap m_FileSystems;
     std::vector<Alias> m_SortedAlias;
-    mutable std::mutex m_Mutex;
+    ExecutorPtr m_Executor;
+    ContentIndexPtr m_ContentIndex;
+    bool m_IsCaseSensitive = true;
+    [[no_unique_address]] mutable typename Policy::Mutex m_Mutex;
 };
 
     
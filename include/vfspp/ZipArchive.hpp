@@ -0,0 +1,274 @@
+#ifndef VFSPP_ZIPARCHIVE_HPP
+#define VFSPP_ZIPARCHIVE_HPP
+
+#include "IFile.h"
+#include "Global.h"
+#include "zip_file.hpp"
+
+namespace vfspp
+{
+
+using ZipArchivePtr = std::shared_ptr<class ZipArchive>;
+using ZipArchiveWeakPtr = std::weak_ptr<class ZipArchive>;
+
+
+/*
+ * Opened zip archive reader. Archive can be backed by native file, contiguous
+ * memory block or any IFile accessed with positional reads
+ */
+class ZipArchive final
+{
+public:
+    ZipArchive() = default;
+
+    ~ZipArchive()
+    {
+        Close();
+    }
+
+    ZipArchive(const ZipArchive&) = delete;
+    ZipArchive& operator=(const ZipArchive&) = delete;
+
+    /*
+     * Open archive from native file
+     */
+    [[nodiscard]]
+    bool OpenFile(const std::string& path)
+    {
+        Close();
+
+#if defined(VFSPP_POSIX_IO_ENABLED)
+        // Positional reads allow concurrent extraction of different entries
+        m_Descriptor = ::open(path.c_str(), O_RDONLY);
+        if (m_Descriptor < 0) {
+            return false;
+        }
+
+        struct stat st;
+        if (::fstat(m_Descriptor, &st) != 0) {
+            Close();
+            return false;
+        }
+
+        m_Archive.m_pRead = &ZipArchive::DescriptorReadCallback;
+        m_Archive.m_pIO_opaque = this;
+
+        if (!mz_zip_reader_init(&m_Archive, static_cast<mz_uint64>(st.st_size), 0)) {
+            Close();
+            return false;
+        }
+#else
+        if (!mz_zip_reader_init_file(&m_Archive, path.c_str(), 0)) {
+            return false;
+        }
+
+        // Stdio reads seek shared FILE, so reads of concurrent extractions are serialized
+        m_FileRead = m_Archive.m_pRead;
+        m_FileReadOpaque = m_Archive.m_pIO_opaque;
+        m_Archive.m_pRead = &ZipArchive::SerializedReadCallback;
+        m_Archive.m_pIO_opaque = this;
+#endif
+
+        m_IsOpened = true;
+        return true;
+    }
+
+    /*
+     * Open archive from memory block. Owner keeps memory alive while archive is opened
+     */
+    [[nodiscard]]
+    bool OpenMemory(std::span<const uint8_t> data, std::shared_ptr<const void> owner)
+    {
+        Close();
+
+        if (!mz_zip_reader_init_mem(&m_Archive, data.data(), data.size_bytes(), 0)) {
+            return false;
+        }
+
+        m_Memory = data;
+        m_MemoryOwner = std::move(owner);
+        m_IsOpened = true;
+        return true;
+    }
+
+    /*
+     * Open archive from file with positional reads, file must be opened for reading
+     */
+    [[nodiscard]]
+    bool OpenStream(IFilePtr file)
+    {
+        Close();
+
+        if (!file || !file->IsOpened()) {
+            return false;
+        }
+
+        m_Stream = std::move(file);
+        m_Archive.m_pRead = &ZipArchive::StreamReadCallback;
+        m_Archive.m_pIO_opaque = this;
+
+        if (!mz_zip_reader_init(&m_Archive, m_Stream->Size(), 0)) {
+            m_Stream = nullptr;
+            m_Archive = {};
+            return false;
+        }
+
+        m_IsOpened = true;
+        return true;
+    }
+
+    /*
+     * Close archive and release underlying storage
+     */
+    void Close()
+    {
+        if (m_IsOpened) {
+            mz_zip_reader_end(&m_Archive);
+        }
+
+        m_Archive = {};
+        m_Memory = {};
+        m_MemoryOwner = nullptr;
+        m_Stream = nullptr;
+        m_IsOpened = false;
+
+#if defined(VFSPP_POSIX_IO_ENABLED)
+        if (m_Descriptor >= 0) {
+            ::close(m_Descriptor);
+            m_Descriptor = -1;
+        }
+#endif
+    }
+
+    [[nodiscard]]
+    bool IsOpened() const
+    {
+        return m_IsOpened;
+    }
+
+    /*
+     * Get miniz archive object
+     */
+    [[nodiscard]]
+    mz_zip_archive* Get()
+    {
+        return &m_Archive;
+    }
+
+    /*
+     * Get whole archive memory if archive is memory backed, otherwise empty span
+     */
+    [[nodiscard]]
+    std::span<const uint8_t> Memory() const
+    {
+        return m_Memory;
+    }
+
+    /*
+     * Read raw archive bytes from absolute offset
+     */
+    uint64_t ReadRaw(uint64_t offset, std::span<uint8_t> buffer)
+    {
+        if (!m_IsOpened || buffer.empty()) {
+            return 0;
+        }
+
+        if (!m_Memory.empty()) {
+            if (offset >= m_Memory.size_bytes()) {
+                return 0;
+            }
+            const auto bytesToRead = std::min(static_cast<uint64_t>(m_Memory.size_bytes()) - offset, static_cast<uint64_t>(buffer.size_bytes()));
+            std::memcpy(buffer.data(), m_Memory.data() + offset, static_cast<size_t>(bytesToRead));
+            return bytesToRead;
+        }
+
+        return m_Archive.m_pRead(m_Archive.m_pIO_opaque, offset, buffer.data(), buffer.size_bytes());
+    }
+
+    /*
+     * Get offset of entry data by parsing its local header
+     */
+    [[nodiscard]]
+    std::optional<uint64_t> EntryDataOffset(uint64_t localHeaderOffset)
+    {
+        constexpr uint32_t kLocalHeaderSignature = 0x04034b50;
+        constexpr size_t kLocalHeaderSize = 30;
+
+        std::array<uint8_t, kLocalHeaderSize> header{};
+        if (ReadRaw(localHeaderOffset, header) != kLocalHeaderSize) {
+            return std::nullopt;
+        }
+
+        if (ReadLE32(header.data()) != kLocalHeaderSignature) {
+            return std::nullopt;
+        }
+
+        const uint64_t filenameLength = ReadLE16(header.data() + 26);
+        const uint64_t extraLength = ReadLE16(header.data() + 28);
+        return localHeaderOffset + kLocalHeaderSize + filenameLength + extraLength;
+    }
+
+private:
+    static size_t StreamReadCallback(void* opaque, mz_uint64 fileOffset, void* buffer, size_t size)
+    {
+        auto* self = static_cast<ZipArchive*>(opaque);
+        return static_cast<size_t>(self->m_Stream->ReadAt(fileOffset, std::span<uint8_t>(static_cast<uint8_t*>(buffer), size)));
+    }
+
+#if !defined(VFSPP_POSIX_IO_ENABLED)
+    static size_t SerializedReadCallback(void* opaque, mz_uint64 fileOffset, void* buffer, size_t size)
+    {
+        auto* self = static_cast<ZipArchive*>(opaque);
+        std::lock_guard lock(self->m_ReadMutex);
+        return self->m_FileRead(self->m_FileReadOpaque, fileOffset, buffer, size);
+    }
+#endif
+
+#if defined(VFSPP_POSIX_IO_ENABLED)
+    static size_t DescriptorReadCallback(void* opaque, mz_uint64 fileOffset, void* buffer, size_t size)
+    {
+        auto* self = static_cast<ZipArchive*>(opaque);
+        size_t total = 0;
+        while (total < size) {
+            const ssize_t read = ::pread(self->m_Descriptor, static_cast<uint8_t*>(buffer) + total, size - total, static_cast<off_t>(fileOffset + total));
+            if (read < 0 && errno == EINTR) {
+                continue;
+            }
+            if (read <= 0) {
+                break;
+            }
+            total += static_cast<size_t>(read);
+        }
+        return total;
+    }
+#endif
+
+    static uint16_t ReadLE16(const uint8_t* p)
+    {
+        return static_cast<uint16_t>(p[0] | (p[1] << 8));
+    }
+
+    static uint32_t ReadLE32(const uint8_t* p)
+    {
+        return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) | (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+    }
+
+private:
+    mz_zip_archive m_Archive{};
+    bool m_IsOpened = false;
+
+    std::span<const uint8_t> m_Memory;
+    std::shared_ptr<const void> m_MemoryOwner;
+    IFilePtr m_Stream;
+#if defined(VFSPP_POSIX_IO_ENABLED)
+    int m_Descriptor = -1;
+#else
+    mz_file_read_func m_FileRead = nullptr;
+    void* m_FileReadOpaque = nullptr;
+    std::mutex m_ReadMutex;
+#endif
+};
+
+} // namespace vfspp
+
+#endif // VFSPP_ZIPARCHIVE_HPP
@@ -0,0 +1,133 @@
+#ifndef VFSPP_ZIPBUILDER_HPP
+#define VFSPP_ZIPBUILDER_HPP
+
+#include "BuildPipeline.hpp"
+#include "ZipWriter.hpp"
+
+namespace vfspp
+{
+
+/*
+ * Zip archive build settings, files are compressed on executor of pipeline
+ */
+struct ZipBuildOptions : BuildPipelineOptions
+{
+    // Compression level used for files without extension policy, 0 stores files
+    int CompressionLevel = MZ_DEFAULT_LEVEL;
+
+    // Compression level per lowercase extension with leading dot, 0 stores files
+    std::unordered_map<std::string, int> ExtensionLevels = {
+        { ".png", 0 }, { ".jpg", 0 }, { ".jpeg", 0 }, { ".webp", 0 }, { ".ktx2", 0 },
+        { ".ogg", 0 }, { ".mp3", 0 }, { ".opus", 0 }, { ".mp4", 0 }, { ".webm", 0 },
+        { ".zip", 0 }, { ".gz", 0 }, { ".zst", 0 }, { ".xz", 0 }, { ".7z", 0 }
+    };
+
+    // Data of stored entries starts at offset multiple of alignment, 0 disables alignment.
+    // Alignment can't exceed ZipWriter::kMaxAlignment
+    uint32_t StoredAlignment = 0;
+
+    // Modification time written to all entries, fixed time keeps output reproducible
+    std::time_t ModifiedTime = 0;
+};
+
+
+/*
+ * Build zip archive from files mounted to virtual filesystem. Files go through
+ * BuildPipeline, so output is identical regardless of thread count. Exception thrown
+ * during compression is rethrown by Build
+ */
+class ZipBuilder final
+{
+public:
+    explicit ZipBuilder(ZipBuildOptions options = {})
+        : m_Options(std::move(options))
+    {
+    }
+
+    ZipBuilder(const ZipBuilder&) = delete;
+    ZipBuilder& operator=(const ZipBuilder&) = delete;
+
+    /*
+     * Pack all files under virtual root into archive, entry names are relative to root
+     */
+    template<typename Policy>
+    [[nodiscard]]
+    bool Build(BasicVirtualFileSystem<Policy>& vfs, const std::string& virtualRoot, const std::string& zipPath)
+    {
+        if (m_Options.StoredAlignment > ZipWriter::kMaxAlignment) {
+            return false;
+        }
+
+        const Alias root(virtualRoot);
+        const std::vector<std::string> files = BuildPipeline::ListFiles(vfs, root);
+
+        ZipWriter writer;
+        if (!writer.Open(zipPath, false)) {
+            return false;
+        }
+
+        std::vector<ZipEntryRecord> entries;
+        entries.reserve(files.size());
+
+        const bool isBuilt = BuildPipeline::Run<Job>(vfs, root, files, m_Options, [this](Job& job) {
+            CompressJob(job);
+        }, [&](const Job& job) {
+            return WriteJob(writer, job, entries);
+        });
+
+        return isBuilt && writer.WriteCentralDirectory(entries) && writer.Close();
+    }
+
+private:
+    struct Job
+    {
+        BuildFile File;
+        std::vector<uint8_t> Compressed;
+        uint32_t Crc32 = 0;
+        uint16_t Method = ZipWriter::kMethodStored;
+    };
+
+    // Data of compressed file is released, it's not needed anymore
+    void CompressJob(Job& job) const
+    {
+        const auto data = job.File.Data.Data();
+        job.Crc32 = ZipWriter::Crc32(data);
+
+        if (ZipWriter::Deflate(data, CompressionLevel(job.File.Name), job.Compressed)) {
+            job.Method = ZipWriter::kMethodDeflated;
+            job.File.Data = FileBuffer();
+        }
+    }
+
+    bool WriteJob(ZipWriter& writer, const Job& job, std::vector<ZipEntryRecord>& outEntries) const
+    {
+        const bool isStored = job.Method == ZipWriter::kMethodStored;
+        const auto data = isStored ? job.File.Data.Data() : std::span<const uint8_t>(job.Compressed);
+        const uint32_t alignment = isStored ? m_Options.StoredAlignment : 0;
+
+        auto record = writer.AddEntry(job.File.Name, data, job.Method, job.Crc32, job.File.Stat.Size, m_Options.ModifiedTime, alignment);
+        if (!record) {
+            return false;
+        }
+        outEntries.push_back(std::move(*record));
+        return true;
+    }
+
+    int CompressionLevel(const std::string& name) const
+    {
+        std::string extension = fs::path(name).extension().string();
+        std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) {
+            return static_cast<char>(std::tolower(c));
+        });
+
+        const auto it = m_Options.ExtensionLevels.find(extension);
+        return it != m_Options.ExtensionLevels.end() ? it->second : m_Options.CompressionLevel;
+    }
+
+private:
+    ZipBuildOptions m_Options;
+};
+
+} // namespace vfspp
+
+#endif // VFSPP_ZIPBUILDER_HPP
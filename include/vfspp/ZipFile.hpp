@@ -3,29 +3,53 @@
 
 #include "IFile.h"
 #include "ThreadingPolicy.hpp"
-#include "zip_file.hpp"
+#include "ZipArchive.hpp"
+#include "ZipJournal.hpp"
+#include "Crc32.hpp"
 
 #include <span>
 
 namespace vfspp
 {
 
-using ZipFilePtr = std::shared_ptr<class ZipFile>;
-using ZipFileWeakPtr = std::weak_ptr<class ZipFile>;
+template<typename Policy, typename JournalPolicy = Policy>
+class BasicZipFile;
 
+using ZipFile = BasicZipFile<ThreadingPolicy>;
+using ZipFilePtr = std::shared_ptr<ZipFile>;
+using ZipFileWeakPtr = std::weak_ptr<ZipFile>;
 
-class ZipFile final : public IFile
+// Handle owned by single thread, calls are not synchronized. Its commits go to journal
+// shared with filesystem, so journal is synchronized by filesystem policy
+using ExclusiveZipFile = BasicZipFile<SingleThreadedPolicy, ThreadingPolicy>;
+
+
+/*
+ * File of zip archive, calls are synchronized by Policy and commits to journal shared with
+ * filesystem by JournalPolicy
+ */
+template<typename Policy, typename JournalPolicy>
+class BasicZipFile final : public IFile
 {
 public:
-    ZipFile(const FileInfo& fileInfo, uint32_t entryID, uint64_t size, std::shared_ptr<mz_zip_archive> zipArchive)
+    // Entry ID of file which is not committed to archive yet
+    static constexpr uint32_t kNewEntryID = std::numeric_limits<uint32_t>::max();
+
+public:
+    /*
+     * Create file for archive entry. Journal is required to open file for writing,
+     * written data is committed to archive when file is closed
+     */
+    BasicZipFile(const FileInfo& fileInfo, uint32_t entryID, uint64_t size, ZipArchivePtr zipArchive, std::weak_ptr<BasicZipJournal<JournalPolicy>> journal = {})
         : m_FileInfo(fileInfo)
         , m_EntryID(entryID)
         , m_Size(size)
         , m_ZipArchive(zipArchive)
+        , m_Journal(journal)
     {
     }   
 
-    ~ZipFile()
+    ~BasicZipFile()
     {
         Close();
     }
@@ -36,7 +60,7 @@ public:
     [[nodiscard]]
     virtual const FileInfo& GetFileInfo() const override
     {
-        [[maybe_unused]] auto lock = ThreadingPolicy::Lock(m_Mutex);
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
         return GetFileInfoImpl();
     }
     
@@ -46,7 +70,7 @@ public:
     [[nodiscard]]
     virtual uint64_t Size() const override
     {
-        [[maybe_unused]] auto lock = ThreadingPolicy::Lock(m_Mutex);
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
         return SizeImpl();
     }
     
@@ -56,7 +80,7 @@ public:
     [[nodiscard]]
     virtual bool IsReadOnly() const override
     {
-        [[maybe_unused]] auto lock = ThreadingPolicy::Lock(m_Mutex);
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
         return IsReadOnlyImpl();
     }
     
@@ -66,17 +90,17 @@ public:
     [[nodiscard]]
     virtual bool Open(FileMode mode) override
     {
-        [[maybe_unused]] auto lock = ThreadingPolicy::Lock(m_Mutex);
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
         return OpenImpl(mode);
     }
     
     /*
-     * Close file
+     * Close file, written data is appended to archive. Returns false if append failed
      */
-    virtual void Close() override
+    virtual bool Close() override
     {
-        [[maybe_unused]] auto lock = ThreadingPolicy::Lock(m_Mutex);
-        CloseImpl();
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
+        return CloseImpl();
     }
     
     /*
@@ -85,16 +109,26 @@ public:
     [[nodiscard]]
     virtual bool IsOpened() const override
     {
-        [[maybe_unused]] auto lock = ThreadingPolicy::Lock(m_Mutex);
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
         return IsOpenedImpl();
     }
+
+    /*
+     * Check if read data didn't match CRC-32 of entry in VerifyChecksum mode
+     */
+    [[nodiscard]]
+    virtual bool IsCorrupted() const override
+    {
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
+        return m_IsChecksumMismatch;
+    }
     
     /*
      * Seek on a file
      */
     virtual uint64_t Seek(uint64_t offset, Origin origin) override
     {
-        [[maybe_unused]] auto lock = ThreadingPolicy::Lock(m_Mutex);
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
         return SeekImpl(offset, origin);
     }
     /*
@@ -103,7 +137,7 @@ public:
     [[nodiscard]]
     virtual uint64_t Tell() const override
     {
-        [[maybe_unused]] auto lock = ThreadingPolicy::Lock(m_Mutex);
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
         return TellImpl();
     }
     
@@ -112,7 +146,7 @@ public:
      */
     virtual uint64_t Read(std::span<uint8_t> buffer) override
     {
-        [[maybe_unused]] auto lock = ThreadingPolicy::Lock(m_Mutex);
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
         return ReadImpl(buffer);
     }
 
@@ -121,16 +155,34 @@ public:
      */
     virtual uint64_t Read(std::vector<uint8_t>& buffer, uint64_t size) override
     {
-        [[maybe_unused]] auto lock = ThreadingPolicy::Lock(m_Mutex);
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
         return ReadImpl(buffer, size);
     }
 
+    /*
+     * Read data from absolute offset to buffer, doesn't move file cursor
+     */
+    virtual uint64_t ReadAt(uint64_t offset, std::span<uint8_t> buffer) override
+    {
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
+        return ReadAtImpl(offset, buffer);
+    }
+
+    /*
+     * Read consecutive data from file to several buffers filled in order, moves file cursor
+     */
+    virtual uint64_t ReadV(std::span<const std::span<uint8_t>> buffers) override
+    {
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
+        return ReadVImpl(buffers);
+    }
+
     /*
      * Write buffer data to file
      */
     virtual uint64_t Write(std::span<const uint8_t> buffer) override
     {
-        [[maybe_unused]] auto lock = ThreadingPolicy::Lock(m_Mutex);
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
         return WriteImpl(buffer);
     }
     
@@ -139,9 +191,19 @@ public:
      */
     virtual uint64_t Write(const std::vector<uint8_t>& buffer) override
     {
-        [[maybe_unused]] auto lock = ThreadingPolicy::Lock(m_Mutex);
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
         return WriteImpl(buffer);
     }
+
+    /*
+     * Get entry data if it's stored uncompressed in memory backed archive
+     */
+    [[nodiscard]]
+    virtual std::optional<FileBuffer> MappedData() override
+    {
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
+        return MappedDataImpl();
+    }
     
 private:
     inline const FileInfo& GetFileInfoImpl() const
@@ -151,12 +213,15 @@ private:
     
     inline uint64_t SizeImpl() const
     {
+        if (m_IsWriting) {
+            return m_WriteBuffer.size();
+        }
         return m_Size;
     }
     
     inline bool IsReadOnlyImpl() const
     {
-        return true;
+        return !IFile::ModeHasFlag(m_Mode, FileMode::Write);
     }
     
     inline bool OpenImpl(FileMode mode)
@@ -165,28 +230,88 @@ private:
             return false;
         }
 
-        if (IsReadOnlyImpl() && IFile::ModeHasFlag(mode, FileMode::Write)) {
+        const bool requestWrite = IFile::ModeHasFlag(mode, FileMode::Write);
+        if (requestWrite && m_Journal.expired()) {
             return false;
         }
 
-        if (IsOpenedImpl()) {
+        if (IsOpenedImpl() && m_Mode == mode) {
             SeekImpl(0, IFile::Origin::Begin);
+            ResetVerificationImpl();
             return true;
         }
 
-        m_SeekPos = 0;
-
-        std::shared_ptr<mz_zip_archive> zipArchive = m_ZipArchive.lock();
+        ZipArchivePtr zipArchive = m_ZipArchive.lock();
         if (!zipArchive) {
             return false;
         }
+
+        if (!CommitImpl()) {
+            return false;
+        }
+        m_SeekPos = 0;
+        m_Mode = mode;
+        ResetVerificationImpl();
+
+        if (requestWrite) {
+            return OpenForWriting(mode);
+        }
                 
         return true;
     }
+
+    inline bool OpenForWriting(FileMode mode)
+    {
+        // Writes are staged in memory and appended to archive on close
+        m_WriteBuffer.clear();
+        if (!IFile::ModeHasFlag(mode, FileMode::Truncate) && m_EntryID != kNewEntryID && m_Size > 0) {
+            m_WriteBuffer.resize(static_cast<size_t>(m_Size));
+            if (ReadAtImpl(0, m_WriteBuffer) != m_Size) {
+                m_WriteBuffer.clear();
+                return false;
+            }
+        }
+
+        m_IsWriting = true;
+        m_IsDirty = IFile::ModeHasFlag(mode, FileMode::Truncate) || m_EntryID == kNewEntryID;
+
+        if (IFile::ModeHasFlag(mode, FileMode::Append)) {
+            m_SeekPos = m_WriteBuffer.size();
+        }
+        return true;
+    }
     
-    inline void CloseImpl()
+    inline bool CloseImpl()
     {
+        if (!CommitImpl()) {
+            return false;
+        }
         m_SeekPos = 0;
+        return true;
+    }
+
+    // Failed commit keeps written data and writing state, so it can be retried
+    inline bool CommitImpl()
+    {
+        if (!m_IsWriting) {
+            return true;
+        }
+
+        if (m_IsDirty) {
+            auto journal = m_Journal.lock();
+            if (!journal || !journal->Write(m_FileInfo.FilePath(), m_WriteBuffer)) {
+                return false;
+            }
+        }
+
+        // Committed data lives in new archive, file has to be reopened from filesystem
+        m_WriteBuffer.clear();
+        m_WriteBuffer.shrink_to_fit();
+        m_IsWriting = false;
+        m_IsDirty = false;
+        m_Mode = FileMode::Read;
+        m_ZipArchive.reset();
+        return true;
     }
     
     inline bool IsOpenedImpl() const
@@ -220,10 +345,12 @@ private:
     }
     
     struct PartialExtractContext {
-        size_t Offset;              // Bytes to skip
-        size_t SizeToRead;          // Number of bytes we want to read
-        size_t TotalRead;           // How many bytes written so far
-        unsigned char* OutBuffer;   // Pointer to output buffer
+        size_t Offset;                              // Bytes to skip
+        size_t SizeToRead;                          // Number of bytes we want to read
+        size_t TotalRead;                           // How many bytes written so far
+        std::span<const std::span<uint8_t>> Buffers; // Output buffers filled in order
+        size_t BufferIndex;                         // Buffer being filled
+        size_t BufferOffset;                        // Bytes written to current buffer
     };
 
     // Callback used by miniz during extraction
@@ -245,73 +372,286 @@ private:
 
         size_t available = size - startInBlock;
 
-        // Stop if we've already read enough
+        // Stop extraction if we've already read enough
         if (ctx->TotalRead >= ctx->SizeToRead) {
-            return size;
+            return 0;
         }
 
         // How much we can copy this time
         size_t remaining = ctx->SizeToRead - ctx->TotalRead;
         size_t numToCopy = (available < remaining) ? available : remaining;
 
-        // Copy data into buffer
-        std::memcpy(ctx->OutBuffer + ctx->TotalRead, static_cast<const unsigned char*>(buffer) + startInBlock, numToCopy);
-
-        ctx->TotalRead += numToCopy;
+        // Scatter data over output buffers
+        const auto* source = static_cast<const unsigned char*>(buffer) + startInBlock;
+        while (numToCopy > 0 && ctx->BufferIndex < ctx->Buffers.size()) {
+            const auto& out = ctx->Buffers[ctx->BufferIndex];
+            const size_t toCopy = std::min(numToCopy, out.size() - ctx->BufferOffset);
+            if (toCopy > 0) {
+                std::memcpy(out.data() + ctx->BufferOffset, source, toCopy);
+            }
+
+            source += toCopy;
+            numToCopy -= toCopy;
+            ctx->TotalRead += toCopy;
+            ctx->BufferOffset += toCopy;
+            if (ctx->BufferOffset == out.size()) {
+                ctx->BufferIndex++;
+                ctx->BufferOffset = 0;
+            }
+        }
         return size;
     }
 
     inline uint64_t ReadImpl(std::span<uint8_t> buffer)
+    {
+        return ReadVImpl(std::span<const std::span<uint8_t>>(&buffer, 1));
+    }
+
+    inline uint64_t ReadVImpl(std::span<const std::span<uint8_t>> buffers)
+    {
+        const auto read = ReadVAtImpl(m_SeekPos, buffers);
+        if (IsVerifyingImpl() && !VerifyReadImpl(m_SeekPos, buffers, read)) {
+            return 0;
+        }
+        m_SeekPos += read;
+        return read;
+    }
+
+    inline bool IsVerifyingImpl() const
+    {
+        return IFile::ModeHasFlag(m_Mode, FileMode::VerifyChecksum) && !m_IsWriting;
+    }
+
+    inline void ResetVerificationImpl()
+    {
+        m_Crc32 = 0;
+        m_VerifiedSize = 0;
+        m_IsChecksumMismatch = false;
+    }
+
+    // Checksum is computed over data as it's read, read that completes data is failed
+    // on mismatch. Data skipped by seeking forward is read to keep checksum continuous
+    inline bool VerifyReadImpl(uint64_t offset, std::span<const std::span<uint8_t>> buffers, uint64_t read)
+    {
+        if (m_IsChecksumMismatch) {
+            return false;
+        }
+
+        if (offset > m_VerifiedSize && !VerifySkippedImpl(offset)) {
+            return false;
+        }
+
+        // Only part of read following verified data is added
+        uint64_t skip = m_VerifiedSize - std::min(m_VerifiedSize, offset);
+        uint64_t left = read;
+        for (const auto& buffer : buffers) {
+            const uint64_t size = std::min(left, static_cast<uint64_t>(buffer.size()));
+            left -= size;
+            if (skip >= size) {
+                skip -= size;
+                continue;
+            }
+
+            const auto data = std::span<const uint8_t>(buffer.data() + skip, static_cast<size_t>(size - skip));
+            m_Crc32 = Crc32::Update(m_Crc32, data);
+            m_VerifiedSize += data.size();
+            skip = 0;
+        }
+
+        return CheckVerifiedImpl();
+    }
+
+    inline bool VerifySkippedImpl(uint64_t offset)
+    {
+        constexpr size_t kChunkSize = 256 * 1024;
+        std::vector<uint8_t> chunk(static_cast<size_t>(std::min<uint64_t>(kChunkSize, offset - m_VerifiedSize)));
+
+        while (m_VerifiedSize < offset) {
+            const auto size = static_cast<size_t>(std::min<uint64_t>(chunk.size(), offset - m_VerifiedSize));
+            const auto data = std::span<uint8_t>(chunk.data(), size);
+            if (ReadAtImpl(m_VerifiedSize, data) != size) {
+                return false;
+            }
+            m_Crc32 = Crc32::Update(m_Crc32, data);
+            m_VerifiedSize += size;
+        }
+        return CheckVerifiedImpl();
+    }
+
+    inline bool CheckVerifiedImpl()
+    {
+        if (m_VerifiedSize < m_Size) {
+            return true;
+        }
+
+        ZipArchivePtr zip = m_ZipArchive.lock();
+        if (!zip || !ResolveEntry(*zip) || m_Crc32 != m_EntryCrc32) {
+            m_IsChecksumMismatch = true;
+            return false;
+        }
+        return true;
+    }
+
+    inline uint64_t ReadAtImpl(uint64_t offset, std::span<uint8_t> buffer)
+    {
+        return ReadVAtImpl(offset, std::span<const std::span<uint8_t>>(&buffer, 1));
+    }
+
+    inline uint64_t ReadVAtImpl(uint64_t offset, std::span<const std::span<uint8_t>> buffers)
     {
         if (!IsOpenedImpl()) {
             return 0;
         }
 
-        std::shared_ptr<mz_zip_archive> zip = m_ZipArchive.lock();
+        if (m_IsWriting) {
+            uint64_t total = 0;
+            for (const auto& buffer : buffers) {
+                const auto read = ReadStagedImpl(offset + total, buffer);
+                total += read;
+                if (read != buffer.size()) {
+                    break;
+                }
+            }
+            return total;
+        }
+
+        ZipArchivePtr zip = m_ZipArchive.lock();
         if (!zip) {
             return 0;
         }
                 
-        if (m_Size <= m_SeekPos) {
+        if (m_Size <= offset) {
             return 0;
         }
 
-        const auto requestedBytes = static_cast<uint64_t>(buffer.size_bytes());
+        uint64_t requestedBytes = 0;
+        for (const auto& buffer : buffers) {
+            requestedBytes += buffer.size_bytes();
+        }
         if (requestedBytes == 0) {
             return 0;
         }
 
-        const auto bytesLeft = m_Size - m_SeekPos;
+        const auto bytesLeft = m_Size - offset;
         auto bytesToRead = std::min(bytesLeft, requestedBytes);
         if (bytesToRead == 0) {
             return 0;
         }
 
+        // Stored entries are read directly from archive without extraction
+        if (const auto dataOffset = StoredDataOffset(*zip)) {
+            uint64_t total = 0;
+            for (const auto& buffer : buffers) {
+                const auto size = std::min(bytesToRead - total, static_cast<uint64_t>(buffer.size()));
+                const auto read = zip->ReadRaw(*dataOffset + offset + total, buffer.first(static_cast<size_t>(size)));
+                total += read;
+                if (read != buffer.size()) {
+                    break;
+                }
+            }
+            return total;
+        }
+
+        // Single inflate pass scatters requested range over all buffers
         PartialExtractContext ctx{};
-        ctx.Offset = m_SeekPos;
+        ctx.Offset = offset;
         ctx.SizeToRead = bytesToRead;
         ctx.TotalRead = 0;
-        ctx.OutBuffer = static_cast<unsigned char*>(buffer.data());
+        ctx.Buffers = buffers;
 
         mz_bool ok = mz_zip_reader_extract_to_callback(
-            zip.get(),
+            zip->Get(),
             m_EntryID,
             partialExtractCallback,
             &ctx,
             0  // flags
         );
 
-        if (!ok) {
+        // Callback stops extraction once requested range is read
+        if (!ok && ctx.TotalRead != ctx.SizeToRead) {
             return 0;
         }
 
-        m_SeekPos += ctx.TotalRead;
         return ctx.TotalRead;
     }
+
+    inline std::optional<FileBuffer> MappedDataImpl()
+    {
+        ZipArchivePtr zip = m_ZipArchive.lock();
+        if (!zip || zip->Memory().empty()) {
+            return std::nullopt;
+        }
+
+        const auto dataOffset = StoredDataOffset(*zip);
+        if (!dataOffset || *dataOffset + m_Size > zip->Memory().size_bytes()) {
+            return std::nullopt;
+        }
+
+        const auto memory = zip->Memory().subspan(static_cast<size_t>(*dataOffset), static_cast<size_t>(m_Size));
+        return FileBuffer(std::move(zip), memory);
+    }
+
+    // Returns offset of entry data in archive if entry stored without compression
+    inline std::optional<uint64_t> StoredDataOffset(ZipArchive& zip)
+    {
+        ResolveEntry(zip);
+        return m_StoredDataOffset;
+    }
+
+    // Reads entry header once, returns false if entry can't be read
+    inline bool ResolveEntry(ZipArchive& zip)
+    {
+        if (!m_IsEntryResolved) {
+            m_IsEntryResolved = true;
+
+            mz_zip_archive_file_stat fileStat;
+            m_IsEntryValid = mz_zip_reader_file_stat(zip.Get(), m_EntryID, &fileStat);
+            if (!m_IsEntryValid) {
+                return false;
+            }
+            m_EntryCrc32 = fileStat.m_crc32;
+
+            // Not compressed and not encrypted
+            const bool isStored = fileStat.m_method == 0 && (fileStat.m_bit_flag & 0x1) == 0 && fileStat.m_comp_size == m_Size;
+            if (isStored) {
+                m_StoredDataOffset = zip.EntryDataOffset(fileStat.m_local_header_ofs);
+            }
+        }
+
+        return m_IsEntryValid;
+    }
     
+    inline uint64_t ReadStagedImpl(uint64_t offset, std::span<uint8_t> buffer)
+    {
+        // Skip reading if file is not opened for reading
+        if (!IFile::ModeHasFlag(m_Mode, FileMode::Read) || m_WriteBuffer.size() <= offset) {
+            return 0;
+        }
+
+        const auto bytesToRead = std::min(static_cast<uint64_t>(m_WriteBuffer.size()) - offset, static_cast<uint64_t>(buffer.size_bytes()));
+        std::memcpy(buffer.data(), m_WriteBuffer.data() + offset, static_cast<size_t>(bytesToRead));
+        return bytesToRead;
+    }
+
     inline uint64_t WriteImpl(std::span<const uint8_t> buffer)
     {
-        return 0;
+        if (!IsOpenedImpl() || !m_IsWriting) {
+            return 0;
+        }
+
+        const auto writeSize = buffer.size_bytes();
+        if (writeSize == 0) {
+            return 0;
+        }
+
+        if (m_SeekPos + writeSize > m_WriteBuffer.size()) {
+            m_WriteBuffer.resize(static_cast<size_t>(m_SeekPos + writeSize));
+        }
+
+        std::memcpy(m_WriteBuffer.data() + m_SeekPos, buffer.data(), writeSize);
+        m_SeekPos += writeSize;
+        m_IsDirty = true;
+        return writeSize;
     }
 
     inline uint64_t ReadImpl(std::vector<uint8_t>& buffer, uint64_t size)
@@ -322,16 +662,28 @@ private:
     
     inline uint64_t WriteImpl(const std::vector<uint8_t>& buffer)
     {
-        return 0;
+        return WriteImpl(std::span<const uint8_t>(buffer.data(), buffer.size()));
     }
 
 private:
     FileInfo m_FileInfo;
     uint32_t m_EntryID;
     uint64_t m_Size;
-    std::weak_ptr<mz_zip_archive> m_ZipArchive;
+    ZipArchiveWeakPtr m_ZipArchive;
+    std::weak_ptr<BasicZipJournal<JournalPolicy>> m_Journal;
+    FileMode m_Mode = FileMode::Read;
     uint64_t m_SeekPos = 0;
-    mutable std::mutex m_Mutex;
+    std::vector<uint8_t> m_WriteBuffer;
+    bool m_IsWriting = false;
+    bool m_IsDirty = false;
+    bool m_IsEntryResolved = false;
+    bool m_IsEntryValid = false;
+    uint32_t m_EntryCrc32 = 0;
+    std::optional<uint64_t> m_StoredDataOffset;
+    uint32_t m_Crc32 = 0;
+    uint64_t m_VerifiedSize = 0;
+    bool m_IsChecksumMismatch = false;
+    [[no_unique_address]] mutable typename Policy::Mutex m_Mutex;
 };
     
 } // namespace vfspp
@@ -2,10 +2,12 @@
 #define VFSPP_ZIPFILESYSTEM_HPP
 
 #include "IFileSystem.h"
+#include "FileIndex.hpp"
 #include "Global.h"
 #include "ThreadingPolicy.hpp"
+#include "ZipArchive.hpp"
+#include "ZipJournal.hpp"
 #include "ZipFile.hpp"
-#include "zip_file.hpp"
 
 #ifdef VFSPP_DISABLE_STD_FILESYSTEM
 #include "FilesystemCompat.hpp"
@@ -17,20 +19,58 @@ namespace fs = std::filesystem;
 namespace vfspp
 {
 
-using ZipFileSystemPtr = std::shared_ptr<class ZipFileSystem>;
-using ZipFileSystemWeakPtr = std::weak_ptr<class ZipFileSystem>;
+template<typename Policy>
+class BasicZipFileSystem;
 
+using ZipFileSystem = BasicZipFileSystem<ThreadingPolicy>;
+using ZipFileSystemPtr = std::shared_ptr<ZipFileSystem>;
+using ZipFileSystemWeakPtr = std::weak_ptr<ZipFileSystem>;
 
-class ZipFileSystem final : public IFileSystem
+
+/*
+ * Filesystem of zip archive, calls are synchronized by Policy
+ */
+template<typename Policy>
+class BasicZipFileSystem final : public IFileSystem
 {
+    using JournalPtr = std::shared_ptr<BasicZipJournal<Policy>>;
+
 public:
-    ZipFileSystem(const std::string& aliasPath, const std::string& zipPath)
+    /*
+     * Open archive from native path. Writable archive is created if not exists, changes
+     * are appended to the end of archive, see ZipJournal
+     */
+    BasicZipFileSystem(const std::string& aliasPath, const std::string& zipPath, bool writable = false)
         : m_AliasPath(aliasPath)
         , m_ZipPath(zipPath)
+        , m_IsWritable(writable)
+    {
+    }
+
+    /*
+     * Open archive from file, it can be any file opened for reading including file from
+     * another archive (nested archive). Memory files, stored entries of memory backed
+     * archives and slices of mapped blobs are used in-place, other files are accessed
+     * with positional reads. Nested archives should be stored without compression to
+     * avoid inflating on every read
+     */
+    BasicZipFileSystem(const std::string& aliasPath, IFilePtr zipFile)
+        : m_AliasPath(aliasPath)
+        , m_ZipFile(std::move(zipFile))
+    {
+    }
+
+    /*
+     * Open archive from memory block, memory must outlive filesystem unless owner is provided
+     */
+    BasicZipFileSystem(const std::string& aliasPath, std::span<const uint8_t> zipData, std::shared_ptr<const void> dataOwner = nullptr)
+        : m_AliasPath(aliasPath)
+        , m_ZipData(zipData)
+        , m_ZipDataOwner(std::move(dataOwner))
     {
     }
 
-    ~ZipFileSystem()
+    ~BasicZipFileSystem()
     {
         Shutdown();
     }
@@ -41,7 +81,7 @@ public:
     [[nodiscard]]
     virtual bool Initialize() override
     {
-        [[maybe_unused]] auto lock = ThreadingPolicy::Lock(m_Mutex);
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
         return InitializeImpl();
     }
 
@@ -50,9 +90,37 @@ public:
      */
     virtual void Shutdown() override
     {
-        [[maybe_unused]] auto lock = ThreadingPolicy::Lock(m_Mutex);
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
         ShutdownImpl();
     }
+
+    /*
+     * Set executor for parallel work
+     */
+    virtual void SetExecutor(ExecutorPtr executor) override
+    {
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
+        m_Executor = std::move(executor);
+    }
+
+    /*
+     * Switch case sensitivity of file lookups, fails if paths of files differ only by case
+     */
+    virtual bool SetCaseSensitive(bool isCaseSensitive) override
+    {
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
+        return m_Files.SetCaseSensitive(isCaseSensitive);
+    }
+
+    /*
+     * Check if file lookups are case sensitive
+     */
+    [[nodiscard]]
+    virtual bool IsCaseSensitive() const override
+    {
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
+        return m_Files.IsCaseSensitive();
+    }
     
     /*
      * Check if filesystem is initialized
@@ -60,7 +128,7 @@ public:
     [[nodiscard]]
     virtual bool IsInitialized() const override
     {
-        [[maybe_unused]] auto lock = ThreadingPolicy::Lock(m_Mutex);
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
         return IsInitializedImpl();
     }
     
@@ -70,7 +138,7 @@ public:
     [[nodiscard]]
     virtual const std::string& BasePath() const override
     {
-        [[maybe_unused]] auto lock = ThreadingPolicy::Lock(m_Mutex);
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
         return BasePathImpl();
     }
 
@@ -80,7 +148,7 @@ public:
     [[nodiscard]]
     virtual const std::string& VirtualPath() const override
     {
-        [[maybe_unused]] auto lock = ThreadingPolicy::Lock(m_Mutex);
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
         return AliasPathImpl();
     }
     
@@ -90,8 +158,39 @@ public:
     [[nodiscard]]
     virtual FilesList GetFilesList() const override
     {
-        [[maybe_unused]] auto lock = ThreadingPolicy::Lock(m_Mutex);
-        return GetFilesListST();
+        return Query([&] { return GetFilesListST(); });
+    }
+
+    /*
+     * Call visitor for each file without copying file list, stops when visitor returns false
+     */
+    virtual void ForEachFile(const FileVisitor& visitor) const override
+    {
+        Query([&] {
+            for (const auto& [path, entry] : m_Files) {
+                if (!visitor(entry.Info)) {
+                    return;
+                }
+            }
+        });
+    }
+
+    /*
+     * List files and directories of directory, paths of directories end with '/'
+     */
+    [[nodiscard]]
+    virtual std::vector<std::string> ListDirectory(const std::string& virtualPath, bool recursive = false) const override
+    {
+        return Query([&] { return m_Files.ListDirectory(virtualPath, recursive); });
+    }
+
+    /*
+     * Find files matching pattern. Returns sorted virtual paths
+     */
+    [[nodiscard]]
+    virtual std::vector<std::string> FindFiles(const GlobPattern& pattern) const override
+    {
+        return Query([&] { return m_Files.Find(pattern); });
     }
     
     /*
@@ -100,7 +199,8 @@ public:
     [[nodiscard]]
     virtual bool IsReadOnly() const override
     {
-        return true;
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
+        return IsReadOnlyImpl();
     }
     
     /*
@@ -109,7 +209,7 @@ public:
      */
     virtual IFilePtr OpenFile(const std::string& virtualPath, IFile::FileMode mode) override
     {
-        [[maybe_unused]] auto lock = ThreadingPolicy::Lock(m_Mutex);
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
         return OpenFileImpl(virtualPath, mode);
     }
     
@@ -118,7 +218,8 @@ public:
      */
     virtual IFilePtr CreateFile(const std::string& virtualPath) override
     {
-        return nullptr;
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
+        return OpenFileImpl(virtualPath, IFile::FileMode::ReadWrite | IFile::FileMode::Truncate);
     }
     
     /*
@@ -126,7 +227,8 @@ public:
      */
     virtual bool RemoveFile(const std::string& virtualPath) override
     {
-        return false;
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
+        return RemoveFileImpl(virtualPath);
     }
     
     /*
@@ -134,7 +236,8 @@ public:
      */
     virtual bool CopyFile(const std::string& srcVirtualPath, const std::string& dstVirtualPath, bool overwrite = false) override
     {
-        return false;
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
+        return CopyFileImpl(srcVirtualPath, dstVirtualPath, overwrite, false);
     }
     
     /*
@@ -142,15 +245,16 @@ public:
      */
     virtual bool RenameFile(const std::string& srcVirtualPath, const std::string& dstVirtualPath) override
     {
-        return false;
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
+        return CopyFileImpl(srcVirtualPath, dstVirtualPath, false, true);
     }
     /*
     * Close file 
     */
-    virtual void CloseFile(IFilePtr file) override
+    virtual bool CloseFile(IFilePtr file) override
     {
-        [[maybe_unused]] auto lock = ThreadingPolicy::Lock(m_Mutex);
-        CloseFileImpl(file);
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
+        return CloseFileImpl(file);
     }
     /*
      * Check if file exists on filesystem
@@ -158,18 +262,84 @@ public:
     [[nodiscard]]
     virtual bool IsFileExists(const std::string& virtualPath) const override
     {
-        [[maybe_unused]] auto lock = ThreadingPolicy::Lock(m_Mutex);
-        return IsFileExistsImpl(virtualPath);
+        return Query([&] { return IsFileExistsImpl(virtualPath); });
+    }
+
+    /*
+     * Get file metadata without opening file
+     */
+    [[nodiscard]]
+    virtual std::optional<FileStat> Stat(const std::string& virtualPath) const override
+    {
+        return Query([&] { return StatImpl(virtualPath); });
+    }
+
+    /*
+     * Read whole file without opening file object, uncompressed files of memory
+     * backed archive are referenced in-place. Lock is held only to find entry, it's
+     * extracted without lock
+     */
+    [[nodiscard]]
+    virtual std::optional<FileBuffer> ReadAll(const std::string& virtualPath) const override
+    {
+        const auto location = Query([&] { return FindEntryImpl(virtualPath); });
+        return location ? ReadEntryData(*location) : std::nullopt;
+    }
+
+    /*
+     * Rewrite writable archive without dead space left by replaced and removed files.
+     * With multithreaded Policy it can be called from background thread, files remain
+     * readable and writable during compaction. SingleThreadedPolicy filesystem has no locks,
+     * so it must be compacted on thread using it
+     */
+    [[nodiscard]]
+    bool Compact()
+    {
+        JournalPtr journal;
+        {
+            [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
+            journal = m_Journal;
+        }
+        return journal && journal->Compact();
+    }
+
+    /*
+     * Approximate size of dead space in writable archive that can be reclaimed by Compact()
+     */
+    [[nodiscard]]
+    uint64_t DeadBytes() const
+    {
+        [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
+        return m_Journal ? m_Journal->DeadBytes() : 0;
     }
 
 private:
+    struct OpenedHandle
+    {
+        IFileWeakPtr File;
+        uint64_t Generation; // Journal generation of archive used by file
+    };
+
+    // Entry data location copied from index, archive is kept alive while entry is read
+    struct EntryLocation
+    {
+        ZipArchivePtr Archive;
+        uint32_t EntryID;
+        uint64_t Size;
+        uint64_t CompressedSize;
+        uint16_t Method;
+    };
+
     struct FileEntry
     {
         FileInfo Info;
-        std::vector<ZipFileWeakPtr> OpenedHandles;
+        std::vector<OpenedHandle> OpenedHandles;
 
         uint32_t EntryID;
         uint64_t Size;
+        uint64_t CompressedSize = 0;
+        uint16_t Method = 0;
+        std::time_t ModifiedTime = 0;
 
         explicit FileEntry(const FileInfo& info, uint32_t entryID, uint64_t size)
             : Info(info)
@@ -180,8 +350,8 @@ private:
 
         void CleanupOpenedHandles(IFilePtr fileToExclude = nullptr)
         {
-            OpenedHandles.erase(std::remove_if(OpenedHandles.begin(), OpenedHandles.end(), [&](const ZipFileWeakPtr& weak) {
-                return weak.expired() || weak.lock() == fileToExclude;
+            OpenedHandles.erase(std::remove_if(OpenedHandles.begin(), OpenedHandles.end(), [&](const OpenedHandle& handle) {
+                return handle.File.expired() || IsSameFile(handle.File, fileToExclude);
             }), OpenedHandles.end());
         }
     };
@@ -192,18 +362,27 @@ private:
             return true;
         }
 
-        if (!fs::is_regular_file(m_ZipPath)) {
-            return false;
-        }
-
-        m_ZipArchive = std::make_shared<mz_zip_archive>();
+        if (m_IsWritable) {
+            if (m_ZipPath.empty()) {
+                return false;
+            }
 
-        mz_bool status = mz_zip_reader_init_file(m_ZipArchive.get(), m_ZipPath.c_str(), 0);
-        if (!status) {
-            return false;
+            auto journal = std::make_shared<BasicZipJournal<Policy>>(m_ZipPath);
+            if (!journal->Open()) {
+                return false;
+            }
+            m_Journal = journal;
+            m_JournalGeneration = journal->Generation();
+            m_ZipArchive = journal->Archive();
+        } else {
+            auto zipArchive = std::make_shared<ZipArchive>();
+            if (!OpenArchive(*zipArchive)) {
+                return false;
+            }
+            m_ZipArchive = zipArchive;
         }
 
-        BuildFilelist(AliasPathImpl(), BasePathImpl(), m_ZipArchive, m_Files);
+        BuildFilelist(AliasPathImpl(), BasePathImpl(), m_ZipArchive, m_Executor.get(), m_Files);
         m_IsInitialized = true;
         return true;
     }
@@ -211,13 +390,16 @@ private:
     inline void ShutdownImpl()
     {
         m_ZipPath = "";
+        m_ZipFile = nullptr;
+        m_ZipData = {};
+        m_ZipDataOwner = nullptr;
         m_Files.clear();
 
-        // close zip archive
-        if (m_ZipArchive) {
-            mz_zip_reader_end(m_ZipArchive.get());
-            m_ZipArchive = nullptr;
-        }
+        // Archive is closed as soon as last reading file releases it
+        m_ZipArchive = nullptr;
+        m_RetiredArchives.clear();
+        m_Journal = nullptr;
+        m_JournalGeneration = 0;
 
         m_IsInitialized = false;
     }
@@ -247,27 +429,51 @@ private:
         return fileList;
     }
     
+    inline bool IsReadOnlyImpl() const
+    {
+        return m_Journal == nullptr;
+    }
+
     inline IFilePtr OpenFileImpl(const std::string& virtualPath, IFile::FileMode mode)
     {
-        const auto entryIt = m_Files.find(virtualPath);
+        SyncJournalImpl();
+
+        const bool requestWrite = IFile::ModeHasFlag(mode, IFile::FileMode::Write);
+        if (IsReadOnlyImpl() && requestWrite) {
+            return nullptr;
+        }
+
+        auto entryIt = m_Files.find(virtualPath);
+        if (entryIt == m_Files.end() && requestWrite) {
+            // Create new file entry, it's added to archive when file is closed
+            FileInfo fileInfo(AliasPathImpl(), BasePathImpl(), virtualPath);
+            entryIt = m_Files.emplace(fileInfo.VirtualPath(), FileEntry(fileInfo, ZipFile::kNewEntryID, 0)).first;
+        }
+
         if (entryIt == m_Files.end()) {
             return nullptr;
         }
         auto& entry = entryIt->second;
 
-        ZipFilePtr file = std::make_shared<ZipFile>(entry.Info, entry.EntryID, entry.Size, m_ZipArchive);
+        IFilePtr file;
+        if (IFile::ModeHasFlag(mode, IFile::FileMode::ExclusiveOwner)) {
+            file = std::make_shared<BasicZipFile<SingleThreadedPolicy, Policy>>(entry.Info, entry.EntryID, entry.Size, m_ZipArchive, m_Journal);
+        } else {
+            file = std::make_shared<BasicZipFile<Policy>>(entry.Info, entry.EntryID, entry.Size, m_ZipArchive, m_Journal);
+        }
+
         if (!file || !file->Open(mode)) {
             return nullptr;
         }
 
-        entry.OpenedHandles.push_back(file);
+        entry.OpenedHandles.push_back({file, m_JournalGeneration});
         
         return file;
     }
 
-    inline void CloseFileImpl(IFilePtr file)
+    inline bool CloseFileImpl(IFilePtr file)
     {
-        CloseFileAndCleanupOpenedHandles(file);
+        return CloseFileAndCleanupOpenedHandles(file);
     }
 
     inline bool IsFileExistsImpl(const std::string& virtualPath) const
@@ -275,60 +481,315 @@ private:
         return m_Files.find(virtualPath) != m_Files.end();
     }
 
-    void BuildFilelist(const std::string& aliasPath, const std::string& basePath, std::shared_ptr<mz_zip_archive> zipArchive, std::unordered_map<std::string, FileEntry>& outFiles)
+    inline std::optional<EntryLocation> FindEntryImpl(const std::string& virtualPath) const
     {
-        for (mz_uint i = 0; i < mz_zip_reader_get_num_files(zipArchive.get()); i++) {
-            mz_zip_archive_file_stat file_stat;
-            if (!mz_zip_reader_file_stat(zipArchive.get(), i, &file_stat)) {
-                // TODO: log error
-                continue;
+        const auto it = m_Files.find(virtualPath);
+        if (it == m_Files.end() || !m_ZipArchive) {
+            return std::nullopt;
+        }
+        const auto& entry = it->second;
+        return EntryLocation{ m_ZipArchive, entry.EntryID, entry.Size, entry.CompressedSize, entry.Method };
+    }
+
+    // Archive is only read here, entries are extracted concurrently same as by opened files
+    static std::optional<FileBuffer> ReadEntryData(const EntryLocation& location)
+    {
+        // File is not committed to archive yet
+        if (location.EntryID == ZipFile::kNewEntryID) {
+            return FileBuffer();
+        }
+
+        // Uncompressed data of memory backed archive is used in-place
+        ZipArchive& zipArchive = *location.Archive;
+        const auto memory = zipArchive.Memory();
+        if (location.Method == 0 && location.CompressedSize == location.Size && !memory.empty()) {
+            mz_zip_archive_file_stat fileStat;
+            if (mz_zip_reader_file_stat(zipArchive.Get(), location.EntryID, &fileStat) && (fileStat.m_bit_flag & 0x1) == 0) {
+                const auto offset = zipArchive.EntryDataOffset(fileStat.m_local_header_ofs);
+                if (offset && *offset + location.Size <= memory.size()) {
+                    return FileBuffer(location.Archive, memory.subspan(static_cast<size_t>(*offset), static_cast<size_t>(location.Size)));
+                }
+            }
+        }
+
+        // Extract directly to final buffer
+        auto data = std::make_shared<std::vector<uint8_t>>(static_cast<size_t>(location.Size));
+        if (!mz_zip_reader_extract_to_mem(zipArchive.Get(), location.EntryID, data->data(), data->size(), 0)) {
+            return std::nullopt;
+        }
+        return FileBuffer(std::move(data));
+    }
+
+    inline std::optional<FileStat> StatImpl(const std::string& virtualPath) const
+    {
+        const auto it = m_Files.find(virtualPath);
+        if (it == m_Files.end()) {
+            return std::nullopt;
+        }
+        const auto& entry = it->second;
+
+        FileStat stat;
+        stat.Size = entry.Size;
+        stat.ModifiedTime = entry.ModifiedTime;
+        stat.CompressionMethod = entry.Method;
+        stat.CompressedSize = entry.CompressedSize;
+        return stat;
+    }
+
+    inline bool RemoveFileImpl(const std::string& virtualPath)
+    {
+        if (IsReadOnlyImpl()) {
+            return false;
+        }
+
+        SyncJournalImpl();
+
+        const auto it = m_Files.find(virtualPath);
+        if (it == m_Files.end() || it->second.EntryID == ZipFile::kNewEntryID) {
+            return false;
+        }
+
+        const bool removed = m_Journal->Remove(it->second.Info.FilePath());
+        SyncJournalImpl();
+        return removed;
+    }
+
+    inline bool CopyFileImpl(const std::string& srcVirtualPath, const std::string& dstVirtualPath, bool overwrite, bool removeSource)
+    {
+        if (IsReadOnlyImpl()) {
+            return false;
+        }
+
+        // Check is src and dst start with alias path
+        if (srcVirtualPath.find(AliasPathImpl()) != 0 || dstVirtualPath.find(AliasPathImpl()) != 0) {
+            return false;
+        }
+
+        SyncJournalImpl();
+
+        const auto srcIt = m_Files.find(srcVirtualPath);
+        if (srcIt == m_Files.end() || srcIt->second.EntryID == ZipFile::kNewEntryID) {
+            return false;
+        }
+
+        const FileInfo dstInfo(AliasPathImpl(), BasePathImpl(), dstVirtualPath);
+        const auto& srcName = srcIt->second.Info.FilePath();
+        const bool ok = removeSource
+            ? m_Journal->Rename(srcName, dstInfo.FilePath())
+            : m_Journal->Copy(srcName, dstInfo.FilePath(), overwrite);
+
+        SyncJournalImpl();
+        return ok;
+    }
+
+    // Queries run under shared lock. Exclusive lock is taken only if journal has changes
+    // not picked up yet, so lookups of read-only archive never take it
+    template<typename QueryFunc>
+    auto Query(QueryFunc&& query) const
+    {
+        {
+            [[maybe_unused]] auto lock = Policy::SharedLock(m_Mutex);
+            if (!IsJournalChangedImpl()) {
+                return query();
             }
+        }
 
-            // Skip directories (entries ending with '/')
-            std::string filename = file_stat.m_filename;
-            if (!filename.empty() && filename.back() == '/') {
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
+        SyncJournalImpl();
+        return query();
+    }
+
+    inline bool IsJournalChangedImpl() const
+    {
+        return m_Journal && m_Journal->Generation() != m_JournalGeneration;
+    }
+
+    // Pick up changes committed to journal by this filesystem or its opened files
+    inline void SyncJournalImpl() const
+    {
+        if (!m_Journal) {
+            return;
+        }
+
+        const uint64_t generation = m_Journal->Generation();
+        if (generation == m_JournalGeneration) {
+            return;
+        }
+
+        ZipArchivePtr zipArchive = m_Journal->Archive();
+        if (!zipArchive) {
+            return;
+        }
+
+        FileIndex<FileEntry, Policy> files;
+        files.SetCaseSensitive(m_Files.IsCaseSensitive());
+        BuildFilelist(AliasPathImpl(), BasePathImpl(), zipArchive, m_Executor.get(), files);
+
+        // Keep track of opened files, including new files that are not committed yet
+        for (auto& [path, entry] : m_Files) {
+            entry.CleanupOpenedHandles();
+            if (entry.OpenedHandles.empty()) {
                 continue;
             }
 
-            FileInfo fileInfo(aliasPath, basePath, filename);
-            outFiles.emplace(
-                fileInfo.VirtualPath(),
-                FileEntry(
-                    fileInfo,
-                    static_cast<uint32_t>(file_stat.m_file_index),
-                    static_cast<uint64_t>(file_stat.m_uncomp_size)
-                )
-            );
+            auto it = files.find(path);
+            if (it == files.end()) {
+                if (entry.EntryID != ZipFile::kNewEntryID) {
+                    continue;
+                }
+                it = files.emplace(path, FileEntry(entry.Info, ZipFile::kNewEntryID, 0)).first;
+            }
+            auto& handles = it->second.OpenedHandles;
+            handles.insert(handles.end(), entry.OpenedHandles.begin(), entry.OpenedHandles.end());
+        }
+
+        // Files opened before keep reading previous archive, its data is never overwritten
+        if (m_ZipArchive) {
+            m_RetiredArchives.emplace_back(m_JournalGeneration, m_ZipArchive);
+        }
+
+        m_Files = std::move(files);
+        m_ZipArchive = zipArchive;
+        m_JournalGeneration = generation;
+
+        ReleaseRetiredArchivesImpl();
+    }
+
+    inline void ReleaseRetiredArchivesImpl() const
+    {
+        if (m_RetiredArchives.empty()) {
+            return;
         }
+
+        uint64_t oldestGeneration = m_JournalGeneration;
+        for (const auto& [path, entry] : m_Files) {
+            for (const auto& handle : entry.OpenedHandles) {
+                if (!handle.File.expired()) {
+                    oldestGeneration = std::min(oldestGeneration, handle.Generation);
+                }
+            }
+        }
+
+        m_RetiredArchives.erase(std::remove_if(m_RetiredArchives.begin(), m_RetiredArchives.end(), [&](const auto& retired) {
+            return retired.first < oldestGeneration;
+        }), m_RetiredArchives.end());
     }
 
-    inline void CloseFileAndCleanupOpenedHandles(IFilePtr fileToClose = nullptr)
+    bool OpenArchive(ZipArchive& zipArchive)
     {
+        if (!m_ZipData.empty()) {
+            return zipArchive.OpenMemory(m_ZipData, m_ZipDataOwner);
+        }
+
+        if (m_ZipFile) {
+            // Contiguous data is used in-place, no extraction or copy
+            if (auto data = m_ZipFile->MappedData(); data && !data->IsEmpty()) {
+                return zipArchive.OpenMemory(data->Data(), data->Owner());
+            }
+
+            return zipArchive.OpenStream(m_ZipFile);
+        }
+
+        if (!fs::is_regular_file(m_ZipPath)) {
+            return false;
+        }
+
+        return zipArchive.OpenFile(m_ZipPath);
+    }
+
+    static void BuildFilelist(const std::string& aliasPath, const std::string& basePath, ZipArchivePtr zipArchive, Executor* executor, FileIndex<FileEntry, Policy>& outFiles)
+    {
+        const mz_uint fileCount = mz_zip_reader_get_num_files(zipArchive->Get());
+
+        // Central directory is kept in memory, so entries are parsed in parallel chunks
+        // and added in archive order
+        constexpr mz_uint kChunkSize = 4096;
+        const size_t chunkCount = (fileCount + kChunkSize - 1) / kChunkSize;
+
+        std::vector<std::vector<FileEntry>> chunks(chunkCount);
+        ParallelFor(executor, chunkCount, [&](size_t chunk) {
+            const mz_uint begin = static_cast<mz_uint>(chunk * kChunkSize);
+            const mz_uint end = std::min(fileCount, begin + kChunkSize);
+            for (mz_uint i = begin; i < end; i++) {
+                if (auto entry = ReadEntry(aliasPath, basePath, *zipArchive, i)) {
+                    chunks[chunk].push_back(std::move(*entry));
+                }
+            }
+        });
+
+        for (auto& entries : chunks) {
+            for (auto& entry : entries) {
+                const std::string virtualPath = entry.Info.VirtualPath();
+                outFiles.emplace(virtualPath, std::move(entry));
+            }
+        }
+    }
+
+    static std::optional<FileEntry> ReadEntry(const std::string& aliasPath, const std::string& basePath, ZipArchive& zipArchive, mz_uint index)
+    {
+        mz_zip_archive_file_stat file_stat;
+        if (!mz_zip_reader_file_stat(zipArchive.Get(), index, &file_stat)) {
+            // TODO: log error
+            return std::nullopt;
+        }
+
+        // Skip directories (entries ending with '/')
+        std::string filename = file_stat.m_filename;
+        if (!filename.empty() && filename.back() == '/') {
+            return std::nullopt;
+        }
+
+        FileEntry entry(
+            FileInfo(aliasPath, basePath, filename),
+            static_cast<uint32_t>(file_stat.m_file_index),
+            static_cast<uint64_t>(file_stat.m_uncomp_size)
+        );
+        entry.CompressedSize = static_cast<uint64_t>(file_stat.m_comp_size);
+        entry.Method = file_stat.m_method;
+        entry.ModifiedTime = file_stat.m_time;
+        return entry;
+    }
+
+    inline bool CloseFileAndCleanupOpenedHandles(IFilePtr fileToClose = nullptr)
+    {
+        bool isClosed = true;
         if (fileToClose) {
             const auto absolutePath = fileToClose->GetFileInfo().VirtualPath();
             
             const auto it = m_Files.find(absolutePath);
             if (it == m_Files.end()) {
-                return;
+                return false;
             }
             
-            fileToClose->Close();
+            isClosed = fileToClose->Close();
         }
 
         for (auto& [path, entry] : m_Files) {
-            entry.CleanupOpenedHandles(fileToClose);
+            // Handle of file which failed to close stays registered
+            entry.CleanupOpenedHandles(isClosed ? fileToClose : nullptr);
         }
+
+        ReleaseRetiredArchivesImpl();
+        return isClosed;
     }
     
 private:
     std::string m_AliasPath;
     std::string m_BasePath;
     std::string m_ZipPath;
-    std::shared_ptr<mz_zip_archive> m_ZipArchive = nullptr;
+    IFilePtr m_ZipFile;
+    std::span<const uint8_t> m_ZipData;
+    std::shared_ptr<const void> m_ZipDataOwner;
+    bool m_IsWritable = false;
+    mutable ZipArchivePtr m_ZipArchive = nullptr;
+    JournalPtr m_Journal;
+    mutable uint64_t m_JournalGeneration = 0;
+    mutable std::vector<std::pair<uint64_t, ZipArchivePtr>> m_RetiredArchives;
     bool m_IsInitialized = false;
-    mutable std::mutex m_Mutex;
+    ExecutorPtr m_Executor;
+    [[no_unique_address]] mutable typename Policy::Mutex m_Mutex;
 
-    std::unordered_map<std::string, FileEntry> m_Files;
+    mutable FileIndex<FileEntry, Policy> m_Files;
 };
 
 } // namespace vfspp
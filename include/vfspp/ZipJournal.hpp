@@ -0,0 +1,551 @@
+#ifndef VFSPP_ZIPJOURNAL_HPP
+#define VFSPP_ZIPJOURNAL_HPP
+
+#include "Global.h"
+#include "ThreadingPolicy.hpp"
+#include "ZipArchive.hpp"
+#include "ZipWriter.hpp"
+
+#ifdef VFSPP_DISABLE_STD_FILESYSTEM
+#include "FilesystemCompat.hpp"
+namespace fs = vfspp::fs_compat;
+#else
+namespace fs = std::filesystem;
+#endif
+
+namespace vfspp
+{
+
+template<typename Policy>
+class BasicZipJournal;
+
+using ZipJournal = BasicZipJournal<ThreadingPolicy>;
+using ZipJournalPtr = std::shared_ptr<ZipJournal>;
+using ZipJournalWeakPtr = std::weak_ptr<ZipJournal>;
+
+
+/*
+ * Append-only modifications of zip archive. Each change appends new entries followed by
+ * new central directory to the end of archive, removed entries are dropped from central
+ * directory (tombstoned) and their data stays in archive as dead space until Compact().
+ * Bytes written before are never modified, so archives opened earlier remain valid.
+ * Failed change is cut off the end of archive, change interrupted by crash is cut off
+ * when archive is opened next time, so archive always ends with valid central directory.
+ * Every change writes whole central directory and reopens archive, so change costs time
+ * proportional to number of entries and N changes write O(N^2) bytes of directories.
+ * Journal suits incremental updates, archives with many new files are built by ZipBuilder.
+ * Calls are synchronized by Policy
+ */
+template<typename Policy>
+class BasicZipJournal final
+{
+public:
+    explicit BasicZipJournal(const std::string& zipPath, int compressionLevel = MZ_DEFAULT_LEVEL)
+        : m_ZipPath(zipPath)
+        , m_CompressionLevel(compressionLevel)
+    {
+    }
+
+    BasicZipJournal(const BasicZipJournal&) = delete;
+    BasicZipJournal& operator=(const BasicZipJournal&) = delete;
+
+    /*
+     * Open existing archive or create empty one
+     */
+    [[nodiscard]]
+    bool Open()
+    {
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
+
+        if (!fs::exists(m_ZipPath)) {
+            ZipWriter writer;
+            if (!writer.Open(m_ZipPath, false) || !writer.WriteCentralDirectory({}) || !writer.Close()) {
+                return false;
+            }
+        }
+
+        if (!RecoverImpl()) {
+            return false;
+        }
+
+        auto archive = std::make_shared<ZipArchive>();
+        if (!archive->OpenFile(m_ZipPath)) {
+            return false;
+        }
+
+        std::vector<ZipEntryRecord> entries;
+        if (!LoadEntries(*archive, entries)) {
+            return false;
+        }
+
+        m_Entries = std::move(entries);
+        m_Archive = archive;
+        m_Generation++;
+        return true;
+    }
+
+    /*
+     * Current archive reader, it's replaced by new reader after each change
+     */
+    [[nodiscard]]
+    ZipArchivePtr Archive() const
+    {
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
+        return m_Archive;
+    }
+
+    /*
+     * Incremented after each change of archive
+     */
+    [[nodiscard]]
+    uint64_t Generation() const
+    {
+        return m_Generation.load(std::memory_order_acquire);
+    }
+
+    /*
+     * Add or replace entry with given data
+     */
+    [[nodiscard]]
+    bool Write(const std::string& name, std::span<const uint8_t> data)
+    {
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
+
+        std::vector<uint8_t> compressed;
+        const bool isDeflated = ZipWriter::Deflate(data, m_CompressionLevel, compressed);
+        const auto entryData = isDeflated ? std::span<const uint8_t>(compressed) : data;
+        const auto method = isDeflated ? ZipWriter::kMethodDeflated : ZipWriter::kMethodStored;
+
+        ZipWriter writer;
+        if (!writer.Open(m_ZipPath, true)) {
+            return false;
+        }
+        const uint64_t archiveSize = writer.Offset();
+
+        auto record = writer.AddEntry(name, entryData, method, ZipWriter::Crc32(data), data.size_bytes(), std::time(nullptr));
+        if (!record) {
+            return RollbackImpl(writer, archiveSize);
+        }
+
+        auto entries = m_Entries;
+        ReplaceEntry(entries, std::move(*record));
+        return CommitImpl(writer, archiveSize, std::move(entries));
+    }
+
+    /*
+     * Remove entry, data becomes dead space
+     */
+    [[nodiscard]]
+    bool Remove(const std::string& name)
+    {
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
+
+        auto entries = m_Entries;
+        const auto it = FindEntry(entries, name);
+        if (it == entries.end()) {
+            return false;
+        }
+        entries.erase(it);
+
+        ZipWriter writer;
+        if (!writer.Open(m_ZipPath, true)) {
+            return false;
+        }
+        return CommitImpl(writer, writer.Offset(), std::move(entries));
+    }
+
+    /*
+     * Copy entry, compressed data is copied as-is
+     */
+    [[nodiscard]]
+    bool Copy(const std::string& srcName, const std::string& dstName, bool overwrite)
+    {
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
+        return CopyImpl(srcName, dstName, overwrite, false);
+    }
+
+    /*
+     * Rename entry, compressed data is copied as-is and old data becomes dead space
+     */
+    [[nodiscard]]
+    bool Rename(const std::string& srcName, const std::string& dstName)
+    {
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
+        return CopyImpl(srcName, dstName, false, true);
+    }
+
+    /*
+     * Rewrite archive with live entries only, meant to run on background thread or executor.
+     * Entries are copied from snapshot of archive without blocking readers or writers,
+     * writers wait only while entries changed during copying are added. Only one compaction
+     * runs at a time. On platforms where opened file can't be replaced compaction fails and
+     * archive stays untouched. Running it concurrently with other calls needs multithreaded
+     * Policy, journal of SingleThreadedPolicy is compacted on thread using it
+     */
+    [[nodiscard]]
+    bool Compact()
+    {
+        if (m_IsCompacting.exchange(true, std::memory_order_acq_rel)) {
+            return false;
+        }
+
+        const std::string compactPath = m_ZipPath + ".compact";
+        const bool isCompacted = CompactImpl(compactPath);
+        if (!isCompacted) {
+            std::error_code ec;
+            fs::remove(compactPath, ec);
+        }
+
+        m_IsCompacting.store(false, std::memory_order_release);
+        return isCompacted;
+    }
+
+    /*
+     * Approximate bytes occupied by replaced or removed entries and old central directories
+     */
+    [[nodiscard]]
+    uint64_t DeadBytes() const
+    {
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
+
+        if (!m_Archive) {
+            return 0;
+        }
+
+        uint64_t liveBytes = 0;
+        for (const auto& entry : m_Entries) {
+            liveBytes += 30 + entry.Name.size() + entry.CompressedSize; // local header and data
+            liveBytes += 46 + entry.Name.size(); // central directory record
+        }
+        liveBytes += 22; // end of central directory
+
+        const uint64_t archiveSize = m_Archive->Get()->m_archive_size;
+        return archiveSize > liveBytes ? archiveSize - liveBytes : 0;
+    }
+
+private:
+    static std::vector<ZipEntryRecord>::iterator FindEntry(std::vector<ZipEntryRecord>& entries, const std::string& name)
+    {
+        return std::find_if(entries.begin(), entries.end(), [&](const ZipEntryRecord& entry) {
+            return entry.Name == name;
+        });
+    }
+
+    static void ReplaceEntry(std::vector<ZipEntryRecord>& entries, ZipEntryRecord record)
+    {
+        auto it = FindEntry(entries, record.Name);
+        if (it != entries.end()) {
+            *it = std::move(record);
+        } else {
+            entries.push_back(std::move(record));
+        }
+    }
+
+    static bool LoadEntries(ZipArchive& archive, std::vector<ZipEntryRecord>& outEntries)
+    {
+        mz_zip_archive* zip = archive.Get();
+        const mz_uint count = mz_zip_reader_get_num_files(zip);
+        outEntries.reserve(count);
+
+        for (mz_uint i = 0; i < count; i++) {
+            mz_zip_archive_file_stat fileStat;
+            if (!mz_zip_reader_file_stat(zip, i, &fileStat)) {
+                return false;
+            }
+
+            // Zip64 and encrypted archives can't be journaled
+            if (fileStat.m_comp_size > 0xFFFFFFFFu || fileStat.m_uncomp_size > 0xFFFFFFFFu || fileStat.m_local_header_ofs > 0xFFFFFFFFu) {
+                return false;
+            }
+            if ((fileStat.m_bit_flag & 0x1) != 0) {
+                return false;
+            }
+
+            ZipEntryRecord record;
+            record.Name = fileStat.m_filename;
+            record.Method = fileStat.m_method;
+            record.BitFlag = fileStat.m_bit_flag;
+            record.Crc32 = fileStat.m_crc32;
+            record.CompressedSize = fileStat.m_comp_size;
+            record.UncompressedSize = fileStat.m_uncomp_size;
+            record.LocalHeaderOffset = fileStat.m_local_header_ofs;
+            record.ExternalAttributes = fileStat.m_external_attr;
+            ReadDosDateTime(archive, record);
+            outEntries.push_back(std::move(record));
+        }
+
+        return true;
+    }
+
+    static void ReadDosDateTime(ZipArchive& archive, ZipEntryRecord& record)
+    {
+        // Local header keeps original DOS time, it avoids lossy time_t conversion
+        std::array<uint8_t, 4> dateTime{};
+        if (archive.ReadRaw(record.LocalHeaderOffset + 10, dateTime) == dateTime.size()) {
+            record.DosTime = static_cast<uint16_t>(dateTime[0] | (dateTime[1] << 8));
+            record.DosDate = static_cast<uint16_t>(dateTime[2] | (dateTime[3] << 8));
+        }
+    }
+
+    static bool ReadEntryData(ZipArchive& archive, const ZipEntryRecord& entry, std::vector<uint8_t>& outData)
+    {
+        const auto dataOffset = archive.EntryDataOffset(entry.LocalHeaderOffset);
+        if (!dataOffset) {
+            return false;
+        }
+
+        outData.resize(static_cast<size_t>(entry.CompressedSize));
+        return archive.ReadRaw(*dataOffset, outData) == outData.size();
+    }
+
+    // Copy entry data as-is, compressed data and metadata are kept
+    static std::optional<ZipEntryRecord> CopyEntry(ZipArchive& archive, const ZipEntryRecord& entry, ZipWriter& writer, std::vector<uint8_t>& buffer)
+    {
+        if (!ReadEntryData(archive, entry, buffer)) {
+            return std::nullopt;
+        }
+
+        auto record = writer.AddEntry(entry.Name, buffer, entry.Method, entry.Crc32, entry.UncompressedSize, 0);
+        if (record) {
+            record->DosTime = entry.DosTime;
+            record->DosDate = entry.DosDate;
+            record->ExternalAttributes = entry.ExternalAttributes;
+        }
+        return record;
+    }
+
+    // Archive reader is never modified after it's published, so snapshot entries are
+    // copied without lock. Entry is same if it still has same name and local header
+    bool CompactImpl(const std::string& compactPath)
+    {
+        ZipArchivePtr snapshotArchive;
+        std::vector<ZipEntryRecord> snapshot;
+        {
+            [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
+            if (!m_Archive) {
+                return false;
+            }
+            snapshotArchive = m_Archive;
+            snapshot = m_Entries;
+        }
+
+        ZipWriter writer;
+        if (!writer.Open(compactPath, false)) {
+            return false;
+        }
+
+        std::unordered_map<std::string, std::pair<uint64_t, ZipEntryRecord>> copied;
+        copied.reserve(snapshot.size());
+        std::vector<uint8_t> buffer;
+        for (const auto& entry : snapshot) {
+            auto record = CopyEntry(*snapshotArchive, entry, writer, buffer);
+            if (!record) {
+                return false;
+            }
+            copied.try_emplace(entry.Name, entry.LocalHeaderOffset, std::move(*record));
+        }
+
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
+
+        std::vector<ZipEntryRecord> entries;
+        entries.reserve(m_Entries.size());
+        for (const auto& entry : m_Entries) {
+            const auto it = copied.find(entry.Name);
+            if (it != copied.end() && it->second.first == entry.LocalHeaderOffset) {
+                entries.push_back(std::move(it->second.second));
+                continue;
+            }
+
+            auto record = CopyEntry(*m_Archive, entry, writer, buffer);
+            if (!record) {
+                return false;
+            }
+            entries.push_back(std::move(*record));
+        }
+
+        if (!writer.WriteCentralDirectory(entries) || !writer.Close()) {
+            return false;
+        }
+
+        // Compacted archive is opened before it replaces original, so failed open leaves
+        // original untouched
+        auto archive = std::make_shared<ZipArchive>();
+        if (!archive->OpenFile(compactPath)) {
+            return false;
+        }
+
+        std::error_code ec;
+        fs::rename(compactPath, m_ZipPath, ec);
+        if (ec) {
+            return false;
+        }
+
+        m_Entries = std::move(entries);
+        m_Archive = archive;
+        m_Generation.fetch_add(1, std::memory_order_acq_rel);
+        return true;
+    }
+
+    bool CopyImpl(const std::string& srcName, const std::string& dstName, bool overwrite, bool removeSource)
+    {
+        if (!m_Archive || srcName == dstName) {
+            return false;
+        }
+
+        auto entries = m_Entries;
+        const auto srcIt = FindEntry(entries, srcName);
+        if (srcIt == entries.end()) {
+            return false;
+        }
+
+        if (FindEntry(entries, dstName) != entries.end() && !overwrite) {
+            return false;
+        }
+
+        ZipEntryRecord source = *srcIt;
+        source.Name = dstName;
+
+        ZipWriter writer;
+        if (!writer.Open(m_ZipPath, true)) {
+            return false;
+        }
+        const uint64_t archiveSize = writer.Offset();
+
+        std::vector<uint8_t> buffer;
+        auto record = CopyEntry(*m_Archive, source, writer, buffer);
+        if (!record) {
+            return RollbackImpl(writer, archiveSize);
+        }
+
+        if (removeSource) {
+            entries.erase(FindEntry(entries, srcName));
+        }
+        ReplaceEntry(entries, std::move(*record));
+        return CommitImpl(writer, archiveSize, std::move(entries));
+    }
+
+    // Archive size is size before change, it's restored if commit fails
+    bool CommitImpl(ZipWriter& writer, uint64_t archiveSize, std::vector<ZipEntryRecord> entries)
+    {
+        if (!writer.WriteCentralDirectory(entries) || !writer.Close()) {
+            return RollbackImpl(writer, archiveSize);
+        }
+
+        auto archive = std::make_shared<ZipArchive>();
+        if (!archive->OpenFile(m_ZipPath)) {
+            return RollbackImpl(writer, archiveSize);
+        }
+
+        m_Entries = std::move(entries);
+        m_Archive = archive;
+        m_Generation.fetch_add(1, std::memory_order_acq_rel);
+        return true;
+    }
+
+    // Cut appended data, archive ends with previous central directory again. If truncation
+    // isn't supported data is left and cut by RecoverImpl on next open
+    bool RollbackImpl(ZipWriter& writer, uint64_t archiveSize)
+    {
+        writer.Close();
+        ZipWriter::Truncate(m_ZipPath, archiveSize);
+        return false;
+    }
+
+    // Cut data written after last valid end of central directory record, e.g. by change
+    // interrupted by crash. Such tail can hide the record from zip reader
+    bool RecoverImpl()
+    {
+        std::error_code ec;
+        const uint64_t fileSize = fs::file_size(m_ZipPath, ec);
+        if (ec) {
+            return false;
+        }
+
+        const auto archiveEnd = FindArchiveEnd(m_ZipPath, fileSize);
+        if (!archiveEnd) {
+            return false;
+        }
+        return *archiveEnd == fileSize || ZipWriter::Truncate(m_ZipPath, *archiveEnd);
+    }
+
+    // Search end of central directory record backwards from end of file. Record is valid if
+    // central directory ends right before it and starts with central header
+    static std::optional<uint64_t> FindArchiveEnd(const std::string& zipPath, uint64_t fileSize)
+    {
+        constexpr uint32_t kEndOfCentralDirectorySignature = 0x06054b50;
+        constexpr uint32_t kCentralHeaderSignature = 0x02014b50;
+        constexpr size_t kEndRecordSize = 22;
+        constexpr uint64_t kBlockSize = 64 * 1024;
+
+        std::ifstream stream(zipPath, std::ios::binary);
+        auto readAt = [&](uint64_t offset, std::span<uint8_t> buffer) {
+            stream.clear();
+            stream.seekg(static_cast<std::streamoff>(offset));
+            stream.read(reinterpret_cast<char*>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+            return static_cast<size_t>(stream.gcount()) == buffer.size();
+        };
+
+        // Blocks overlap by record size, so record crossing block boundary is found
+        std::vector<uint8_t> block;
+        uint64_t blockEnd = fileSize;
+        while (stream && blockEnd >= kEndRecordSize) {
+            const uint64_t blockStart = blockEnd > kBlockSize ? blockEnd - kBlockSize : 0;
+            block.resize(static_cast<size_t>(blockEnd - blockStart));
+            if (!readAt(blockStart, block)) {
+                return std::nullopt;
+            }
+
+            for (size_t i = block.size() - kEndRecordSize + 1; i-- > 0;) {
+                const uint8_t* record = block.data() + i;
+                if (ReadLE32(record) != kEndOfCentralDirectorySignature) {
+                    continue;
+                }
+
+                const uint64_t recordOffset = blockStart + i;
+                const uint16_t entryCount = ReadLE16(record + 10);
+                const uint64_t directorySize = ReadLE32(record + 12);
+                const uint64_t directoryOffset = ReadLE32(record + 16);
+                const uint64_t archiveEnd = recordOffset + kEndRecordSize + ReadLE16(record + 20);
+                const bool isSingleDisk = ReadLE16(record + 4) == 0 && ReadLE16(record + 6) == 0 && ReadLE16(record + 8) == entryCount;
+                if (!isSingleDisk || directoryOffset + directorySize != recordOffset || archiveEnd > fileSize) {
+                    continue;
+                }
+
+                std::array<uint8_t, 4> header{};
+                if (entryCount == 0 ? directorySize == 0 : readAt(directoryOffset, header) && ReadLE32(header.data()) == kCentralHeaderSignature) {
+                    return archiveEnd;
+                }
+            }
+
+            if (blockStart == 0) {
+                break;
+            }
+            blockEnd = blockStart + kEndRecordSize - 1;
+        }
+        return std::nullopt;
+    }
+
+    static uint16_t ReadLE16(const uint8_t* p)
+    {
+        return static_cast<uint16_t>(p[0] | (p[1] << 8));
+    }
+
+    static uint32_t ReadLE32(const uint8_t* p)
+    {
+        return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) | (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+    }
+
+private:
+    std::string m_ZipPath;
+    int m_CompressionLevel;
+    std::vector<ZipEntryRecord> m_Entries;
+    ZipArchivePtr m_Archive;
+    std::atomic<uint64_t> m_Generation = 0;
+    std::atomic<bool> m_IsCompacting = false;
+    // Shared by filesystem and its file handles, synchronized by policy of filesystem
+    [[no_unique_address]] mutable typename Policy::Mutex m_Mutex;
+};
+
+} // namespace vfspp
+
+#endif // VFSPP_ZIPJOURNAL_HPP
@@ -0,0 +1,353 @@
+#ifndef VFSPP_ZIPWRITER_HPP
+#define VFSPP_ZIPWRITER_HPP
+
+#include "Global.h"
+#include "Crc32.hpp"
+#include "StdioFile.hpp"
+#include "zip_file.hpp"
+
+#include <ctime>
+
+namespace vfspp
+{
+
+/*
+ * Central directory record of archive entry
+ */
+struct ZipEntryRecord
+{
+    std::string Name;
+    uint16_t Method = 0;
+    uint16_t BitFlag = 0;
+    uint16_t DosTime = 0;
+    uint16_t DosDate = 0;
+    uint32_t Crc32 = 0;
+    uint64_t CompressedSize = 0;
+    uint64_t UncompressedSize = 0;
+    uint64_t LocalHeaderOffset = 0;
+    uint32_t ExternalAttributes = 0;
+};
+
+
+/*
+ * Low level zip writer. Writes local headers with entry data and central directory,
+ * compression is done by caller so entries can be prepared in parallel
+ */
+class ZipWriter final
+{
+public:
+    static constexpr uint16_t kMethodStored = 0;
+    static constexpr uint16_t kMethodDeflated = MZ_DEFLATED;
+
+    // Largest alignment of entry data, padding must fit 16-bit extra field length
+    static constexpr uint32_t kMaxAlignment = 32768;
+
+public:
+    ZipWriter() = default;
+
+    ~ZipWriter()
+    {
+        Close();
+    }
+
+    ZipWriter(const ZipWriter&) = delete;
+    ZipWriter& operator=(const ZipWriter&) = delete;
+
+    /*
+     * Open archive for writing. In append mode data is written after existing content
+     */
+    [[nodiscard]]
+    bool Open(const std::string& path, bool append)
+    {
+        Close();
+
+        m_File = std::fopen(path.c_str(), append ? "r+b" : "w+b");
+        if (!m_File) {
+            return false;
+        }
+
+        if (!StdioFile::Seek(m_File, 0, SEEK_END)) {
+            Close();
+            return false;
+        }
+
+        const auto position = StdioFile::Tell(m_File);
+        if (!position) {
+            Close();
+            return false;
+        }
+
+        m_Offset = *position;
+        return true;
+    }
+
+    /*
+     * Cut archive at path to size, used to drop partially appended data
+     */
+    static bool Truncate(const std::string& path, uint64_t size)
+    {
+        std::FILE* file = std::fopen(path.c_str(), "r+b");
+        if (!file) {
+            return false;
+        }
+
+        const bool isTruncated = StdioFile::Truncate(file, size);
+        return std::fclose(file) == 0 && isTruncated;
+    }
+
+    /*
+     * Close archive, returns false if buffered data couldn't be written
+     */
+    bool Close()
+    {
+        bool isClosed = true;
+        if (m_File) {
+            isClosed = std::fclose(m_File) == 0;
+            m_File = nullptr;
+        }
+        m_Offset = 0;
+        return isClosed;
+    }
+
+    [[nodiscard]]
+    bool IsOpened() const
+    {
+        return m_File != nullptr;
+    }
+
+    /*
+     * Current write offset, it's equal to archive size
+     */
+    [[nodiscard]]
+    uint64_t Offset() const
+    {
+        return m_Offset;
+    }
+
+    /*
+     * Append entry with already compressed data. Alignment pads local header so entry
+     * data starts at offset multiple of alignment, useful for stored entries read in-place.
+     * Padding is stored in extra field, so alignment can't exceed kMaxAlignment
+     */
+    [[nodiscard]]
+    std::optional<ZipEntryRecord> AddEntry(std::string_view name, std::span<const uint8_t> data, uint16_t method, uint32_t crc32, uint64_t uncompressedSize, std::time_t modifiedTime, uint32_t alignment = 0)
+    {
+        if (!m_File || name.empty() || name.size() > 0xFFFF || alignment > kMaxAlignment) {
+            return std::nullopt;
+        }
+
+        // Zip64 is not supported
+        if (data.size_bytes() > 0xFFFFFFFFu || uncompressedSize > 0xFFFFFFFFu || m_Offset > 0xFFFFFFFFu) {
+            return std::nullopt;
+        }
+
+        ZipEntryRecord record;
+        record.Name = std::string(name);
+        record.Method = method;
+        record.Crc32 = crc32;
+        record.CompressedSize = data.size_bytes();
+        record.UncompressedSize = uncompressedSize;
+        record.LocalHeaderOffset = m_Offset;
+        ToDosDateTime(modifiedTime, record.DosTime, record.DosDate);
+
+        const uint64_t dataOffset = m_Offset + kLocalHeaderSize + name.size();
+        const uint32_t paddingSize = AlignmentPadding(dataOffset, alignment);
+
+        std::vector<uint8_t> header;
+        header.reserve(kLocalHeaderSize + name.size() + paddingSize);
+        PutLE32(header, kLocalHeaderSignature);
+        PutLE16(header, kVersionNeeded);
+        PutLE16(header, record.BitFlag);
+        PutLE16(header, record.Method);
+        PutLE16(header, record.DosTime);
+        PutLE16(header, record.DosDate);
+        PutLE32(header, record.Crc32);
+        PutLE32(header, static_cast<uint32_t>(record.CompressedSize));
+        PutLE32(header, static_cast<uint32_t>(record.UncompressedSize));
+        PutLE16(header, static_cast<uint16_t>(name.size()));
+        PutLE16(header, static_cast<uint16_t>(paddingSize));
+        header.insert(header.end(), name.begin(), name.end());
+        if (paddingSize > 0) {
+            PutLE16(header, kAlignmentExtraID);
+            PutLE16(header, static_cast<uint16_t>(paddingSize - 4));
+            header.resize(header.size() + paddingSize - 4, 0);
+        }
+
+        if (!WriteRaw(header) || !WriteRaw(data)) {
+            return std::nullopt;
+        }
+
+        return record;
+    }
+
+    /*
+     * Append central directory and end of central directory record
+     */
+    [[nodiscard]]
+    bool WriteCentralDirectory(std::span<const ZipEntryRecord> entries)
+    {
+        if (!m_File || entries.size() > 0xFFFF) {
+            return false;
+        }
+
+        const uint64_t directoryOffset = m_Offset;
+        if (directoryOffset > 0xFFFFFFFFu) {
+            return false;
+        }
+
+        std::vector<uint8_t> directory;
+        for (const auto& entry : entries) {
+            if (entry.LocalHeaderOffset > 0xFFFFFFFFu) {
+                return false;
+            }
+
+            PutLE32(directory, kCentralHeaderSignature);
+            PutLE16(directory, kVersionMadeBy);
+            PutLE16(directory, kVersionNeeded);
+            PutLE16(directory, entry.BitFlag);
+            PutLE16(directory, entry.Method);
+            PutLE16(directory, entry.DosTime);
+            PutLE16(directory, entry.DosDate);
+            PutLE32(directory, entry.Crc32);
+            PutLE32(directory, static_cast<uint32_t>(entry.CompressedSize));
+            PutLE32(directory, static_cast<uint32_t>(entry.UncompressedSize));
+            PutLE16(directory, static_cast<uint16_t>(entry.Name.size()));
+            PutLE16(directory, 0); // extra field length
+            PutLE16(directory, 0); // comment length
+            PutLE16(directory, 0); // disk number
+            PutLE16(directory, 0); // internal attributes
+            PutLE32(directory, entry.ExternalAttributes);
+            PutLE32(directory, static_cast<uint32_t>(entry.LocalHeaderOffset));
+            directory.insert(directory.end(), entry.Name.begin(), entry.Name.end());
+        }
+
+        const uint64_t directorySize = directory.size();
+        if (directorySize > 0xFFFFFFFFu) {
+            return false;
+        }
+
+        PutLE32(directory, kEndOfCentralDirectorySignature);
+        PutLE16(directory, 0); // disk number
+        PutLE16(directory, 0); // disk with central directory
+        PutLE16(directory, static_cast<uint16_t>(entries.size()));
+        PutLE16(directory, static_cast<uint16_t>(entries.size()));
+        PutLE32(directory, static_cast<uint32_t>(directorySize));
+        PutLE32(directory, static_cast<uint32_t>(directoryOffset));
+        PutLE16(directory, 0); // comment length
+
+        return WriteRaw(directory) && std::fflush(m_File) == 0;
+    }
+
+    /*
+     * Compress data with raw deflate, returns false if data should be stored
+     */
+    [[nodiscard]]
+    static bool Deflate(std::span<const uint8_t> data, int level, std::vector<uint8_t>& outData)
+    {
+        if (data.empty() || level <= 0) {
+            return false;
+        }
+
+        const mz_uint flags = tdefl_create_comp_flags_from_zip_params(level, -MZ_DEFAULT_WINDOW_BITS, MZ_DEFAULT_STRATEGY);
+
+        size_t compressedSize = 0;
+        void* compressed = tdefl_compress_mem_to_heap(data.data(), data.size_bytes(), &compressedSize, static_cast<int>(flags));
+        if (!compressed) {
+            return false;
+        }
+
+        // Keep entry stored if compression doesn't pay off
+        const bool isSmaller = compressedSize < data.size_bytes();
+        if (isSmaller) {
+            outData.assign(static_cast<const uint8_t*>(compressed), static_cast<const uint8_t*>(compressed) + compressedSize);
+        }
+        mz_free(compressed);
+
+        return isSmaller;
+    }
+
+    /*
+     * Calculate CRC32 of data
+     */
+    [[nodiscard]]
+    static uint32_t Crc32(std::span<const uint8_t> data)
+    {
+        return vfspp::Crc32::Compute(data);
+    }
+
+private:
+    static constexpr uint32_t kLocalHeaderSignature = 0x04034b50;
+    static constexpr uint32_t kCentralHeaderSignature = 0x02014b50;
+    static constexpr uint32_t kEndOfCentralDirectorySignature = 0x06054b50;
+    static constexpr uint16_t kVersionMadeBy = 20;
+    static constexpr uint16_t kVersionNeeded = 20;
+    static constexpr uint16_t kAlignmentExtraID = 0xD935;
+    static constexpr size_t kLocalHeaderSize = 30;
+
+    bool WriteRaw(std::span<const uint8_t> data)
+    {
+        if (data.empty()) {
+            return true;
+        }
+
+        if (std::fwrite(data.data(), 1, data.size_bytes(), m_File) != data.size_bytes()) {
+            return false;
+        }
+
+        m_Offset += data.size_bytes();
+        return true;
+    }
+
+    // Padding is less than alignment + 4, so it fits extra field for supported alignments
+    static uint32_t AlignmentPadding(uint64_t dataOffset, uint32_t alignment)
+    {
+        if (alignment <= 1) {
+            return 0;
+        }
+
+        // Extra field needs at least 4 bytes for its header
+        uint64_t padding = (alignment - dataOffset % alignment) % alignment;
+        while (padding != 0 && padding < 4) {
+            padding += alignment;
+        }
+        return static_cast<uint32_t>(padding);
+    }
+
+    static void ToDosDateTime(std::time_t time, uint16_t& dosTime, uint16_t& dosDate)
+    {
+        std::tm tm{};
+#if defined(_WIN32)
+        localtime_s(&tm, &time);
+#else
+        localtime_r(&time, &tm);
+#endif
+        if (tm.tm_year < 80) {
+            dosTime = 0;
+            dosDate = static_cast<uint16_t>((1 << 5) | 1); // 1980-01-01
+            return;
+        }
+
+        dosTime = static_cast<uint16_t>((tm.tm_hour << 11) | (tm.tm_min << 5) | (tm.tm_sec >> 1));
+        dosDate = static_cast<uint16_t>(((tm.tm_year - 80) << 9) | ((tm.tm_mon + 1) << 5) | tm.tm_mday);
+    }
+
+    static void PutLE16(std::vector<uint8_t>& out, uint16_t value)
+    {
+        out.push_back(static_cast<uint8_t>(value & 0xFF));
+        out.push_back(static_cast<uint8_t>((value >> 8) & 0xFF));
+    }
+
+    static void PutLE32(std::vector<uint8_t>& out, uint32_t value)
+    {
+        PutLE16(out, static_cast<uint16_t>(value & 0xFFFF));
+        PutLE16(out, static_cast<uint16_t>((value >> 16) & 0xFFFF));
+    }
+
+private:
+    std::FILE* m_File = nullptr;
+    uint64_t m_Offset = 0;
+};
+
+} // namespace vfspp
+
+#endif // VFSPP_ZIPWRITER_HPP
@@ -0,0 +1,375 @@
+#ifndef VFSPP_ZSTDBLOB_HPP
+#define VFSPP_ZSTDBLOB_HPP
+
+#include "Global.h"
+#include "ThreadingPolicy.hpp"
+#include "FileBuffer.hpp"
+#include "NativeBlob.hpp"
+
+// Zstd support needs libzstd, define VFSPP_ZSTD_SUPPORT_ENABLED and link zstd to enable it
+#if defined(VFSPP_ZSTD_SUPPORT_ENABLED)
+#include <zstd.h>
+
+namespace vfspp
+{
+
+template<typename Policy>
+class BasicZstdBlob;
+
+using ZstdBlob = BasicZstdBlob<ThreadingPolicy>;
+using ZstdBlobPtr = std::shared_ptr<ZstdBlob>;
+using ZstdBlobWeakPtr = std::weak_ptr<ZstdBlob>;
+
+
+/*
+ * Decompressed content of zstd compressed native blob. Blob in seekable zstd format,
+ * independently compressed frames followed by seek table, is decompressed by frames on
+ * demand and recently used frames are cached. Blob without seek table is decompressed to
+ * memory on open. Reads are synchronized by Policy
+ */
+template<typename Policy>
+class BasicZstdBlob final
+{
+public:
+    static constexpr uint32_t kSkippableFrameMagic = 0x184D2A5E;
+    static constexpr uint32_t kSeekTableMagic = 0x8F92EAB1;
+
+public:
+    BasicZstdBlob() = default;
+
+    BasicZstdBlob(const BasicZstdBlob&) = delete;
+    BasicZstdBlob& operator=(const BasicZstdBlob&) = delete;
+
+    /*
+     * Open compressed blob, most recently used frame is kept even if it exceeds cache capacity
+     */
+    [[nodiscard]]
+    bool Open(NativeBlobPtr compressed, uint64_t cacheCapacity)
+    {
+        m_Compressed = std::move(compressed);
+        m_CacheCapacity = cacheCapacity;
+        if (!m_Compressed) {
+            return false;
+        }
+
+        if (ReadSeekTable()) {
+            return true;
+        }
+        m_Frames.clear();
+        return DecompressAll();
+    }
+
+    [[nodiscard]]
+    uint64_t Size() const
+    {
+        return m_Size;
+    }
+
+    [[nodiscard]]
+    std::time_t ModifiedTime() const
+    {
+        return m_Compressed ? m_Compressed->ModifiedTime() : 0;
+    }
+
+    /*
+     * Check if blob has seek table, otherwise whole content is in memory
+     */
+    [[nodiscard]]
+    bool IsSeekable() const
+    {
+        return !m_Data;
+    }
+
+    /*
+     * Get whole decompressed content if blob has no seek table, otherwise empty span
+     */
+    [[nodiscard]]
+    std::span<const uint8_t> Memory() const
+    {
+        return m_Data ? std::span<const uint8_t>(*m_Data) : std::span<const uint8_t>();
+    }
+
+    /*
+     * Read decompressed data from absolute offset, returns number of bytes read
+     */
+    uint64_t ReadAt(uint64_t offset, std::span<uint8_t> buffer) const
+    {
+        if (offset >= m_Size || buffer.empty()) {
+            return 0;
+        }
+        const auto size = static_cast<size_t>(std::min<uint64_t>(buffer.size(), m_Size - offset));
+
+        if (m_Data) {
+            std::memcpy(buffer.data(), m_Data->data() + offset, size);
+            return size;
+        }
+
+        size_t total = 0;
+        while (total < size) {
+            const uint64_t position = offset + total;
+            const size_t index = FindFrame(position);
+            const auto frame = ReadFrame(index);
+            if (!frame) {
+                break;
+            }
+
+            const auto frameOffset = static_cast<size_t>(position - m_Frames[index].DecompressedOffset);
+            const size_t count = std::min(size - total, frame->size() - frameOffset);
+            std::memcpy(buffer.data() + total, frame->data() + frameOffset, count);
+            total += count;
+        }
+        return total;
+    }
+
+    /*
+     * Get range referencing decompressed data without copying, returns nothing if range
+     * spans several frames or frame is damaged
+     */
+    [[nodiscard]]
+    std::optional<FileBuffer> Reference(uint64_t offset, uint64_t size) const
+    {
+        if (offset > m_Size || size > m_Size - offset) {
+            return std::nullopt;
+        }
+
+        if (m_Data) {
+            return FileBuffer(m_Data, std::span<const uint8_t>(*m_Data).subspan(static_cast<size_t>(offset), static_cast<size_t>(size)));
+        }
+        if (size == 0) {
+            return FileBuffer();
+        }
+
+        const size_t index = FindFrame(offset);
+        const Frame& frame = m_Frames[index];
+        if (offset + size > frame.DecompressedOffset + frame.DecompressedSize) {
+            return std::nullopt;
+        }
+
+        auto data = ReadFrame(index);
+        if (!data) {
+            return std::nullopt;
+        }
+        const auto span = std::span<const uint8_t>(*data).subspan(static_cast<size_t>(offset - frame.DecompressedOffset), static_cast<size_t>(size));
+        return FileBuffer(std::move(data), span);
+    }
+
+private:
+    using FrameData = std::shared_ptr<const std::vector<uint8_t>>;
+
+    struct Frame
+    {
+        uint64_t CompressedOffset;
+        uint32_t CompressedSize;
+        uint64_t DecompressedOffset;
+        uint32_t DecompressedSize;
+    };
+
+    struct CacheEntry
+    {
+        FrameData Data;
+        std::list<size_t>::iterator Recent;
+    };
+
+    static uint32_t ReadLE32(const uint8_t* data)
+    {
+        return static_cast<uint32_t>(data[0]) | (static_cast<uint32_t>(data[1]) << 8) |
+            (static_cast<uint32_t>(data[2]) << 16) | (static_cast<uint32_t>(data[3]) << 24);
+    }
+
+    // Seek table is skippable frame at the end of blob: frame header, entry per frame
+    // with compressed and decompressed sizes and optional checksum, then footer with
+    // frame count, descriptor and seek table magic
+    bool ReadSeekTable()
+    {
+        constexpr uint64_t kFrameHeaderSize = 8;
+        constexpr uint64_t kFooterSize = 9;
+
+        const uint64_t blobSize = m_Compressed->Size();
+        if (blobSize < kFrameHeaderSize + kFooterSize) {
+            return false;
+        }
+
+        std::array<uint8_t, kFooterSize> footer;
+        if (m_Compressed->ReadAt(blobSize - kFooterSize, footer) != kFooterSize || ReadLE32(footer.data() + 5) != kSeekTableMagic) {
+            return false;
+        }
+
+        const uint64_t frameCount = ReadLE32(footer.data());
+        const uint8_t descriptor = footer[4];
+        if ((descriptor & 0x7C) != 0) {
+            return false; // Reserved bits
+        }
+
+        const uint64_t entrySize = (descriptor & 0x80) ? 12 : 8;
+        const uint64_t tableSize = frameCount * entrySize + kFooterSize;
+        if (tableSize + kFrameHeaderSize > blobSize) {
+            return false;
+        }
+
+        const uint64_t tableOffset = blobSize - tableSize - kFrameHeaderSize;
+        std::vector<uint8_t> table(static_cast<size_t>(kFrameHeaderSize + frameCount * entrySize));
+        if (m_Compressed->ReadAt(tableOffset, table) != table.size() ||
+            ReadLE32(table.data()) != kSkippableFrameMagic || ReadLE32(table.data() + 4) != tableSize) {
+            return false;
+        }
+
+        uint64_t compressedOffset = 0;
+        uint64_t decompressedOffset = 0;
+        m_Frames.reserve(static_cast<size_t>(frameCount));
+        for (uint64_t i = 0; i < frameCount; ++i) {
+            const uint8_t* entry = table.data() + kFrameHeaderSize + i * entrySize;
+            const Frame frame{ compressedOffset, ReadLE32(entry), decompressedOffset, ReadLE32(entry + 4) };
+            compressedOffset += frame.CompressedSize;
+            decompressedOffset += frame.DecompressedSize;
+
+            // Empty frames have no data to look up
+            if (frame.DecompressedSize > 0) {
+                m_Frames.push_back(frame);
+            }
+        }
+
+        if (compressedOffset != tableOffset) {
+            return false;
+        }
+        m_Size = decompressedOffset;
+        return true;
+    }
+
+    bool DecompressAll()
+    {
+        std::vector<uint8_t> storage;
+        const auto source = CompressedRange(0, m_Compressed->Size(), storage);
+        if (source.empty()) {
+            return false;
+        }
+
+        std::unique_ptr<ZSTD_DStream, decltype(&ZSTD_freeDStream)> stream(ZSTD_createDStream(), &ZSTD_freeDStream);
+        if (!stream) {
+            return false;
+        }
+
+        auto data = std::make_shared<std::vector<uint8_t>>();
+        size_t produced = 0;
+        size_t result = 0;
+        ZSTD_inBuffer input{ source.data(), source.size(), 0 };
+        for (;;) {
+            if (data->size() - produced < ZSTD_DStreamOutSize()) {
+                data->resize(std::max(data->size() * 2, produced + ZSTD_DStreamOutSize()));
+            }
+
+            ZSTD_outBuffer output{ data->data() + produced, data->size() - produced, 0 };
+            result = ZSTD_decompressStream(stream.get(), &output, &input);
+            if (ZSTD_isError(result)) {
+                return false;
+            }
+            produced += output.pos;
+
+            // Decoder has flushed everything when it consumed input without filling output
+            if (input.pos == input.size && output.pos < output.size) {
+                break;
+            }
+        }
+
+        // Unfinished frame means truncated blob
+        if (result != 0) {
+            return false;
+        }
+
+        data->resize(produced);
+        data->shrink_to_fit();
+        m_Size = produced;
+        m_Data = std::move(data);
+        return true;
+    }
+
+    // Get compressed bytes, mapped memory is referenced, otherwise bytes are read to storage
+    std::span<const uint8_t> CompressedRange(uint64_t offset, uint64_t size, std::vector<uint8_t>& storage) const
+    {
+        const auto memory = m_Compressed->Memory();
+        if (!memory.empty()) {
+            return memory.subspan(static_cast<size_t>(offset), static_cast<size_t>(size));
+        }
+
+        storage.resize(static_cast<size_t>(size));
+        if (m_Compressed->ReadAt(offset, storage) != size) {
+            return {};
+        }
+        return storage;
+    }
+
+    size_t FindFrame(uint64_t offset) const
+    {
+        const auto it = std::upper_bound(m_Frames.begin(), m_Frames.end(), offset, [](uint64_t value, const Frame& frame) {
+            return value < frame.DecompressedOffset;
+        });
+        return static_cast<size_t>(std::distance(m_Frames.begin(), it)) - 1;
+    }
+
+    FrameData ReadFrame(size_t index) const
+    {
+        {
+            [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
+            const auto it = m_Cache.find(index);
+            if (it != m_Cache.end()) {
+                m_RecentFrames.splice(m_RecentFrames.begin(), m_RecentFrames, it->second.Recent);
+                return it->second.Data;
+            }
+        }
+
+        // Frame decompressed by two readers at same time is cached once
+        const Frame& frame = m_Frames[index];
+        std::vector<uint8_t> storage;
+        const auto source = CompressedRange(frame.CompressedOffset, frame.CompressedSize, storage);
+        if (source.empty()) {
+            return nullptr;
+        }
+
+        // Damaged seek table can't make frame buffer larger than frame header declares
+        const unsigned long long contentSize = ZSTD_getFrameContentSize(source.data(), source.size());
+        if (contentSize == ZSTD_CONTENTSIZE_ERROR || (contentSize != ZSTD_CONTENTSIZE_UNKNOWN && contentSize != frame.DecompressedSize)) {
+            return nullptr;
+        }
+
+        auto data = std::make_shared<std::vector<uint8_t>>(frame.DecompressedSize);
+        const size_t result = ZSTD_decompress(data->data(), data->size(), source.data(), source.size());
+        if (ZSTD_isError(result) || result != frame.DecompressedSize) {
+            return nullptr;
+        }
+
+        [[maybe_unused]] auto lock = Policy::Lock(m_Mutex);
+        if (m_Cache.find(index) == m_Cache.end()) {
+            m_RecentFrames.push_front(index);
+            m_Cache.emplace(index, CacheEntry{ data, m_RecentFrames.begin() });
+            m_CachedSize += frame.DecompressedSize;
+            EvictImpl();
+        }
+        return data;
+    }
+
+    void EvictImpl() const
+    {
+        while (m_CachedSize > m_CacheCapacity && m_RecentFrames.size() > 1) {
+            const size_t index = m_RecentFrames.back();
+            m_RecentFrames.pop_back();
+            m_Cache.erase(index);
+            m_CachedSize -= m_Frames[index].DecompressedSize;
+        }
+    }
+
+private:
+    NativeBlobPtr m_Compressed;
+    uint64_t m_Size = 0;
+    std::vector<Frame> m_Frames; // Non-empty frames ordered by offset
+    FrameData m_Data; // Whole content of blob without seek table
+    uint64_t m_CacheCapacity = 0;
+    mutable uint64_t m_CachedSize = 0;
+    mutable std::list<size_t> m_RecentFrames; // Most recently used first
+    mutable std::unordered_map<size_t, CacheEntry> m_Cache;
+    [[no_unique_address]] mutable typename Policy::Mutex m_Mutex;
+};
+
+} // namespace vfspp
+
+#endif // VFSPP_ZSTD_SUPPORT_ENABLED
+
+#endif // VFSPP_ZSTDBLOB_HPP
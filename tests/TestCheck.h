@@ -0,0 +1,16 @@
+#ifndef VFSPP_TESTCHECK_H
+#define VFSPP_TESTCHECK_H
+
+#include <cstdio>
+#include <cstdlib>
+
+// Check stays enabled in release builds, unlike assert
+#define VFSPP_CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            std::fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            std::exit(1); \
+        } \
+    } while (false)
+
+#endif // VFSPP_TESTCHECK_H
@@ -0,0 +1,85 @@
+#include "vfspp/VFS.h"
+#include "TestCheck.h"
+
+using namespace vfspp;
+
+namespace
+{
+
+void AddFiles(IFileSystem& filesystem, std::initializer_list<const char*> paths)
+{
+    for (const char* path : paths) {
+        IFilePtr file = filesystem.CreateFile(path);
+        VFSPP_CHECK(file && filesystem.CloseFile(file));
+    }
+}
+
+void TestListAndFind()
+{
+    VirtualFileSystem vfs;
+    vfs.SetCaseSensitive(false);
+
+    auto mounted = vfs.CreateFileSystem<MemoryFileSystem>("/Data/");
+    VFSPP_CHECK(mounted);
+    AddFiles(**mounted, { "/Data/Textures/a.png", "/Data/Textures/B.PNG", "/Data/Textures/c.txt", "/Data/Sub/Deep/x.png" });
+
+    // Listings report stored case whatever case was requested
+    const auto listed = vfs.ListDirectory("/data/textures/");
+    VFSPP_CHECK(listed.size() == 3);
+    VFSPP_CHECK(listed[0] == "/Data/Textures/a.png");
+    VFSPP_CHECK(listed[1] == "/Data/Textures/B.PNG");
+    VFSPP_CHECK(vfs.ListDirectory("/DATA/", true).size() == 7);
+
+    VFSPP_CHECK(vfs.Find("/DATA/Textures/*.PNG").size() == 2);
+    VFSPP_CHECK(vfs.Find("/data/T*/?.png").size() == 2);
+    VFSPP_CHECK(vfs.Find("/data/**/*.png").size() == 3);
+    VFSPP_CHECK(vfs.Find("/data/**/*").size() == 4);
+
+    const auto found = vfs.Find("/data/textures/A.PNG");
+    VFSPP_CHECK(found.size() == 1 && found[0] == "/Data/Textures/a.png");
+
+    // Patterns are normalized like paths
+    VFSPP_CHECK(vfs.Find("\\data\\textures\\*.png").size() == 2);
+    VFSPP_CHECK(vfs.Find("/data/./sub/../textures/*.png").size() == 2);
+
+    VFSPP_CHECK(vfs.SetCaseSensitive(true));
+    VFSPP_CHECK(vfs.ListDirectory("/data/textures/").empty());
+    VFSPP_CHECK(vfs.Find("/DATA/Textures/*.PNG").empty());
+    VFSPP_CHECK(vfs.Find("/Data/Textures/*.PNG").size() == 1);
+}
+
+void TestSwitchWithCollisions()
+{
+    MemoryFileSystem filesystem("/");
+    VFSPP_CHECK(filesystem.Initialize());
+    AddFiles(filesystem, { "/Tex/A.dds", "/tex/a.dds", "/tex/b.dds" });
+
+    // Index stays case sensitive and keeps all files
+    VFSPP_CHECK(!filesystem.SetCaseSensitive(false));
+    VFSPP_CHECK(filesystem.IsCaseSensitive());
+    VFSPP_CHECK(filesystem.IsFileExists("/Tex/A.dds") && filesystem.IsFileExists("/tex/a.dds"));
+    VFSPP_CHECK(filesystem.ListDirectory("/", true).size() == 5);
+
+    FileIndex<int> index;
+    index.emplace("/a/B", 1);
+    index.emplace("/a/b", 2);
+    index.emplace("/A/b", 3);
+    std::vector<std::string> collisions;
+    VFSPP_CHECK(!index.SetCaseSensitive(false, &collisions));
+    VFSPP_CHECK(collisions.size() == 2 && index.size() == 3);
+
+    index.erase("/a/b");
+    index.erase("/A/b");
+    VFSPP_CHECK(index.SetCaseSensitive(false));
+    VFSPP_CHECK(index.find("/A/B") != index.end());
+    VFSPP_CHECK(index.ListDirectory("/A/", false).size() == 1);
+}
+
+} // namespace
+
+int main()
+{
+    TestListAndFind();
+    TestSwitchWithCollisions();
+    return 0;
+}
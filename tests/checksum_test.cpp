@@ -0,0 +1,116 @@
+#include "vfspp/VFS.h"
+#include "TestCheck.h"
+
+#include <random>
+
+using namespace vfspp;
+
+namespace
+{
+
+// Bitwise reference of reflected CRC-32
+uint32_t ReferenceCrc32(std::span<const uint8_t> data)
+{
+    uint32_t crc = 0xFFFFFFFFu;
+    for (const uint8_t byte : data) {
+        crc ^= byte;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+        }
+    }
+    return ~crc;
+}
+
+std::span<const uint8_t> Bytes(std::string_view text)
+{
+    return { reinterpret_cast<const uint8_t*>(text.data()), text.size() };
+}
+
+void TestKnownAnswers()
+{
+    VFSPP_CHECK(Crc32::Compute({}) == 0);
+    VFSPP_CHECK(Crc32::Compute(Bytes("a")) == 0xE8B7BE43u);
+    VFSPP_CHECK(Crc32::Compute(Bytes("123456789")) == 0xCBF43926u);
+    VFSPP_CHECK(Crc32::Compute(Bytes("The quick brown fox jumps over the lazy dog")) == 0x414FA339u);
+
+    const std::vector<uint8_t> zeros(4096, 0);
+    VFSPP_CHECK(Crc32::Compute(std::span<const uint8_t>(zeros).first(32)) == 0x190A55ADu);
+    VFSPP_CHECK(Crc32::Compute(zeros) == ReferenceCrc32(zeros));
+}
+
+// Lengths and offsets cover table path, folded path and its unaligned tails
+void TestAgainstReference()
+{
+    std::mt19937 random(42);
+    std::vector<uint8_t> data(8192 + 16);
+    for (auto& byte : data) {
+        byte = static_cast<uint8_t>(random());
+    }
+
+    for (size_t offset = 0; offset < 16; offset++) {
+        for (size_t size : { 0, 1, 7, 15, 16, 63, 64, 65, 127, 128, 129, 255, 1000, 4096, 8191 }) {
+            const auto span = std::span<const uint8_t>(data).subspan(offset, size);
+            VFSPP_CHECK(Crc32::Compute(span) == ReferenceCrc32(span));
+        }
+    }
+
+    // Checksum continued over split data matches single pass
+    const auto all = std::span<const uint8_t>(data).first(8192);
+    for (size_t split : { 1, 63, 64, 100, 4095, 8000 }) {
+        const uint32_t crc = Crc32::Update(Crc32::Compute(all.first(split)), all.subspan(split));
+        VFSPP_CHECK(crc == Crc32::Compute(all));
+    }
+}
+
+void TestCorruptedEntry()
+{
+    // Tests run in build directory
+    const std::string zipPath = "vfspp_checksum_test.zip";
+    const auto content = Bytes("entry content checked while reading");
+    {
+        ZipWriter writer;
+        VFSPP_CHECK(writer.Open(zipPath, false));
+
+        std::vector<ZipEntryRecord> entries;
+        auto valid = writer.AddEntry("valid.bin", content, ZipWriter::kMethodStored, Crc32::Compute(content), content.size(), 0);
+        auto corrupted = writer.AddEntry("corrupted.bin", content, ZipWriter::kMethodStored, Crc32::Compute(content) ^ 1u, content.size(), 0);
+        VFSPP_CHECK(valid && corrupted);
+        entries.push_back(*valid);
+        entries.push_back(*corrupted);
+        VFSPP_CHECK(writer.WriteCentralDirectory(entries) && writer.Close());
+    }
+
+    ZipFileSystem filesystem("/", zipPath);
+    VFSPP_CHECK(filesystem.Initialize());
+
+    const auto mode = IFile::FileMode::Read | IFile::FileMode::VerifyChecksum;
+    std::vector<uint8_t> data;
+
+    IFilePtr valid = filesystem.OpenFile("/valid.bin", mode);
+    VFSPP_CHECK(valid && valid->Read(data, valid->Size()) == content.size());
+    VFSPP_CHECK(!valid->IsCorrupted());
+    VFSPP_CHECK(valid->Read(data, 1) == 0 && !valid->IsCorrupted());
+
+    IFilePtr corrupted = filesystem.OpenFile("/corrupted.bin", mode);
+    VFSPP_CHECK(corrupted && corrupted->Read(data, corrupted->Size()) == 0);
+    VFSPP_CHECK(corrupted->IsCorrupted());
+
+    // Reopened file starts verification again, unverified reads still succeed
+    VFSPP_CHECK(filesystem.CloseFile(corrupted));
+    corrupted = filesystem.OpenFile("/corrupted.bin", IFile::FileMode::Read);
+    VFSPP_CHECK(corrupted && corrupted->Read(data, corrupted->Size()) == content.size());
+    VFSPP_CHECK(!corrupted->IsCorrupted());
+
+    filesystem.Shutdown();
+    fs::remove(zipPath);
+}
+
+} // namespace
+
+int main()
+{
+    TestKnownAnswers();
+    TestAgainstReference();
+    TestCorruptedEntry();
+    return 0;
+}
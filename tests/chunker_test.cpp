@@ -0,0 +1,130 @@
+#include "vfspp/VFS.h"
+#include "vfspp/ContentDefinedChunker.hpp"
+#include "TestCheck.h"
+
+#include <random>
+
+using namespace vfspp;
+
+namespace
+{
+
+ChunkerOptions SmallChunks()
+{
+    ChunkerOptions options;
+    options.MinSize = 2 * 1024;
+    options.AverageSize = 8 * 1024;
+    options.MaxSize = 32 * 1024;
+    return options;
+}
+
+std::vector<uint8_t> RandomData(size_t size, uint32_t seed)
+{
+    std::mt19937 random(seed);
+    std::vector<uint8_t> data(size);
+    for (uint8_t& byte : data) {
+        byte = static_cast<uint8_t>(random());
+    }
+    return data;
+}
+
+// End offsets of chunks
+std::vector<size_t> Cuts(const ContentDefinedChunker& chunker, std::span<const uint8_t> data)
+{
+    std::vector<size_t> cuts;
+    size_t offset = 0;
+    for (const auto& chunk : chunker.Split(data)) {
+        offset += chunk.size();
+        cuts.push_back(offset);
+    }
+    return cuts;
+}
+
+size_t CountShared(const std::vector<size_t>& first, const std::vector<size_t>& second, ptrdiff_t shift, size_t from)
+{
+    size_t shared = 0;
+    for (const size_t cut : first) {
+        if (cut > from && std::binary_search(second.begin(), second.end(), static_cast<size_t>(static_cast<ptrdiff_t>(cut) + shift))) {
+            shared++;
+        }
+    }
+    return shared;
+}
+
+void TestKnownCuts()
+{
+    // Cut points are part of store format, chunks of existing stores must stay reusable
+    const auto data = RandomData(1024 * 1024, 73);
+    const auto cuts = Cuts(ContentDefinedChunker(SmallChunks()), data);
+    const std::vector<size_t> expected = { 8660, 16910, 23882, 32158, 42314, 53504, 60627, 72674 };
+    VFSPP_CHECK(cuts.size() == 113);
+    VFSPP_CHECK(std::equal(expected.begin(), expected.end(), cuts.begin()));
+
+    const auto defaultCuts = Cuts(ContentDefinedChunker(), data);
+    VFSPP_CHECK(defaultCuts.size() == 14 && defaultCuts.front() == 23882);
+}
+
+void TestChunkSizes()
+{
+    const ChunkerOptions options = SmallChunks();
+    const ContentDefinedChunker chunker(options);
+    for (const size_t size : { size_t(0), size_t(1), size_t(2048), size_t(2049), size_t(100000), size_t(1024 * 1024) }) {
+        const auto data = RandomData(size, static_cast<uint32_t>(size));
+        const auto chunks = chunker.Split(data);
+
+        size_t total = 0;
+        for (size_t i = 0; i < chunks.size(); i++) {
+            VFSPP_CHECK(chunks[i].data() == data.data() + total);
+            VFSPP_CHECK(chunks[i].size() <= options.MaxSize);
+            VFSPP_CHECK(i + 1 == chunks.size() || chunks[i].size() > options.MinSize);
+            total += chunks[i].size();
+        }
+        VFSPP_CHECK(total == size);
+    }
+
+    // Data without any cut point is split at maximum size
+    const std::vector<uint8_t> zeros(100000, 0);
+    const auto cuts = Cuts(chunker, zeros);
+    VFSPP_CHECK(cuts.size() == 4 && cuts[0] == options.MaxSize && cuts[2] == 3 * options.MaxSize);
+}
+
+void TestEditStability()
+{
+    const ContentDefinedChunker chunker(SmallChunks());
+    const auto data = RandomData(1024 * 1024, 173);
+    const auto cuts = Cuts(chunker, data);
+    const size_t editOffset = data.size() / 2;
+    const auto insert = RandomData(100, 7);
+
+    // Insertion shifts cuts after it, cuts before it don't change
+    std::vector<uint8_t> inserted = data;
+    inserted.insert(inserted.begin() + static_cast<ptrdiff_t>(editOffset), insert.begin(), insert.end());
+    const auto insertedCuts = Cuts(chunker, inserted);
+    const size_t before = static_cast<size_t>(std::lower_bound(cuts.begin(), cuts.end(), editOffset) - cuts.begin());
+    VFSPP_CHECK(std::equal(cuts.begin(), cuts.begin() + static_cast<ptrdiff_t>(before), insertedCuts.begin()));
+
+    // Boundaries resynchronize within few chunks after edit
+    const size_t after = cuts.size() - before;
+    VFSPP_CHECK(CountShared(cuts, insertedCuts, 100, editOffset) + 3 >= after);
+
+    // Same for removed range and for prepended byte
+    std::vector<uint8_t> removed = data;
+    removed.erase(removed.begin() + static_cast<ptrdiff_t>(editOffset), removed.begin() + static_cast<ptrdiff_t>(editOffset + 100));
+    const auto removedCuts = Cuts(chunker, removed);
+    VFSPP_CHECK(std::equal(cuts.begin(), cuts.begin() + static_cast<ptrdiff_t>(before), removedCuts.begin()));
+    VFSPP_CHECK(CountShared(cuts, removedCuts, -100, editOffset + 100) + 3 >= after);
+
+    std::vector<uint8_t> prepended = data;
+    prepended.insert(prepended.begin(), uint8_t(0x5A));
+    VFSPP_CHECK(CountShared(cuts, Cuts(chunker, prepended), 1, 0) + 3 >= cuts.size());
+}
+
+} // namespace
+
+int main()
+{
+    TestKnownCuts();
+    TestChunkSizes();
+    TestEditStability();
+    return 0;
+}
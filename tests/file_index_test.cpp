@@ -0,0 +1,43 @@
+#include "vfspp/VFS.h"
+#include "TestCheck.h"
+
+using namespace vfspp;
+
+namespace
+{
+
+std::vector<std::string> Find(const FileIndex<int>& index, std::string_view pattern)
+{
+    return index.Find(GlobPattern(pattern));
+}
+
+void TestExtensionQueries()
+{
+    FileIndex<int> index;
+    for (const char* path : { "/cfg/.cfg", "/cfg/a.cfg", "/cfg/sub/.CFG", "/cfg/sub/b.cfg.bak", "/cfg/noext", "/cfg/sub/.hidden", "/other/c.cfg" }) {
+        index.emplace(path, 0);
+    }
+
+    // "*" matches empty name, so names starting with dot are found by extension index
+    VFSPP_CHECK((Find(index, "/cfg/**/*.cfg") == std::vector<std::string>{ "/cfg/.cfg", "/cfg/a.cfg" }));
+    VFSPP_CHECK((Find(index, "/cfg/**/.cfg") == std::vector<std::string>{ "/cfg/.cfg" }));
+    VFSPP_CHECK((Find(index, "/**/*.hidden") == std::vector<std::string>{ "/cfg/sub/.hidden" }));
+    VFSPP_CHECK((Find(index, "/cfg/**/*.bak") == std::vector<std::string>{ "/cfg/sub/b.cfg.bak" }));
+    VFSPP_CHECK(Find(index, "/cfg/**/*").size() == 6);
+
+    // Indices are kept up to date after first query
+    index.emplace("/cfg/sub/x/.cfg", 0);
+    index.erase("/cfg/.cfg");
+    VFSPP_CHECK((Find(index, "/cfg/**/*.cfg") == std::vector<std::string>{ "/cfg/a.cfg", "/cfg/sub/x/.cfg" }));
+
+    VFSPP_CHECK(index.SetCaseSensitive(false));
+    VFSPP_CHECK(Find(index, "/**/*.cfg").size() == 4);
+}
+
+} // namespace
+
+int main()
+{
+    TestExtensionQueries();
+    return 0;
+}
@@ -0,0 +1,122 @@
+#include "vfspp/VFS.h"
+#include "TestCheck.h"
+
+#include <random>
+
+using namespace vfspp;
+
+namespace
+{
+
+// Component by component reference of PathNormalizer, vectorized block scan of
+// normalizer has to give same results
+std::optional<std::string> ReferenceNormalize(std::string_view path, bool foldCase)
+{
+    if (path.find('\0') != std::string_view::npos) {
+        return std::nullopt;
+    }
+
+    std::vector<std::string> components;
+    bool isDirectory = false;
+    size_t start = 0;
+    while (start <= path.size()) {
+        const size_t end = std::min(path.find_first_of("/\\", start), path.size());
+        std::string component(path.substr(start, end - start));
+        const bool hasSeparator = end < path.size();
+        start = end + 1;
+
+        if (component.empty()) {
+            continue;
+        }
+
+        if (component == "..") {
+            if (components.empty()) {
+                return std::nullopt;
+            }
+            components.pop_back();
+            isDirectory = true;
+        } else if (component == ".") {
+            isDirectory = true;
+        } else {
+            if (foldCase) {
+                for (char& c : component) {
+                    c = PathNormalizer::FoldCase(c);
+                }
+            }
+            components.push_back(std::move(component));
+            isDirectory = hasSeparator;
+        }
+    }
+
+    std::string normalized = "/";
+    for (size_t i = 0; i < components.size(); i++) {
+        normalized += components[i];
+        if (i + 1 < components.size() || isDirectory) {
+            normalized += '/';
+        }
+    }
+    return normalized;
+}
+
+void CheckPath(std::string_view path)
+{
+    for (const bool foldCase : { false, true }) {
+        const auto expected = ReferenceNormalize(path, foldCase);
+        const auto normalized = PathNormalizer::Normalize(path, foldCase);
+        if (normalized != expected) {
+            std::fprintf(stderr, "path \"%s\" fold %d: got \"%s\", expected \"%s\"\n", std::string(path).c_str(), foldCase,
+                normalized ? normalized->c_str() : "<invalid>", expected ? expected->c_str() : "<invalid>");
+        }
+        VFSPP_CHECK(normalized == expected);
+        VFSPP_CHECK(PathNormalizer::IsNormalized(path, foldCase) == (expected && *expected == path));
+    }
+}
+
+void TestKnownPaths()
+{
+    VFSPP_CHECK(PathNormalizer::Normalize("") == "/");
+    VFSPP_CHECK(PathNormalizer::Normalize("a\\b//c/") == "/a/b/c/");
+    VFSPP_CHECK(PathNormalizer::Normalize("/a/./b/../c") == "/a/c");
+    VFSPP_CHECK(PathNormalizer::Normalize("/a/b/..") == "/a/");
+    VFSPP_CHECK(PathNormalizer::Normalize("/Data/File.TXT", true) == "/data/file.txt");
+    VFSPP_CHECK(!PathNormalizer::Normalize("/a/../.."));
+    VFSPP_CHECK(!PathNormalizer::Normalize(std::string_view("/a\0b", 4)));
+
+    // Special characters at every position around vector block boundaries
+    const std::string name(80, 'x');
+    for (size_t offset = 1; offset < 72; offset++) {
+        for (const char* insert : { "/", "//", "\\", "/.", "/./", "/..", "/../", "/...", "/.x", "X" }) {
+            std::string path = "/" + name;
+            path.insert(offset, insert);
+            CheckPath(path);
+            CheckPath(path.substr(0, offset + 3));
+        }
+    }
+}
+
+void TestRandomPaths()
+{
+    // Alphabet is biased to separators and dots, so short components are common
+    constexpr std::string_view kAlphabet = "/\\..aaBBzZ_\xC3";
+    std::mt19937 random(67);
+    for (int iteration = 0; iteration < 200000; iteration++) {
+        const size_t length = random() % 100;
+        std::string path(length, '\0');
+        for (char& c : path) {
+            c = kAlphabet[random() % kAlphabet.size()];
+        }
+        if (length > 0 && random() % 64 == 0) {
+            path[random() % length] = '\0';
+        }
+        CheckPath(path);
+    }
+}
+
+} // namespace
+
+int main()
+{
+    TestKnownPaths();
+    TestRandomPaths();
+    return 0;
+}
@@ -0,0 +1,276 @@
+#include "vfspp/VFS.h"
+#include "vfspp/TarFileSystem.hpp"
+#include "TestCheck.h"
+
+#include <fstream>
+
+using namespace vfspp;
+
+namespace
+{
+
+constexpr size_t kBlockSize = 512;
+constexpr const char* kArchivePath = "tar_test.tar";
+
+using Header = std::array<uint8_t, kBlockSize>;
+
+void PutString(Header& header, size_t offset, std::string_view value)
+{
+    std::memcpy(header.data() + offset, value.data(), value.size());
+}
+
+void PutOctal(Header& header, size_t offset, size_t size, uint64_t value)
+{
+    std::string digits(size - 1, '0');
+    for (size_t i = digits.size(); i-- > 0 && value != 0; value >>= 3) {
+        digits[i] = static_cast<char>('0' + (value & 7));
+    }
+    PutString(header, offset, digits);
+}
+
+void UpdateChecksum(Header& header)
+{
+    std::memset(header.data() + 148, ' ', 8);
+    uint64_t sum = 0;
+    for (const uint8_t value : header) {
+        sum += value;
+    }
+    PutOctal(header, 148, 7, sum);
+}
+
+Header MakeHeader(std::string_view name, uint64_t size, char type = '0')
+{
+    Header header{};
+    PutString(header, 0, name);
+    PutOctal(header, 100, 8, 0644);
+    PutOctal(header, 124, 12, size);
+    PutOctal(header, 136, 12, 1700000000);
+    header[156] = static_cast<uint8_t>(type);
+    PutString(header, 257, std::string_view("ustar\0" "00", 8));
+    UpdateChecksum(header);
+    return header;
+}
+
+void AppendEntry(std::vector<uint8_t>& archive, const Header& header, std::string_view data)
+{
+    archive.insert(archive.end(), header.begin(), header.end());
+    archive.insert(archive.end(), data.begin(), data.end());
+    archive.resize((archive.size() + kBlockSize - 1) / kBlockSize * kBlockSize, 0);
+}
+
+void AppendEntry(std::vector<uint8_t>& archive, std::string_view name, std::string_view data)
+{
+    AppendEntry(archive, MakeHeader(name, data.size()), data);
+}
+
+void AppendEndMarker(std::vector<uint8_t>& archive)
+{
+    archive.resize(archive.size() + 2 * kBlockSize, 0);
+}
+
+std::vector<uint8_t> ValidArchive()
+{
+    std::vector<uint8_t> archive;
+    AppendEntry(archive, "a.txt", "first file");
+    AppendEntry(archive, "dir/b.txt", std::string(3000, 'b'));
+    AppendEndMarker(archive);
+    return archive;
+}
+
+void Save(const std::string& path, std::span<const uint8_t> data)
+{
+    std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+    stream.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+}
+
+bool CanMount(std::span<const uint8_t> archive, const std::string& path = kArchivePath)
+{
+    Save(path, archive);
+    TarFileSystem filesystem("/", path);
+    return filesystem.Initialize();
+}
+
+void CheckContent(TarFileSystem& filesystem)
+{
+    const auto a = filesystem.ReadAll("/a.txt");
+    VFSPP_CHECK(a && std::string_view(reinterpret_cast<const char*>(a->Data().data()), a->Size()) == "first file");
+    const auto b = filesystem.ReadAll("/dir/b.txt");
+    VFSPP_CHECK(b && b->Size() == 3000 && b->Data()[2999] == 'b');
+}
+
+void TestValidArchive()
+{
+    const auto archive = ValidArchive();
+    Save(kArchivePath, archive);
+    TarFileSystem filesystem("/", kArchivePath);
+    VFSPP_CHECK(filesystem.Initialize());
+    CheckContent(filesystem);
+
+    // End of archive marker is optional
+    auto withoutMarker = archive;
+    withoutMarker.resize(archive.size() - 2 * kBlockSize);
+    VFSPP_CHECK(CanMount(withoutMarker));
+}
+
+void TestMalformedHeaders()
+{
+    const auto archive = ValidArchive();
+
+    // Damaged header fails checksum
+    auto damaged = archive;
+    damaged[kBlockSize * 2 + 1] ^= 0x20;
+    VFSPP_CHECK(!CanMount(damaged));
+
+    // Archive cut inside entry data or inside header
+    auto truncated = archive;
+    truncated.resize(kBlockSize * 3);
+    VFSPP_CHECK(!CanMount(truncated));
+    truncated.resize(kBlockSize * 2 + 100);
+    VFSPP_CHECK(!CanMount(truncated));
+
+    // Size beyond end of archive, in octal and in GNU base-256 form
+    std::vector<uint8_t> oversized;
+    AppendEntry(oversized, MakeHeader("big.bin", 1 << 20), "data");
+    AppendEndMarker(oversized);
+    VFSPP_CHECK(!CanMount(oversized));
+
+    Header binarySize = MakeHeader("big.bin", 0);
+    std::memset(binarySize.data() + 124, 0xFF, 12);
+    binarySize[124] = 0x80;
+    UpdateChecksum(binarySize);
+    std::vector<uint8_t> binary;
+    AppendEntry(binary, binarySize, "");
+    AppendEndMarker(binary);
+    VFSPP_CHECK(!CanMount(binary));
+
+    // Pax records with bad length or size larger than archive
+    for (const std::string_view records : { std::string_view("99 path=x\n"), std::string_view("x path=x\n"), std::string_view("12 size=99999\n") }) {
+        std::vector<uint8_t> pax;
+        AppendEntry(pax, MakeHeader("pax", records.size(), 'x'), records);
+        AppendEntry(pax, "a.txt", "first file");
+        AppendEndMarker(pax);
+        VFSPP_CHECK(!CanMount(pax));
+    }
+
+    // Hard link to missing target is skipped
+    std::vector<uint8_t> link;
+    AppendEntry(link, "a.txt", "first file");
+    Header linkHeader = MakeHeader("link.txt", 0, '1');
+    PutString(linkHeader, 157, "missing.txt");
+    UpdateChecksum(linkHeader);
+    AppendEntry(link, linkHeader, "");
+    AppendEndMarker(link);
+    Save(kArchivePath, link);
+    TarFileSystem filesystem("/", kArchivePath);
+    VFSPP_CHECK(filesystem.Initialize());
+    VFSPP_CHECK(filesystem.IsFileExists("/a.txt") && !filesystem.IsFileExists("/link.txt"));
+}
+
+#if defined(VFSPP_ZSTD_SUPPORT_ENABLED)
+constexpr const char* kCompressedPath = "tar_test.tar.zst";
+constexpr size_t kFrameSize = 1024;
+
+void PutLE32(std::vector<uint8_t>& out, uint32_t value)
+{
+    for (int i = 0; i < 4; i++) {
+        out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+    }
+}
+
+uint32_t ReadLE32(const std::vector<uint8_t>& data, size_t offset)
+{
+    uint32_t value = 0;
+    for (int i = 3; i >= 0; i--) {
+        value = (value << 8) | data[offset + i];
+    }
+    return value;
+}
+
+void WriteLE32(std::vector<uint8_t>& out, size_t offset, uint32_t value)
+{
+    for (int i = 0; i < 4; i++) {
+        out[offset + i] = static_cast<uint8_t>(value >> (8 * i));
+    }
+}
+
+// Independently compressed frames followed by seek table without checksums
+std::vector<uint8_t> Seekable(std::span<const uint8_t> data, uint32_t& outFrameCount)
+{
+    std::vector<uint8_t> out;
+    std::vector<uint8_t> table;
+    outFrameCount = 0;
+    for (size_t offset = 0; offset < data.size(); offset += kFrameSize) {
+        const size_t size = std::min(kFrameSize, data.size() - offset);
+        std::vector<uint8_t> frame(ZSTD_compressBound(size));
+        frame.resize(ZSTD_compress(frame.data(), frame.size(), data.data() + offset, size, 3));
+        out.insert(out.end(), frame.begin(), frame.end());
+        PutLE32(table, static_cast<uint32_t>(frame.size()));
+        PutLE32(table, static_cast<uint32_t>(size));
+        outFrameCount++;
+    }
+
+    PutLE32(out, ZstdBlob::kSkippableFrameMagic);
+    PutLE32(out, static_cast<uint32_t>(table.size() + 9));
+    out.insert(out.end(), table.begin(), table.end());
+    PutLE32(out, outFrameCount);
+    out.push_back(0);
+    PutLE32(out, ZstdBlob::kSeekTableMagic);
+    return out;
+}
+
+void TestCorruptSeekTable()
+{
+    const auto archive = ValidArchive();
+    uint32_t frameCount = 0;
+    const auto seekable = Seekable(archive, frameCount);
+    const size_t tableEntries = seekable.size() - 9 - frameCount * 8;
+
+    {
+        Save(kCompressedPath, seekable);
+        TarFileSystem filesystem("/", kCompressedPath);
+        VFSPP_CHECK(filesystem.Initialize());
+        CheckContent(filesystem);
+    }
+
+    // Table that doesn't describe blob is ignored and whole blob is decompressed
+    auto reserved = seekable;
+    reserved[seekable.size() - 5] |= 0x04;
+    auto count = seekable;
+    WriteLE32(count, seekable.size() - 9, frameCount + 1);
+    auto compressedSum = seekable;
+    WriteLE32(compressedSum, tableEntries, ReadLE32(seekable, tableEntries) + 1);
+    for (const auto* blob : { &reserved, &count, &compressedSum }) {
+        Save(kCompressedPath, *blob);
+        TarFileSystem filesystem("/", kCompressedPath);
+        VFSPP_CHECK(filesystem.Initialize());
+        CheckContent(filesystem);
+    }
+
+    // Table that lies about frame sizes fails on read instead of returning garbage
+    auto decompressedSize = seekable;
+    WriteLE32(decompressedSize, tableEntries + 4, 0xFFFFFF00u);
+    VFSPP_CHECK(!CanMount(decompressedSize, kCompressedPath));
+
+    auto shiftedFrames = seekable;
+    WriteLE32(shiftedFrames, tableEntries, ReadLE32(seekable, tableEntries) + 1);
+    WriteLE32(shiftedFrames, tableEntries + 8, ReadLE32(seekable, tableEntries + 8) - 1);
+    VFSPP_CHECK(!CanMount(shiftedFrames, kCompressedPath));
+
+    // Truncated blob has neither seek table nor complete frames
+    auto truncated = seekable;
+    truncated.resize(seekable.size() - 20);
+    VFSPP_CHECK(!CanMount(truncated, kCompressedPath));
+}
+#endif
+
+} // namespace
+
+int main()
+{
+    TestValidArchive();
+    TestMalformedHeaders();
+#if defined(VFSPP_ZSTD_SUPPORT_ENABLED)
+    TestCorruptSeekTable();
+#endif
+    return 0;
+}
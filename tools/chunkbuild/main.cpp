@@ -0,0 +1,109 @@
+#include "vfspp/VFS.h"
+#include "vfspp/ChunkStoreBuilder.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+
+using namespace vfspp;
+
+namespace
+{
+
+constexpr const char* kMountPath = "/pack/";
+
+void PrintUsage()
+{
+    std::printf(
+        "Usage: vfspp_chunkbuild [options] <store directory> <input>...\n"
+        "Inputs are directories or zip archives, later inputs override files of earlier ones.\n"
+        "Existing store is updated, only changed manifests and new chunks are written\n"
+        "Options:\n"
+        "  --min <bytes>         minimum chunk size (default 16384)\n"
+        "  --avg <bytes>         average chunk size, power of two (default 65536)\n"
+        "  --max <bytes>         maximum chunk size (default 262144)\n"
+        "  --prune               remove chunks not used by new version\n"
+        "  --jobs <count>        number of chunking threads (default all cores)\n");
+}
+
+uint32_t ParseSize(const char* value)
+{
+    return static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    ChunkBuildOptions options;
+    std::vector<std::string> positional;
+
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+
+        if (arg == "--min" && hasValue) {
+            options.Chunker.MinSize = ParseSize(argv[++i]);
+        } else if (arg == "--avg" && hasValue) {
+            options.Chunker.AverageSize = ParseSize(argv[++i]);
+        } else if (arg == "--max" && hasValue) {
+            options.Chunker.MaxSize = ParseSize(argv[++i]);
+        } else if (arg == "--prune") {
+            options.RemoveUnusedChunks = true;
+        } else if (arg == "--jobs" && hasValue) {
+            options.ThreadCount = ParseSize(argv[++i]);
+        } else if (arg == "--help" || arg == "-h") {
+            PrintUsage();
+            return 0;
+        } else if (arg.starts_with("--")) {
+            std::fprintf(stderr, "Unknown option %s\n", arg.c_str());
+            PrintUsage();
+            return 1;
+        } else {
+            positional.push_back(arg);
+        }
+    }
+
+    if (positional.size() < 2) {
+        PrintUsage();
+        return 1;
+    }
+
+    VirtualFileSystem vfs;
+    for (size_t i = 1; i < positional.size(); i++) {
+        const std::string& input = positional[i];
+
+        bool isMounted = false;
+        if (fs::is_directory(input)) {
+            isMounted = vfs.CreateFileSystem<NativeFileSystem>(kMountPath, input).has_value();
+        } else {
+            isMounted = vfs.CreateFileSystem<ZipFileSystem>(kMountPath, input).has_value();
+        }
+
+        if (!isMounted) {
+            std::fprintf(stderr, "Failed to mount %s\n", input.c_str());
+            return 1;
+        }
+    }
+
+    ChunkStoreBuilder builder(std::move(options));
+    if (!builder.Build(vfs, kMountPath, positional.front())) {
+        std::fprintf(stderr, "Failed to build %s\n", positional.front().c_str());
+        return 1;
+    }
+
+    const ChunkBuildStats& stats = builder.Stats();
+    std::printf("%llu files, %llu bytes in %llu chunks (%llu unique)\n",
+        static_cast<unsigned long long>(stats.FileCount),
+        static_cast<unsigned long long>(stats.TotalSize),
+        static_cast<unsigned long long>(stats.ChunkCount),
+        static_cast<unsigned long long>(stats.UniqueChunkCount));
+    std::printf("Written %llu manifests and %llu chunks of %llu bytes, removed %llu chunks\n",
+        static_cast<unsigned long long>(stats.WrittenManifestCount),
+        static_cast<unsigned long long>(stats.WrittenChunkCount),
+        static_cast<unsigned long long>(stats.WrittenSize),
+        static_cast<unsigned long long>(stats.RemovedChunkCount));
+
+    return 0;
+}
@@ -0,0 +1,107 @@
+#include "vfspp/VFS.h"
+#include "vfspp/ZipBuilder.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+
+using namespace vfspp;
+
+namespace
+{
+
+constexpr const char* kMountPath = "/pack/";
+
+void PrintUsage()
+{
+    std::printf(
+        "Usage: vfspp_zipbuild [options] <output.zip> <input>...\n"
+        "Inputs are directories or zip archives, later inputs override files of earlier ones\n"
+        "Options:\n"
+        "  --level <0-10>        compression level, 0 stores files (default 6)\n"
+        "  --store <ext>         store files with extension, e.g. --store .dds\n"
+        "  --compress <ext>      compress files with extension using default level\n"
+        "  --align <bytes>       align data of stored files up to 32768, e.g. 4096 for mmap\n"
+        "  --jobs <count>        number of compression threads (default all cores)\n");
+}
+
+std::string LowercaseExtension(std::string extension)
+{
+    if (!extension.empty() && extension.front() != '.') {
+        extension.insert(extension.begin(), '.');
+    }
+    for (auto& c : extension) {
+        c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+    return extension;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    ZipBuildOptions options;
+    std::vector<std::string> positional;
+
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+
+        if (arg == "--level" && hasValue) {
+            options.CompressionLevel = std::atoi(argv[++i]);
+        } else if (arg == "--store" && hasValue) {
+            options.ExtensionLevels[LowercaseExtension(argv[++i])] = 0;
+        } else if (arg == "--compress" && hasValue) {
+            options.ExtensionLevels.erase(LowercaseExtension(argv[++i]));
+        } else if (arg == "--align" && hasValue) {
+            options.StoredAlignment = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--jobs" && hasValue) {
+            options.ThreadCount = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--help" || arg == "-h") {
+            PrintUsage();
+            return 0;
+        } else if (arg.starts_with("--")) {
+            std::fprintf(stderr, "Unknown option %s\n", arg.c_str());
+            PrintUsage();
+            return 1;
+        } else {
+            positional.push_back(arg);
+        }
+    }
+
+    if (positional.size() < 2) {
+        PrintUsage();
+        return 1;
+    }
+
+    if (options.StoredAlignment > ZipWriter::kMaxAlignment) {
+        std::fprintf(stderr, "Alignment can't exceed %u bytes\n", ZipWriter::kMaxAlignment);
+        return 1;
+    }
+
+    VirtualFileSystem vfs;
+    for (size_t i = 1; i < positional.size(); i++) {
+        const std::string& input = positional[i];
+
+        bool isMounted = false;
+        if (fs::is_directory(input)) {
+            isMounted = vfs.CreateFileSystem<NativeFileSystem>(kMountPath, input).has_value();
+        } else {
+            isMounted = vfs.CreateFileSystem<ZipFileSystem>(kMountPath, input).has_value();
+        }
+
+        if (!isMounted) {
+            std::fprintf(stderr, "Failed to mount %s\n", input.c_str());
+            return 1;
+        }
+    }
+
+    ZipBuilder builder(std::move(options));
+    if (!builder.Build(vfs, kMountPath, positional.front())) {
+        std::fprintf(stderr, "Failed to build %s\n", positional.front().c_str());
+        return 1;
+    }
+
+    return 0;
+}